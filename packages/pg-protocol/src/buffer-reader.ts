@@ -1,12 +1,16 @@
+import { decodeUtf8, decodeUtf8Fields } from './string-utils'
+
 const emptyBuffer = new ArrayBuffer(0)
 
 export class BufferReader {
   #bufferView: DataView = new DataView(emptyBuffer)
+  #bytes = new Uint8Array(emptyBuffer)
+  // TextDecoder rejects views of shared memory, so strings are copied out
+  #shared = false
   #offset: number
+  // (offset, length) pairs for strings(), reused from row to row
+  #columns = new Int32Array(64)
 
-  // TODO(bmc): support non-utf8 encoding?
-  readonly #encoding: string = 'utf-8' as const
-  readonly #decoder = new TextDecoder(this.#encoding)
   readonly #littleEndian: boolean = false as const
 
   constructor(offset: number = 0) {
@@ -15,7 +19,13 @@ export class BufferReader {
 
   public setBuffer(offset: number, buffer: ArrayBuffer): void {
     this.#offset = offset
-    this.#bufferView = new DataView(buffer)
+    if (buffer !== this.#bufferView.buffer) {
+      this.#bufferView = new DataView(buffer)
+      this.#bytes = new Uint8Array(buffer)
+      this.#shared =
+        typeof SharedArrayBuffer !== 'undefined' &&
+        (buffer as ArrayBufferLike) instanceof SharedArrayBuffer
+    }
   }
 
   public int16(): number {
@@ -40,15 +50,36 @@ export class BufferReader {
   }
 
   public string(length: number): string {
-    // const result = this.#bufferView.toString(
-    //   this.#encoding,
-    //   this.#offset,
-    //   this.#offset + length,
-    // )
-    // this.#offset += length
+    const start = this.#offset
+    this.#offset += length
+    return this.#shared
+      ? decodeUtf8(this.#bytes.slice(start, this.#offset), 0, length)
+      : decodeUtf8(this.#bytes, start, this.#offset)
+  }
 
-    const result = this.#decoder.decode(this.bytes(length))
-    return result
+  /**
+   * Read `count` strings, each after its int32 length, with length -1 for
+   * NULL: the fields of a dataRow
+   */
+  public strings(count: number): (string | null)[] {
+    if (this.#shared) {
+      const fields: (string | null)[] = new Array(count)
+      for (let i = 0; i < count; i++) {
+        const length = this.int32()
+        fields[i] = length === -1 ? null : this.string(length)
+      }
+      return fields
+    }
+    if (count * 2 > this.#columns.length) {
+      this.#columns = new Int32Array(count * 2)
+    }
+    for (let i = 0; i < count; i++) {
+      const length = this.int32()
+      this.#columns[i * 2] = this.#offset
+      this.#columns[i * 2 + 1] = length
+      if (length !== -1) this.#offset += length
+    }
+    return decodeUtf8Fields(this.#bytes, this.#columns, 0, count)
   }
 
   public cstring(): string {
@@ -57,12 +88,12 @@ export class BufferReader {
     // while (this.#bufferView[end++] !== 0) {}
 
     const start = this.#offset
-    let end = start
-    while (this.#bufferView.getUint8(end++) !== 0) {
-      // no-op - increment until terminator reached
+    const end = this.#bytes.indexOf(0, start)
+    if (end === -1) {
+      throw new RangeError('Unterminated string')
     }
-    const result = this.string(end - start - 1)
-    this.#offset = end
+    const result = this.string(end - start)
+    this.#offset = end + 1
     return result
   }
 
@@ -1,29 +1,43 @@
 import { byteLengthUtf8 } from './string-utils'
 
+// A writer keeps its buffer between messages unless it grew past this
+const MAX_RETAINED_SIZE = 64 * 1024
+
+// Past this length TextEncoder is faster, even for ASCII
+const SHORT_STRING_LENGTH = 32
+
 export class Writer {
   #bufferView: DataView
+  #bytes: Uint8Array
   #offset: number = 5
 
   readonly #littleEndian = false as const
   readonly #encoder = new TextEncoder()
-  readonly #headerPosition: number = 0
+  #headerPosition: number = 0
   constructor(private size = 256) {
     this.#bufferView = this.#allocateBuffer(size)
+    this.#bytes = new Uint8Array(this.#bufferView.buffer)
   }
 
   #allocateBuffer(size: number): DataView {
     return new DataView(new ArrayBuffer(size))
   }
 
+  #setBuffer(bufferView: DataView): void {
+    this.#bufferView = bufferView
+    this.#bytes = new Uint8Array(bufferView.buffer)
+  }
+
   #ensure(size: number): void {
     const remaining = this.#bufferView.byteLength - this.#offset
     if (remaining < size) {
       const oldBuffer = this.#bufferView.buffer
       // exponential growth factor of around ~ 1.5
       // https://stackoverflow.com/questions/2269063/buffer-growth-strategy
+      const oldBytes = this.#bytes
       const newSize = oldBuffer.byteLength + (oldBuffer.byteLength >> 1) + size
-      this.#bufferView = this.#allocateBuffer(newSize)
-      new Uint8Array(this.#bufferView.buffer).set(new Uint8Array(oldBuffer))
+      this.#setBuffer(this.#allocateBuffer(newSize))
+      this.#bytes.set(oldBytes)
     }
   }
 
@@ -58,18 +72,31 @@ export class Writer {
   public addString(string: string = ''): Writer {
     const length = byteLengthUtf8(string)
     this.#ensure(length)
-    this.#encoder.encodeInto(
-      string,
-      new Uint8Array(this.#bufferView.buffer, this.#offset),
-    )
+    if (length === string.length && length <= SHORT_STRING_LENGTH) {
+      // All ASCII: copy it over without the view and result object that
+      // encodeInto needs
+      const bytes = this.#bytes
+      const offset = this.#offset
+      for (let i = 0; i < length; i++) {
+        bytes[offset + i] = string.charCodeAt(i)
+      }
+    } else {
+      this.#encoder.encodeInto(string, this.#bytes.subarray(this.#offset))
+    }
     this.#offset += length
     return this
   }
 
-  public add(otherBuffer: ArrayBuffer): Writer {
+  public add(otherBuffer: ArrayBuffer | ArrayBufferView): Writer {
     this.#ensure(otherBuffer.byteLength)
-    new Uint8Array(this.#bufferView.buffer).set(
-      new Uint8Array(otherBuffer),
+    this.#bytes.set(
+      ArrayBuffer.isView(otherBuffer)
+        ? new Uint8Array(
+            otherBuffer.buffer,
+            otherBuffer.byteOffset,
+            otherBuffer.byteLength,
+          )
+        : new Uint8Array(otherBuffer),
       this.#offset,
     )
 
@@ -79,22 +106,68 @@ export class Writer {
 
   #join(code?: number): ArrayBuffer {
     if (code) {
-      this.#bufferView.setUint8(this.#headerPosition, code)
-      // length is everything in this packet minus the code
-      const length = this.#offset - (this.#headerPosition + 1)
-      this.#bufferView.setInt32(
-        this.#headerPosition + 1,
-        length,
-        this.#littleEndian,
-      )
+      this.#writeHeader(code)
     }
     return this.#bufferView.buffer.slice(code ? 0 : 5, this.#offset) as ArrayBuffer
   }
 
+  #writeHeader(code: number): void {
+    this.#bufferView.setUint8(this.#headerPosition, code)
+    // length is everything in this packet minus the code
+    const length = this.#offset - (this.#headerPosition + 1)
+    this.#bufferView.setInt32(
+      this.#headerPosition + 1,
+      length,
+      this.#littleEndian,
+    )
+  }
+
+  #reset(): void {
+    this.#offset = 5
+    this.#headerPosition = 0
+    if (this.#bufferView.byteLength > MAX_RETAINED_SIZE) {
+      this.#setBuffer(this.#allocateBuffer(this.size))
+    }
+  }
+
   public flush(code?: number): Uint8Array {
     const result = this.#join(code)
-    this.#offset = 5
-    this.#bufferView = this.#allocateBuffer(this.size)
+    this.#reset()
     return new Uint8Array(result)
   }
+
+  /**
+   * Finish the current message and start the next one right after it, so
+   * that several messages build up in one buffer
+   */
+  public endMessage(code: number): Writer {
+    this.#writeHeader(code)
+    this.#ensure(5)
+    this.#headerPosition = this.#offset
+    this.#offset += 5
+    return this
+  }
+
+  /**
+   * Every message finished with endMessage since the last flush, as a view
+   * of the writer's buffer rather than a copy. It is only valid until the
+   * writer is next written to.
+   */
+  public flushMessages(): Uint8Array {
+    const messages = this.#bytes.subarray(0, this.#headerPosition)
+    this.#reset()
+    return messages
+  }
+
+  /**
+   * The body written since the last flush, as a view of the writer's
+   * buffer; flush or reset before writing again
+   */
+  public view(): Uint8Array {
+    return this.#bytes.subarray(5, this.#offset)
+  }
+
+  public reset(): void {
+    this.#reset()
+  }
 }
@@ -1,3 +1,3 @@
-export { serialize } from './serializer'
-export { Parser } from './parser'
+export { serialize, MessageBatch } from './serializer'
+export { Parser, type ParserOptions } from './parser'
 export * as messages from './messages'
@@ -1,4 +1,5 @@
 import { Mode } from './types'
+import { decodeUtf8, decodeUtf8Fields } from './string-utils'
 
 export type MessageName =
   | 'parseComplete'
@@ -277,6 +278,87 @@ export class DataRowMessage implements BackendMessage {
   ) {
     this.fieldCount = fields.length
   }
+
+  public field(index: number): string | null {
+    return this.fields[index]
+  }
+}
+
+/**
+ * A dataRow whose fields are decoded when first read, in any order.
+ * `columns` holds an (offset, length) pair per field into `bytes`, starting
+ * at pair `first`, with length -1 for NULL. Both must stay unchanged for as
+ * long as the message is used.
+ */
+export class LazyDataRowMessage implements BackendMessage {
+  public readonly name: MessageName = 'dataRow'
+  readonly #bytes: Uint8Array
+  readonly #columns: Int32Array
+  readonly #first: number
+  #fields: (string | null)[] | undefined
+  #view: DataView | undefined
+
+  constructor(
+    public length: number,
+    public readonly fieldCount: number,
+    bytes: Uint8Array,
+    columns: Int32Array,
+    first: number,
+  ) {
+    this.#bytes = bytes
+    this.#columns = columns
+    this.#first = first
+  }
+
+  public field(index: number): string | null {
+    if (this.#fields) {
+      return this.#fields[index]
+    }
+    const pair = (this.#first + index) * 2
+    const offset = this.#columns[pair]
+    const len = this.#columns[pair + 1]
+    return len === -1 ? null : decodeUtf8(this.#bytes, offset, offset + len)
+  }
+
+  /**
+   * Read a field sent in binary format. `decode` gets a view of the row's
+   * bytes and the field's offset and length within it.
+   */
+  public binaryField<T>(
+    index: number,
+    decode: (view: DataView, offset: number, length: number) => T,
+  ): T | null {
+    const pair = (this.#first + index) * 2
+    const len = this.#columns[pair + 1]
+    if (len === -1) {
+      return null
+    }
+    this.#view ??= new DataView(
+      this.#bytes.buffer,
+      this.#bytes.byteOffset,
+      this.#bytes.byteLength,
+    )
+    return decode(this.#view, this.#columns[pair], len)
+  }
+
+  /**
+   * The bytes and index the row reads from, to rebuild it on the other side
+   * of a postMessage, which drops private fields
+   */
+  get raw(): { bytes: Uint8Array; columns: Int32Array; first: number } {
+    return { bytes: this.#bytes, columns: this.#columns, first: this.#first }
+  }
+
+  /** Every field, decoded once and kept */
+  get fields(): (string | null)[] {
+    this.#fields ??= decodeUtf8Fields(
+      this.#bytes,
+      this.#columns,
+      this.#first,
+      this.fieldCount,
+    )
+    return this.#fields
+  }
 }
 
 export class NoticeMessage implements BackendMessage, NoticeOrError {
@@ -16,6 +16,7 @@ import {
   ParameterDescriptionMessage,
   Field,
   DataRowMessage,
+  LazyDataRowMessage,
   ParameterStatusMessage,
   BackendKeyDataMessage,
   DatabaseError,
@@ -48,6 +49,20 @@ export type Packet = {
 
 const emptyBuffer = new ArrayBuffer(0)
 
+function readUint32(bytes: Uint8Array, offset: number) {
+  return (
+    ((bytes[offset] << 24) |
+      (bytes[offset + 1] << 16) |
+      (bytes[offset + 2] << 8) |
+      bytes[offset + 3]) >>>
+    0
+  )
+}
+
+// Field locations for lazy dataRows are kept in shared chunks of this many
+// (offset, length) pairs; a full chunk is left to the rows that use it
+const COLUMN_CHUNK_PAIRS = 16384
+
 const enum MessageCodes {
   DataRow = 0x44, // D
   ParseComplete = 0x31, // 1
@@ -75,11 +90,33 @@ const enum MessageCodes {
 
 export type MessageCallback = (msg: BackendMessage) => void
 
+export interface ParserOptions {
+  /**
+   * Emit every dataRow as a LazyDataRowMessage, which decodes a field only
+   * when it is read. The rows keep the bytes they were parsed from: views
+   * passed to parse() are copied as usual, and parseInPlace() copies the
+   * rows, but an ArrayBuffer passed directly must not be modified
+   * afterwards. Also settable on the parser between calls.
+   */
+  lazyDataRows?: boolean
+}
+
 export class Parser {
   #bufferView: DataView = new DataView(emptyBuffer)
   #bufferRemainingLength: number = 0
   #bufferOffset: number = 0
   #reader = new BufferReader()
+  /** See {@link ParserOptions.lazyDataRows} */
+  public lazyDataRows: boolean
+  // Lazy rows point into #bufferView's buffer, so it may not be reused
+  #bufferPinned = false
+  #bufferBytes = new Uint8Array(emptyBuffer)
+  #columns = new Int32Array(0)
+  #columnsUsed = 0
+
+  constructor(options?: ParserOptions) {
+    this.lazyDataRows = options?.lazyDataRows ?? false
+  }
 
   public parse(buffer: BufferParameter, callback: MessageCallback) {
     this.#mergeBuffer(
@@ -99,12 +136,25 @@ export class Parser {
       const length = this.#bufferView.getUint32(offset + CODE_LENGTH, false)
       const fullMessageLength = CODE_LENGTH + length
       if (fullMessageLength + offset <= bufferFullLength && length > 0) {
-        const message = this.#handlePacket(
-          offset + HEADER_LENGTH,
-          code,
-          length,
-          this.#bufferView.buffer as ArrayBuffer,
-        )
+        let message: BackendMessage
+        if (this.lazyDataRows && code === MessageCodes.DataRow) {
+          if (this.#bufferBytes.buffer !== this.#bufferView.buffer) {
+            this.#bufferBytes = new Uint8Array(this.#bufferView.buffer)
+          }
+          message = this.#parseLazyDataRow(
+            offset + HEADER_LENGTH,
+            length,
+            this.#bufferBytes,
+          )
+          this.#bufferPinned = true
+        } else {
+          message = this.#handlePacket(
+            offset + HEADER_LENGTH,
+            code,
+            length,
+            this.#bufferView.buffer as ArrayBuffer,
+          )
+        }
         callback(message)
         offset += fullMessageLength
       } else {
@@ -116,6 +166,7 @@ export class Parser {
       this.#bufferView = new DataView(emptyBuffer)
       this.#bufferRemainingLength = 0
       this.#bufferOffset = 0
+      this.#bufferPinned = false
     } else {
       // Adjust the cursors of remainingBuffer
       this.#bufferRemainingLength = bufferFullLength - offset
@@ -123,6 +174,143 @@ export class Parser {
     }
   }
 
+  /**
+   * Like parse(), but reads whole messages where they lie in `buffer`
+   * rather than copying it first. For views of memory that is overwritten
+   * once this returns, such as a WASM output arena: nothing keeps a
+   * reference to `buffer`. Lazy dataRows copy just their own bytes, each
+   * run of them in one go, and only the bytes of a partial message at
+   * either end are copied to join it up.
+   */
+  public parseInPlace(buffer: Uint8Array, callback: MessageCallback) {
+    let offset = 0
+    // Finish a message left partial by an earlier call, feeding parse() no
+    // more than it needs
+    while (this.#bufferRemainingLength > 0 && offset < buffer.byteLength) {
+      let needed = HEADER_LENGTH - this.#bufferRemainingLength
+      if (needed <= 0) {
+        needed =
+          CODE_LENGTH +
+          this.#bufferView.getUint32(this.#bufferOffset + CODE_LENGTH) -
+          this.#bufferRemainingLength
+      }
+      if (needed <= 0) {
+        // A malformed length; leave it to parse()
+        this.parse(buffer.subarray(offset), callback)
+        return
+      }
+      const end = Math.min(offset + needed, buffer.byteLength)
+      this.parse(buffer.subarray(offset, end), callback)
+      offset = end
+    }
+
+    const bytes = buffer.buffer as ArrayBuffer
+    const base = buffer.byteOffset
+    const end = buffer.byteLength
+    while (offset + HEADER_LENGTH <= end) {
+      const code = buffer[offset]
+      const length = readUint32(buffer, offset + CODE_LENGTH)
+      const fullMessageLength = CODE_LENGTH + length
+      if (fullMessageLength + offset > end || length === 0) {
+        break
+      }
+      if (this.lazyDataRows && code === MessageCodes.DataRow) {
+        let runEnd = offset + fullMessageLength
+        while (runEnd + HEADER_LENGTH <= end && buffer[runEnd] === code) {
+          const next = runEnd + CODE_LENGTH + readUint32(buffer, runEnd + 1)
+          if (next > end || next === runEnd + CODE_LENGTH) break
+          runEnd = next
+        }
+        // A plain copy even of shared memory, which TextDecoder rejects
+        const run = buffer.slice(offset, runEnd)
+        for (let at = 0; at < run.byteLength; ) {
+          const rowLength = readUint32(run, at + CODE_LENGTH)
+          callback(this.#parseLazyDataRow(at + HEADER_LENGTH, rowLength, run))
+          at += CODE_LENGTH + rowLength
+        }
+        offset = runEnd
+        continue
+      }
+      callback(
+        this.#handlePacket(base + offset + HEADER_LENGTH, code, length, bytes),
+      )
+      offset += fullMessageLength
+    }
+    if (offset < end) {
+      // Keep the start of a message that continues in the next call
+      this.parse(buffer.subarray(offset), callback)
+    }
+  }
+
+  /**
+   * Parse messages the sender has already framed. `frames` holds one
+   * (code, offset, length) triple per message: where it starts in `buffer`
+   * and its full length including the code. The messages are read where
+   * they lie, with no copy and no reassembly, so every frame must be a whole
+   * message. This is independent of the partial-message state of parse().
+   *
+   * `columns`, if given, indexes the dataRow fields: an (offset, length)
+   * pair per field, row after row, offsets relative to `buffer` and length
+   * -1 for NULL. A row too short to hold its field count has no pairs. Each
+   * indexed row becomes a LazyDataRowMessage that decodes its fields on
+   * access; the batch and the index are copied once, so `buffer` may be
+   * reused as soon as this returns. With the lazyDataRows option every
+   * dataRow is lazy, located by walking its fields when there is no index.
+   */
+  public parseFrames(
+    buffer: BufferParameter,
+    frames: ArrayLike<number>,
+    callback: MessageCallback,
+    columns?: Int32Array,
+  ) {
+    const bytes = (
+      ArrayBuffer.isView(buffer) ? buffer.buffer : buffer
+    ) as ArrayBuffer
+    const base = ArrayBuffer.isView(buffer) ? buffer.byteOffset : 0
+    const lazy = columns !== undefined || this.lazyDataRows
+    let rowBytes: Uint8Array | undefined
+    let rowColumns: Int32Array | undefined
+    let pair = 0
+    for (let i = 0; i + 2 < frames.length; i += 3) {
+      if (
+        lazy &&
+        frames[i] === MessageCodes.DataRow &&
+        frames[i + 2] >= HEADER_LENGTH + 2
+      ) {
+        if (!rowBytes) {
+          // A plain copy even of shared memory, which TextDecoder rejects
+          rowBytes = new Uint8Array(bytes, base, buffer.byteLength).slice()
+          rowColumns = columns?.slice()
+        }
+        const start = frames[i + 1] + HEADER_LENGTH
+        const length = frames[i + 2] - CODE_LENGTH
+        const fieldCount = (rowBytes[start] << 8) | rowBytes[start + 1]
+        if (rowColumns && fieldCount <= (length - LEN_LENGTH - 2) / 4) {
+          callback(
+            new LazyDataRowMessage(
+              length,
+              fieldCount,
+              rowBytes,
+              rowColumns,
+              pair,
+            ),
+          )
+          pair += fieldCount
+        } else {
+          callback(this.#parseLazyDataRow(start, length, rowBytes))
+        }
+        continue
+      }
+      const message = this.#handlePacket(
+        base + frames[i + 1] + HEADER_LENGTH,
+        frames[i],
+        frames[i + 2] - CODE_LENGTH,
+        bytes,
+      )
+      callback(message)
+    }
+  }
+
   #mergeBuffer(buffer: ArrayBuffer): void {
     if (this.#bufferRemainingLength > 0) {
       const newLength = this.#bufferRemainingLength + buffer.byteLength
@@ -131,6 +319,7 @@ export class Parser {
         // We can't concat the new buffer with the remaining one
         let newBuffer: ArrayBuffer
         if (
+          !this.#bufferPinned &&
           newLength <= this.#bufferView.byteLength &&
           this.#bufferOffset >= this.#bufferRemainingLength
         ) {
@@ -154,6 +343,7 @@ export class Parser {
         )
         this.#bufferView = new DataView(newBuffer)
         this.#bufferOffset = 0
+        this.#bufferPinned = false
       }
 
       // Concat the new buffer with the remaining one
@@ -166,6 +356,7 @@ export class Parser {
       this.#bufferView = new DataView(buffer)
       this.#bufferOffset = 0
       this.#bufferRemainingLength = buffer.byteLength
+      this.#bufferPinned = false
     }
   }
 
@@ -340,13 +531,40 @@ export class Parser {
   #parseDataRowMessage(offset: number, length: number, bytes: ArrayBuffer) {
     this.#reader.setBuffer(offset, bytes)
     const fieldCount = this.#reader.int16()
-    const fields: (string | null)[] = new Array(fieldCount)
-    for (let i = 0; i < fieldCount; i++) {
-      const len = this.#reader.int32()
-      // a -1 for length means the value of the field is null
-      fields[i] = len === -1 ? null : this.#reader.string(len)
+    return new DataRowMessage(length, this.#reader.strings(fieldCount))
+  }
+
+  /**
+   * Locate the fields of the dataRow at bytes[offset] without decoding them
+   */
+  #parseLazyDataRow(offset: number, length: number, bytes: Uint8Array) {
+    const fieldCount = (bytes[offset] << 8) | bytes[offset + 1]
+    if (this.#columnsUsed + fieldCount > this.#columns.length >> 1) {
+      // Rows already handed out keep the old chunk
+      this.#columns = new Int32Array(
+        Math.max(COLUMN_CHUNK_PAIRS, fieldCount) * 2,
+      )
+      this.#columnsUsed = 0
+    }
+    const columns = this.#columns
+    const first = this.#columnsUsed
+    this.#columnsUsed += fieldCount
+
+    let at = offset + 2
+    for (let pair = first * 2; pair < (first + fieldCount) * 2; pair += 2) {
+      const len =
+        (bytes[at] << 24) |
+        (bytes[at + 1] << 16) |
+        (bytes[at + 2] << 8) |
+        bytes[at + 3]
+      at += 4
+      columns[pair] = at
+      columns[pair + 1] = len
+      if (len > 0) {
+        at += len
+      }
     }
-    return new DataRowMessage(length, fields)
+    return new LazyDataRowMessage(length, fieldCount, bytes, columns, first)
   }
 
   #parseParameterStatusMessage(
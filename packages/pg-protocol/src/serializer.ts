@@ -78,7 +78,7 @@ type ParseOpts = {
 
 const emptyValueArray: LegalValue[] = []
 
-const parse = (query: ParseOpts): Uint8Array => {
+const writeParse = (writer: Writer, query: ParseOpts): void => {
   // expect something like this:
   // { name: 'queryName',
   //   text: 'select * from blah',
@@ -104,7 +104,10 @@ const parse = (query: ParseOpts): Uint8Array => {
     .addInt16(query.types?.length ?? 0)
 
   query.types?.forEach((type) => buffer.addInt32(type))
+}
 
+const parse = (query: ParseOpts): Uint8Array => {
+  writeParse(writer, query)
   return writer.flush(code.parse)
 }
 
@@ -113,6 +116,9 @@ type ValueMapper = (param: unknown, index: number) => LegalValue
 type BindOpts = {
   portal?: string
   binary?: boolean
+  // result format code per column (0 text, 1 binary), or a single code for
+  // every column; takes precedence over binary
+  resultFormats?: number[]
   statement?: string
   values?: LegalValue[]
   // optional map from JS value to postgres value per parameter
@@ -127,7 +133,15 @@ const enum ParamType {
   BINARY = 1,
 }
 
-const writeValues = (values: LegalValue[], valueMapper?: ValueMapper): void => {
+// no codes means every result column is text
+const textResultFormats: number[] = []
+const binaryResultFormats: number[] = [ParamType.BINARY]
+
+const writeValues = (
+  writer: Writer,
+  values: LegalValue[],
+  valueMapper?: ValueMapper,
+): void => {
   for (let i = 0; i < values.length; i++) {
     const mappedVal = valueMapper ? valueMapper(values[i], i) : values[i]
     if (mappedVal === null) {
@@ -139,17 +153,11 @@ const writeValues = (values: LegalValue[], valueMapper?: ValueMapper): void => {
       mappedVal instanceof ArrayBuffer ||
       ArrayBuffer.isView(mappedVal)
     ) {
-      const buffer = ArrayBuffer.isView(mappedVal)
-        ? (mappedVal.buffer.slice(
-            mappedVal.byteOffset,
-            mappedVal.byteOffset + mappedVal.byteLength,
-          ) as ArrayBuffer)
-        : mappedVal
       // add the param type (binary) to the writer
       writer.addInt16(ParamType.BINARY)
       // add the buffer to the param writer
-      paramWriter.addInt32(buffer.byteLength)
-      paramWriter.add(buffer)
+      paramWriter.addInt32(mappedVal.byteLength)
+      paramWriter.add(mappedVal)
     } else {
       // add the param type (string) to the writer
       writer.addInt16(ParamType.STRING)
@@ -159,7 +167,7 @@ const writeValues = (values: LegalValue[], valueMapper?: ValueMapper): void => {
   }
 }
 
-const bind = (config: BindOpts = {}): Uint8Array => {
+const writeBind = (writer: Writer, config: BindOpts): void => {
   // normalize config
   const portal = config.portal ?? ''
   const statement = config.statement ?? ''
@@ -170,13 +178,23 @@ const bind = (config: BindOpts = {}): Uint8Array => {
   writer.addCString(portal).addCString(statement)
   writer.addInt16(len)
 
-  writeValues(values, config.valueMapper)
+  writeValues(writer, values, config.valueMapper)
 
   writer.addInt16(len)
-  writer.add(paramWriter.flush().buffer as ArrayBuffer)
+  writer.add(paramWriter.view())
+  paramWriter.reset()
+
+  // result format codes
+  const resultFormats =
+    config.resultFormats ?? (binary ? binaryResultFormats : textResultFormats)
+  writer.addInt16(resultFormats.length)
+  for (let i = 0; i < resultFormats.length; i++) {
+    writer.addInt16(resultFormats[i])
+  }
+}
 
-  // format code
-  writer.addInt16(binary ? ParamType.BINARY : ParamType.STRING)
+const bind = (config: BindOpts = {}): Uint8Array => {
+  writeBind(writer, config)
   return writer.flush(code.bind)
 }
 
@@ -293,4 +311,71 @@ const serialize = {
   cancel,
 }
 
-export { serialize }
+/**
+ * Serializes a run of messages, such as a whole extended query or pipeline,
+ * into one contiguous buffer. A batch keeps its buffer from one run to the
+ * next, so keep one around rather than making one per query. What finish()
+ * returns is a view of that buffer, only valid until the batch is next used.
+ * If a message can't be written, the whole run so far is dropped.
+ */
+class MessageBatch {
+  readonly #writer = new Writer(1024)
+
+  parse(query: ParseOpts): this {
+    writeParse(this.#writer, query)
+    this.#writer.endMessage(code.parse)
+    return this
+  }
+
+  bind(config: BindOpts = {}): this {
+    try {
+      writeBind(this.#writer, config)
+    } catch (e) {
+      // Don't leave half a message for the next run
+      paramWriter.reset()
+      this.#writer.reset()
+      throw e
+    }
+    this.#writer.endMessage(code.bind)
+    return this
+  }
+
+  describe(msg: PortalOpts): this {
+    this.#writer
+      .addCString(msg.name ? msg.type + msg.name : msg.type)
+      .endMessage(code.describe)
+    return this
+  }
+
+  execute(config: ExecOpts = {}): this {
+    this.#writer
+      .addCString(config.portal ?? '')
+      .addInt32(config.rows ?? 0)
+      .endMessage(code.execute)
+    return this
+  }
+
+  close(msg: PortalOpts): this {
+    this.#writer
+      .addCString(msg.name ? msg.type + msg.name : msg.type)
+      .endMessage(code.close)
+    return this
+  }
+
+  flush(): this {
+    this.#writer.endMessage(code.flush)
+    return this
+  }
+
+  sync(): this {
+    this.#writer.endMessage(code.sync)
+    return this
+  }
+
+  /** Every message added since the last finish, back to back */
+  finish(): Uint8Array {
+    return this.#writer.flushMessages()
+  }
+}
+
+export { serialize, MessageBatch }
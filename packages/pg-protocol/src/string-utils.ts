@@ -15,4 +15,83 @@ function byteLengthUtf8(str: string): number {
   return byteLength
 }
 
-export { byteLengthUtf8 }
+// TODO(bmc): support non-utf8 encoding?
+const utf8Decoder = new TextDecoder('utf-8')
+
+// Up to this many bytes, building an ASCII string by hand is faster than the
+// call into TextDecoder
+const SHORT_STRING_BYTES = 16
+
+/**
+ * Decodes UTF-8 bytes, by hand when they're a short ASCII string
+ * @param bytes - bytes TextDecoder accepts, so not shared memory
+ * @param start - offset of the first byte
+ * @param end - offset after the last byte
+ * @returns the decoded string
+ */
+function decodeUtf8(bytes: Uint8Array, start: number, end: number): string {
+  if (end - start <= SHORT_STRING_BYTES) {
+    let result = ''
+    for (let i = start; i < end; i++) {
+      const byte = bytes[i]
+      if (byte > 0x7f) {
+        return utf8Decoder.decode(bytes.subarray(start, end))
+      }
+      result += String.fromCharCode(byte)
+    }
+    return result
+  }
+  return utf8Decoder.decode(bytes.subarray(start, end))
+}
+
+/**
+ * Decodes the text fields of a row. When more than one field is too long
+ * for the ASCII fast path, the whole run of fields, with the lengths between
+ * them, goes through TextDecoder at once and is sliced up if every field is
+ * ASCII. Otherwise each field is decoded on its own.
+ * @param bytes - bytes TextDecoder accepts, so not shared memory
+ * @param columns - an (offset, length) pair per field, length -1 for NULL
+ * @param first - the pair of the first field
+ * @param count - the number of fields
+ * @returns the decoded fields
+ */
+function decodeUtf8Fields(
+  bytes: Uint8Array,
+  columns: Int32Array,
+  first: number,
+  count: number,
+): (string | null)[] {
+  const fields: (string | null)[] = new Array(count)
+  let start = -1
+  let end = 0
+  let long = 0
+  for (let i = first * 2; i < (first + count) * 2; i += 2) {
+    if (columns[i + 1] !== -1) {
+      if (start === -1) start = columns[i]
+      end = columns[i] + columns[i + 1]
+      if (columns[i + 1] > SHORT_STRING_BYTES) long++
+    }
+  }
+
+  // Any multi-byte character decodes to fewer chars than bytes. Bytes of
+  // the lengths that aren't valid UTF-8 become one U+FFFD each and, since
+  // a field can't start with a continuation byte, never swallow its text.
+  const text = long > 1 ? utf8Decoder.decode(bytes.subarray(start, end)) : ''
+  const sliced = long > 1 && text.length === end - start
+
+  for (let i = 0; i < count; i++) {
+    const pair = (first + i) * 2
+    const offset = columns[pair]
+    const length = columns[pair + 1]
+    if (length === -1) {
+      fields[i] = null
+    } else if (sliced) {
+      fields[i] = text.slice(offset - start, offset - start + length)
+    } else {
+      fields[i] = decodeUtf8(bytes, offset, offset + length)
+    }
+  }
+  return fields
+}
+
+export { byteLengthUtf8, decodeUtf8, decodeUtf8Fields }
@@ -9,6 +9,7 @@ import {
   BackendMessage,
   CommandCompleteMessage,
   DataRowMessage,
+  LazyDataRowMessage,
   NotificationResponseMessage,
   ParameterDescriptionMessage,
   ParameterStatusMessage,
@@ -54,6 +55,12 @@ const emptyRowFieldBuf = buffers.dataRow([])
 
 const oneFieldBuf = buffers.dataRow(['test'])
 
+// The 200-byte field's length has a byte that isn't ASCII
+const asciiFields = ['1', null, 'x'.repeat(200), 'a longer text field', '']
+const asciiFieldsBuf = buffers.dataRow(asciiFields)
+const mixedFields = ['1', null, 'x'.repeat(200), 'ünï', '✓'.repeat(20)]
+const mixedFieldsBuf = buffers.dataRow(mixedFields)
+
 const expectedAuthenticationOkayMessage: BackendMessage = {
   name: 'authenticationOk',
   length: 8,
@@ -349,6 +356,24 @@ describe('PgPacketStream', () => {
         length: oneFieldBuf.byteLength - 1,
       })
     })
+
+    describe('parsing data row with ASCII fields', () => {
+      testForMessage(asciiFieldsBuf, {
+        name: 'dataRow',
+        fieldCount: 5,
+        fields: asciiFields,
+        length: asciiFieldsBuf.byteLength - 1,
+      })
+    })
+
+    describe('parsing data row with non-ASCII fields', () => {
+      testForMessage(mixedFieldsBuf, {
+        name: 'dataRow',
+        fieldCount: 5,
+        fields: mixedFields,
+        length: mixedFieldsBuf.byteLength - 1,
+      })
+    })
   })
 
   describe('notice message', () => {
@@ -640,6 +665,235 @@ describe('PgPacketStream', () => {
     })
   })
 
+  describe('framed messages', () => {
+    const dataRowBuffer = buffers.dataRow(['framed', null])
+    const readyForQueryBuffer = buffers.readyForQuery()
+    const batch = concatBuffers([
+      new Uint8Array([1, 2, 3, 4]),
+      dataRowBuffer,
+      readyForQueryBuffer,
+    ])
+    const frames = new Uint32Array([
+      0x44,
+      4,
+      dataRowBuffer.byteLength,
+      0x5a,
+      4 + dataRowBuffer.byteLength,
+      readyForQueryBuffer.byteLength,
+    ])
+
+    function verifyMessages(messages: BackendMessage[]) {
+      expect(messages).toEqual([
+        {
+          name: 'dataRow',
+          fieldCount: 2,
+          length: dataRowBuffer.byteLength - 1,
+          fields: ['framed', null],
+        },
+        { name: 'readyForQuery', length: 5, status: 'I' },
+      ])
+    }
+
+    it('parses each frame in place', () => {
+      const messages: BackendMessage[] = []
+      new Parser().parseFrames(batch, frames, (msg) => messages.push(msg))
+      verifyMessages(messages)
+    })
+
+    it('locates frames relative to the view', () => {
+      const view = new Uint8Array(batch.buffer, 4)
+      const relative = frames.map((v, i) => (i % 3 === 1 ? v - 4 : v))
+      const messages: BackendMessage[] = []
+      new Parser().parseFrames(view, relative, (msg) => messages.push(msg))
+      verifyMessages(messages)
+    })
+
+    it('decodes indexed dataRow fields on access', () => {
+      // 'framed' after the code, length, field count and its own length
+      const columns = new Int32Array([4 + 11, 6, 0, -1])
+      const copy = batch.slice()
+      const messages: BackendMessage[] = []
+      new Parser().parseFrames(
+        copy,
+        frames,
+        (msg) => messages.push(msg),
+        columns,
+      )
+      // The rows no longer need the batch or the index
+      copy.fill(0)
+      columns.fill(0)
+
+      const row = messages[0] as LazyDataRowMessage
+      expect(row).toBeInstanceOf(LazyDataRowMessage)
+      expect(row.fieldCount).toBe(2)
+      expect(row.length).toBe(dataRowBuffer.byteLength - 1)
+      expect(row.field(1)).toBe(null)
+      expect(row.field(0)).toBe('framed')
+      expect(row.fields).toEqual(['framed', null])
+      expect(messages[1]).toEqual({
+        name: 'readyForQuery',
+        length: 5,
+        status: 'I',
+      })
+    })
+
+    it('does not disturb a partial message held by parse()', () => {
+      const parser = new Parser()
+      const messages: BackendMessage[] = []
+      parser.parse(readyForQueryBuffer.slice(0, 3), (msg) => messages.push(msg))
+      parser.parseFrames(batch, frames, (msg) => messages.push(msg))
+      parser.parse(readyForQueryBuffer.slice(3), (msg) => messages.push(msg))
+      expect(messages.map((msg) => msg.name)).toEqual([
+        'dataRow',
+        'readyForQuery',
+        'readyForQuery',
+      ])
+    })
+  })
+
+  describe('lazy data rows', () => {
+    const rows: (string | null)[][] = [
+      ['1', 'first', null],
+      ['2', '', 'ünïcödé ✓'],
+      ['3', 'x'.repeat(300), null],
+      [],
+    ]
+    const rowBuffers = concatBuffers(rows.map((row) => buffers.dataRow(row)))
+
+    function parseLazy(chunkSize: number) {
+      const parser = new Parser({ lazyDataRows: true })
+      const messages: BackendMessage[] = []
+      for (let at = 0; at < rowBuffers.byteLength; at += chunkSize) {
+        parser.parse(rowBuffers.subarray(at, at + chunkSize), (msg) =>
+          messages.push(msg),
+        )
+      }
+      return messages as LazyDataRowMessage[]
+    }
+
+    it('decodes the fields the eager parser does', () => {
+      const messages = parseLazy(rowBuffers.byteLength)
+      expect(messages.map((msg) => msg.fields)).toEqual(rows)
+      for (const msg of messages) {
+        expect(msg).toBeInstanceOf(LazyDataRowMessage)
+        expect(msg.name).toBe('dataRow')
+      }
+    })
+
+    it('decodes fields in any order', () => {
+      const [, second] = parseLazy(rowBuffers.byteLength)
+      expect(second.fieldCount).toBe(3)
+      expect(second.field(2)).toBe('ünïcödé ✓')
+      expect(second.field(0)).toBe('2')
+      expect(second.field(1)).toBe('')
+    })
+
+    it('keeps earlier rows intact while later chunks arrive', () => {
+      for (const chunkSize of [1, 3, 7, 64]) {
+        const messages = parseLazy(chunkSize)
+        expect(messages.map((msg) => msg.fields)).toEqual(rows)
+      }
+    })
+
+    it('reads binary fields through a DataView', () => {
+      const binaryRow = buffers.dataRow(['x', '\x00\x00\x01\x02', null])
+      for (const chunkSize of [1, binaryRow.byteLength]) {
+        const parser = new Parser({ lazyDataRows: true })
+        const messages: LazyDataRowMessage[] = []
+        for (const chunk of [rowBuffers, binaryRow]) {
+          for (let at = 0; at < chunk.byteLength; at += chunkSize) {
+            parser.parse(chunk.subarray(at, at + chunkSize), (msg) =>
+              messages.push(msg as LazyDataRowMessage),
+            )
+          }
+        }
+        const msg = messages[messages.length - 1]
+        const read = (view: DataView, offset: number, length: number) => {
+          expect(length).toBe(4)
+          return view.getInt32(offset)
+        }
+        expect(msg.binaryField(1, read)).toBe(258)
+        expect(msg.binaryField(2, read)).toBeNull()
+      }
+    })
+
+    it('locates fields of framed rows without an index', () => {
+      const copy = concatBuffers([rowBuffers])
+      const frames: number[] = []
+      for (let at = 0, i = 0; i < rows.length; i++) {
+        const length = buffers.dataRow(rows[i]).byteLength
+        frames.push(0x44, at, length)
+        at += length
+      }
+      const messages: BackendMessage[] = []
+      new Parser({ lazyDataRows: true }).parseFrames(copy, frames, (msg) =>
+        messages.push(msg),
+      )
+      copy.fill(0)
+      expect(
+        messages.map((msg) => (msg as LazyDataRowMessage).fields),
+      ).toEqual(rows)
+    })
+  })
+
+  describe('parsing in place', () => {
+    const response = concatBuffers([
+      buffers.rowDescription([row1]),
+      buffers.dataRow(['1', 'first']),
+      buffers.dataRow(['2', null]),
+      buffers.dataRow(['3', 'ünïcödé ✓']),
+      commandCompleteBuffer,
+      readyForQueryBuffer,
+    ])
+
+    function parseInPlace(chunks: Uint8Array[], lazyDataRows: boolean) {
+      const parser = new Parser({ lazyDataRows })
+      const messages: BackendMessage[] = []
+      for (const chunk of chunks) {
+        // Hand over a reused region, as a WASM arena is
+        const arena = new Uint8Array(chunk.byteLength + 8)
+        arena.set(chunk, 4)
+        parser.parseInPlace(arena.subarray(4, 4 + chunk.byteLength), (msg) =>
+          messages.push(msg),
+        )
+        arena.fill(0)
+      }
+      return messages
+    }
+
+    it('matches parse() and keeps nothing from the buffer', async () => {
+      const expected = await parseBuffers([response])
+      for (const lazyDataRows of [false, true]) {
+        const messages = parseInPlace([response], lazyDataRows)
+        expect(
+          messages.map((msg) =>
+            msg instanceof LazyDataRowMessage
+              ? new DataRowMessage(msg.length, msg.fields)
+              : msg,
+          ),
+        ).toEqual(expected)
+      }
+    })
+
+    it('joins messages split across calls', async () => {
+      const expected = await parseBuffers([response])
+      for (const chunkSize of [1, 3, 7, 20]) {
+        const chunks: Uint8Array[] = []
+        for (let at = 0; at < response.byteLength; at += chunkSize) {
+          chunks.push(response.subarray(at, at + chunkSize))
+        }
+        for (const lazyDataRows of [false, true]) {
+          const messages = parseInPlace(chunks, lazyDataRows)
+          expect(
+            messages.map((msg) => (msg as DataRowMessage).fields ?? msg.name),
+          ).toEqual(
+            expected.map((msg) => (msg as DataRowMessage).fields ?? msg.name),
+          )
+        }
+      }
+    })
+  })
+
   describe('buffer view handling', () => {
     it('should only read buffer section specified by view', async () => {
       const originalMessageBufferView = buffers.dataRow(['bang'])
@@ -1,5 +1,5 @@
 import { describe, it, expect } from 'vitest'
-import { serialize } from '../src/serializer'
+import { serialize, MessageBatch } from '../src/serializer'
 import BufferList from './testing/buffer-list'
 
 describe('serializer', () => {
@@ -140,6 +140,55 @@ describe('serializer', () => {
         .join(true, 'B')
       expect(actual).toEqual(expectedBuffer)
     })
+
+    it('with non-ASCII text and a view of a larger buffer', () => {
+      const backing = new Uint8Array([9, 9, 1, 2, 3, 9])
+      const actual = serialize.bind({
+        values: ['ünï', backing.subarray(2, 5)],
+      })
+      const expectedBuffer = new BufferList()
+        .addCString('')
+        .addCString('')
+        .addInt16(2)
+        .addInt16(0)
+        .addInt16(1)
+        .addInt16(2)
+        .addInt32(5)
+        .add(new TextEncoder().encode('ünï'))
+        .addInt32(3)
+        .add(new Uint8Array([1, 2, 3]))
+        .addInt16(0)
+        .join(true, 'B')
+      expect(actual).toEqual(expectedBuffer)
+    })
+
+    it('with binary results', () => {
+      const actual = serialize.bind({ binary: true })
+      const expectedBuffer = new BufferList()
+        .addCString('')
+        .addCString('')
+        .addInt16(0)
+        .addInt16(0)
+        .addInt16(1) // result format count
+        .addInt16(1) // binary
+        .join(true, 'B')
+      expect(actual).toEqual(expectedBuffer)
+    })
+
+    it('with a result format per column', () => {
+      const actual = serialize.bind({ resultFormats: [0, 1, 1] })
+      const expectedBuffer = new BufferList()
+        .addCString('')
+        .addCString('')
+        .addInt16(0)
+        .addInt16(0)
+        .addInt16(3) // result format count
+        .addInt16(0) // text
+        .addInt16(1) // binary
+        .addInt16(1) // binary
+        .join(true, 'B')
+      expect(actual).toEqual(expectedBuffer)
+    })
   })
 
   it('with custom valueMapper', () => {
@@ -297,6 +346,97 @@ describe('serializer', () => {
     })
   })
 
+  it('does not reuse the bytes of earlier messages', () => {
+    const first = serialize.query('select 1')
+    serialize.query('select 2')
+    expect(first).toEqual(
+      new BufferList().addCString('select 1').join(true, 'Q'),
+    )
+  })
+
+  describe('message batch', () => {
+    const concat = (...messages: Uint8Array[]) => {
+      const bytes = new Uint8Array(
+        messages.reduce((total, msg) => total + msg.byteLength, 0),
+      )
+      let offset = 0
+      for (const msg of messages) {
+        bytes.set(msg, offset)
+        offset += msg.byteLength
+      }
+      return bytes
+    }
+
+    it('writes messages back to back', () => {
+      const bindOpts = {
+        values: ['1', null, new Uint8Array([1, 2, 3])],
+        resultFormats: [1],
+      }
+      const actual = new MessageBatch()
+        .parse({ text: 'select $1, $2, $3', types: [23] })
+        .describe({ type: 'S' })
+        .bind(bindOpts)
+        .describe({ type: 'P' })
+        .execute()
+        .execute({ portal: 'cursor', rows: 100 })
+        .close({ type: 'P', name: 'cursor' })
+        .flush()
+        .sync()
+        .finish()
+      const expected = concat(
+        serialize.parse({ text: 'select $1, $2, $3', types: [23] }),
+        serialize.describe({ type: 'S' }),
+        serialize.bind(bindOpts),
+        serialize.describe({ type: 'P' }),
+        serialize.execute(),
+        serialize.execute({ portal: 'cursor', rows: 100 }),
+        serialize.close({ type: 'P', name: 'cursor' }),
+        serialize.flush(),
+        serialize.sync(),
+      )
+      expect(actual).toEqual(expected)
+    })
+
+    it('starts over after finish, in the same buffer', () => {
+      const batch = new MessageBatch()
+      const first = batch.parse({ text: 'select 1' }).sync().finish()
+      const second = batch.execute().sync().finish()
+      expect(second).toEqual(concat(serialize.execute(), serialize.sync()))
+      expect(second.buffer).toBe(first.buffer)
+    })
+
+    it('drops the whole run when a value cannot be written', () => {
+      const batch = new MessageBatch().parse({ text: 'select $1' })
+      expect(() =>
+        batch.bind({
+          values: ['ok'],
+          valueMapper: () => {
+            throw new Error('bad value')
+          },
+        }),
+      ).toThrow('bad value')
+      expect(batch.sync().finish()).toEqual(serialize.sync())
+      expect(serialize.bind()).toEqual(
+        new BufferList()
+          .addCString('')
+          .addCString('')
+          .addInt16(0)
+          .addInt16(0)
+          .addInt16(0)
+          .join(true, 'B'),
+      )
+    })
+
+    it('grows for large messages', () => {
+      const batch = new MessageBatch()
+      const text = 'x'.repeat(100_000)
+      expect(batch.parse({ text }).sync().finish()).toEqual(
+        concat(serialize.parse({ text }), serialize.sync()),
+      )
+      expect(batch.sync().finish()).toEqual(serialize.sync())
+    })
+  })
+
   it('builds cancel message', () => {
     const actual = serialize.cancel(3, 4)
     const expected = new BufferList()
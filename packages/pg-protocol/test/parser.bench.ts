@@ -0,0 +1,74 @@
+import { bench, describe } from 'vitest'
+import buffers from './testing/test-buffers'
+import { Parser } from '../src'
+import { BackendMessage, DataRowMessage } from '../src/messages'
+
+// Run with `pnpm bench`. One response of 10k five-column rows, roughly
+// what a paging UI fetches before rendering the first screen.
+const ROWS = 10_000
+const PAGE = 50
+
+function makeResponse(): Uint8Array {
+  const rows: Uint8Array[] = []
+  for (let i = 0; i < ROWS; i++) {
+    rows.push(
+      buffers.dataRow([
+        String(i),
+        `user ${i}`,
+        `user${i}@example.com`,
+        i % 3 === 0 ? null : '2024-01-01 12:00:00+00',
+        'a somewhat longer free-text column that most views never show',
+      ]),
+    )
+  }
+  const response = new Uint8Array(
+    rows.reduce((total, row) => total + row.byteLength, 0),
+  )
+  let offset = 0
+  for (const row of rows) {
+    response.set(row, offset)
+    offset += row.byteLength
+  }
+  return response
+}
+
+const response = makeResponse()
+
+function parseRows(lazyDataRows: boolean): DataRowMessage[] {
+  const rows: BackendMessage[] = []
+  new Parser({ lazyDataRows }).parse(response, (msg) => rows.push(msg))
+  return rows as DataRowMessage[]
+}
+
+describe(`parse ${ROWS} dataRows`, () => {
+  bench('eager', () => {
+    parseRows(false)
+  })
+  bench('lazy', () => {
+    parseRows(true)
+  })
+})
+
+describe(`parse ${ROWS} dataRows, read ${PAGE}`, () => {
+  for (const lazyDataRows of [false, true]) {
+    bench(lazyDataRows ? 'lazy' : 'eager', () => {
+      const rows = parseRows(lazyDataRows)
+      for (let i = 0; i < PAGE; i++) {
+        rows[i].field(0)
+        rows[i].field(1)
+      }
+    })
+  }
+})
+
+describe(`parse ${ROWS} dataRows, read every field`, () => {
+  for (const lazyDataRows of [false, true]) {
+    bench(lazyDataRows ? 'lazy' : 'eager', () => {
+      for (const row of parseRows(lazyDataRows)) {
+        for (let i = 0; i < row.fieldCount; i++) {
+          row.field(i)
+        }
+      }
+    })
+  }
+})
@@ -0,0 +1,23 @@
+import { bench, describe } from 'vitest'
+import { serialize, MessageBatch } from '../src'
+
+// Run with `pnpm bench`. The messages of one parameterized extended query,
+// as PGlite sends them for every query().
+const text = 'SELECT * FROM users WHERE id = $1 AND email = $2'
+const values = ['42', 'someone@example.com']
+const batch = new MessageBatch()
+
+describe('serialize an extended query', () => {
+  bench('message by message', () => {
+    serialize.parse({ text })
+    serialize.describe({ type: 'S' })
+    serialize.bind({ values })
+    serialize.describe({ type: 'P' })
+    serialize.execute()
+    serialize.sync()
+  })
+  bench('batch', () => {
+    batch.parse({ text }).describe({ type: 'S' }).finish()
+    batch.bind({ values }).describe({ type: 'P' }).execute().sync().finish()
+  })
+})
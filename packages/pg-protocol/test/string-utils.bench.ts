@@ -0,0 +1,87 @@
+import { bench, describe } from 'vitest'
+import buffers from './testing/test-buffers'
+import { decodeUtf8, decodeUtf8Fields } from '../src/string-utils'
+
+// Run with `pnpm bench`. Decodes the text fields of 1k dataRows of a few
+// common shapes, field by field with TextDecoder as the parser used to, with
+// the short ASCII fast path, and as a whole row.
+const ROWS = 1_000
+
+const shapes: Record<string, (i: number) => (string | null)[]> = {
+  'ids and flags': (i) => [String(i), String(i * 7), i % 2 ? 't' : 'f', null],
+  users: (i) => [
+    String(i),
+    `user ${i}`,
+    `user${i}@example.com`,
+    i % 3 === 0 ? null : '2024-01-01 12:00:00+00',
+    i % 2 ? 't' : 'f',
+  ],
+  'long text': (i) => [
+    String(i),
+    `a somewhat longer free-text column, row ${i}, `.repeat(8),
+  ],
+  'non-ASCII': (i) => [String(i), `ünïcödé ${i}`, `用户 ${i}`, '✓'],
+}
+
+interface Row {
+  bytes: Uint8Array
+  columns: Int32Array
+  fieldCount: number
+}
+
+function makeRows(shape: (i: number) => (string | null)[]): Row[] {
+  const rows: Row[] = []
+  for (let i = 0; i < ROWS; i++) {
+    const fields = shape(i)
+    // Skip the code and length, like the parser
+    const bytes = buffers.dataRow(fields).subarray(5)
+    const view = new DataView(bytes.buffer, bytes.byteOffset)
+    const columns = new Int32Array(fields.length * 2)
+    let offset = 2
+    for (let field = 0; field < fields.length; field++) {
+      const length = view.getInt32(offset)
+      offset += 4
+      columns[field * 2] = offset
+      columns[field * 2 + 1] = length
+      if (length !== -1) offset += length
+    }
+    rows.push({ bytes, columns, fieldCount: fields.length })
+  }
+  return rows
+}
+
+const decoder = new TextDecoder()
+
+for (const [name, shape] of Object.entries(shapes)) {
+  const rows = makeRows(shape)
+
+  describe(`decode ${ROWS} rows: ${name}`, () => {
+    bench('TextDecoder per field', () => {
+      for (const { bytes, columns, fieldCount } of rows) {
+        for (let i = 0; i < fieldCount; i++) {
+          const offset = columns[i * 2]
+          const length = columns[i * 2 + 1]
+          if (length !== -1) {
+            decoder.decode(bytes.slice(offset, offset + length))
+          }
+        }
+      }
+    })
+    bench('decodeUtf8 per field', () => {
+      for (const { bytes, columns, fieldCount } of rows) {
+        for (let i = 0; i < fieldCount; i++) {
+          const offset = columns[i * 2]
+          const length = columns[i * 2 + 1]
+          if (length !== -1) {
+            decodeUtf8(bytes, offset, offset + length)
+          }
+        }
+      }
+    })
+    bench('decodeUtf8Fields', () => {
+      for (const { bytes, columns, fieldCount } of rows) {
+        decodeUtf8Fields(bytes, columns, 0, fieldCount)
+      }
+    })
+  })
+}
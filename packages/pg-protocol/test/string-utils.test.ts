@@ -1,5 +1,9 @@
 import { describe, it, expect } from 'vitest'
-import { byteLengthUtf8 } from '../src/string-utils' // Adjust the import based on your file structure
+import {
+  byteLengthUtf8,
+  decodeUtf8,
+  decodeUtf8Fields,
+} from '../src/string-utils' // Adjust the import based on your file structure
 
 describe('byteLengthUtf8', () => {
   it('should return 0 for an empty string', () => {
@@ -35,3 +39,63 @@ describe('byteLengthUtf8', () => {
     expect(byteLengthUtf8(complexStr)).toBe(58) // Mix of ASCII, emoji, and Chinese characters
   })
 })
+
+describe('decodeUtf8', () => {
+  const encoder = new TextEncoder()
+
+  it('should decode short and long strings', () => {
+    for (const str of ['', 't', 'ünï', '2024-01-01', 'x'.repeat(100)]) {
+      const bytes = encoder.encode(`[${str}]`)
+      expect(decodeUtf8(bytes, 1, bytes.length - 1)).toBe(str)
+    }
+  })
+
+  it('should decode a short string that is not ASCII', () => {
+    const bytes = encoder.encode('abc你好')
+    expect(decodeUtf8(bytes, 0, bytes.length)).toBe('abc你好')
+  })
+})
+
+describe('decodeUtf8Fields', () => {
+  const encoder = new TextEncoder()
+
+  // Lay fields out like a dataRow, with an int32 length before each
+  function layout(fields: (string | null)[]) {
+    const parts = fields.map((field) =>
+      field === null ? null : encoder.encode(field),
+    )
+    const bytes = new Uint8Array(
+      parts.reduce((total, part) => total + 4 + (part?.length ?? 0), 0),
+    )
+    const view = new DataView(bytes.buffer)
+    // A pair of padding before the row's own pairs
+    const columns = new Int32Array(fields.length * 2 + 2)
+    let offset = 0
+    parts.forEach((part, i) => {
+      view.setInt32(offset, part ? part.length : -1)
+      offset += 4
+      columns[i * 2 + 2] = offset
+      columns[i * 2 + 3] = part ? part.length : -1
+      bytes.set(part ?? [], offset)
+      offset += part?.length ?? 0
+    })
+    return { bytes, columns }
+  }
+
+  it('should decode every field', () => {
+    for (const fields of [
+      ['1', null, 'user 1', 'x'.repeat(200), ''],
+      ['1', null, 'x'.repeat(200), 'a longer text field', ''],
+      ['1', null, 'x'.repeat(200), 'ünï', '你好'.repeat(10)],
+      ['✓'.repeat(50), 'a'],
+      [null, null],
+      ['only'],
+      [],
+    ]) {
+      const { bytes, columns } = layout(fields)
+      expect(decodeUtf8Fields(bytes, columns, 1, fields.length)).toEqual(
+        fields,
+      )
+    }
+  })
+})
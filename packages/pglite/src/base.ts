@@ -1,5 +1,9 @@
 import { query as queryTemplate } from './templating.js'
-import { parseDescribeStatementResults, parseResults } from './parse.js'
+import {
+  batchRowParser,
+  parseDescribeStatementResults,
+  parseResults,
+} from './parse.js'
 import {
   type Serializer,
   type Parser,
@@ -7,26 +11,56 @@ import {
   parsers,
   arraySerializer,
   arrayParser,
+  canParseBinary,
+  TEXT_FORMAT,
+  BINARY_FORMAT,
 } from './types.js'
 import type {
   DebugLevel,
   PGliteInterfaceBase,
   Results,
   Transaction,
+  Pipeline,
+  PipelineQueryOptions,
   QueryOptions,
+  QueryIteratorOptions,
   ExecProtocolOptions,
   ExecProtocolResult,
   DescribeQueryResult,
+  StatementCacheStats,
 } from './interface.js'
 
-import { serialize as serializeProtocol } from '@electric-sql/pg-protocol'
+import {
+  serialize as serializeProtocol,
+  MessageBatch,
+} from '@electric-sql/pg-protocol'
 import {
   RowDescriptionMessage,
   ParameterDescriptionMessage,
+  ReadyForQueryMessage,
   DatabaseError,
   BackendMessage,
 } from '@electric-sql/pg-protocol/messages'
 import { makePGliteError } from './errors.js'
+import { StatementCache } from './statement-cache.js'
+
+const DEFAULT_ITERATOR_BATCH_SIZE = 1000
+// "portal does not exist"
+const UNDEFINED_CURSOR = '34000'
+
+const iteratorInterrupted = () =>
+  new Error(
+    'queryIterator() was interrupted by a query run between batches; ' +
+      'iterate inside a transaction to run other queries in the loop',
+  )
+
+interface PipelineEntry {
+  query: string
+  params: any[]
+  options?: PipelineQueryOptions
+  resolve: (result: Results<any>) => void
+  reject: (error: unknown) => void
+}
 
 export abstract class BasePGlite
   implements Pick<PGliteInterfaceBase, 'query' | 'sql' | 'exec' | 'transaction'>
@@ -40,6 +74,14 @@ export abstract class BasePGlite
 
   // # Private properties:
   #inTransaction = false
+  // Serializes each extended query into one reused buffer; queries run one
+  // at a time, so it's never shared by two in flight
+  #batch = new MessageBatch()
+  #statements = new StatementCache()
+  #nextPortalId = 0
+  // Ends the queryIterator() outside a transaction that's paused between
+  // batches, if any
+  #pausedIteration?: () => Promise<void>
 
   // # Abstract methods:
 
@@ -145,6 +187,15 @@ export abstract class BasePGlite
     }
   }
 
+  /**
+   * Set how many prepared statements query() keeps, as with the
+   * statementCacheSize option.
+   * This should be called from the constructor of the implementing class.
+   */
+  _setStatementCacheSize(size: number) {
+    this.#statements = new StatementCache(size)
+  }
+
   async #execProtocolNoSync(
     message: Uint8Array,
     options: ExecProtocolOptions = {},
@@ -152,6 +203,7 @@ export abstract class BasePGlite
     return await this.execProtocolStream(message, {
       ...options,
       syncToFs: false,
+      lazyDataRows: true,
     })
   }
 
@@ -209,6 +261,40 @@ export abstract class BasePGlite
     return await this.query(query, actualParams)
   }
 
+  /**
+   * Execute a single SQL statement like with {@link PGlite.query}, but iterate
+   * over its rows instead of collecting them. The rows are fetched from a
+   * portal `batchSize` at a time, so only one batch is held in memory.
+   *
+   * Other queries only wait for a batch to be fetched. The portal is in an
+   * implicit transaction though, so a query run between batches closes it
+   * before running in a transaction of its own, and the iteration fails at
+   * the next batch. To run queries inside the loop, iterate with
+   * `tx.queryIterator()` in a transaction. Leaving the loop early closes the
+   * portal.
+   *
+   * @param query The query to execute
+   * @param params Optional parameters for the query
+   * @returns An async iterator over the rows
+   *
+   * @example
+   * ```ts
+   * for await (const row of db.queryIterator('SELECT * FROM logs')) {
+   *   await output.write(JSON.stringify(row))
+   * }
+   * ```
+   */
+  async *queryIterator<T>(
+    query: string,
+    params?: any[],
+    options?: QueryIteratorOptions,
+  ): AsyncGenerator<T, void, undefined> {
+    await this._checkReady()
+    yield* this.#iterateQuery<T>(query, params, options, (fn) =>
+      this._runExclusiveTransaction(() => this._runExclusiveQuery(fn)),
+    )
+  }
+
   /**
    * Execute a SQL query, this can have multiple statements.
    * This uses the "Simple Query" postgres wire protocol message.
@@ -225,6 +311,31 @@ export abstract class BasePGlite
     })
   }
 
+  /**
+   * Choose binary for each result column that can be parsed from it
+   * @param statement The messages from describing the statement
+   * @param options The query's options, for its parsers
+   * @returns The format code of each column, or undefined for all text
+   */
+  #binaryResultFormats(
+    statement: BackendMessage[],
+    options?: QueryOptions,
+  ): number[] | undefined {
+    const description = statement.find(
+      (msg): msg is RowDescriptionMessage => msg.name === 'rowDescription',
+    )
+    if (!description) return undefined
+    const formats = description.fields.map((field) =>
+      canParseBinary(field.dataTypeID, this.parsers, options?.parsers)
+        ? BINARY_FORMAT
+        : TEXT_FORMAT,
+    )
+    if (formats.every((format) => format === BINARY_FORMAT)) {
+      return [BINARY_FORMAT]
+    }
+    return formats.includes(BINARY_FORMAT) ? formats : undefined
+  }
+
   /**
    * Internal method to execute a query
    * Not protected by the transaction mutex, so it can be used inside a transaction
@@ -238,76 +349,319 @@ export abstract class BasePGlite
     options?: QueryOptions,
   ): Promise<Results<T>> {
     return await this._runExclusiveQuery(async () => {
+      await this.#endPausedIteration()
       // We need to parse, bind and execute a query with parameters
       this.#log('runQuery', query, params, options)
       await this._handleBlob(options?.blob)
 
-      let results = []
+      const results = await this.#executeQuery(query, params, options)
 
-      try {
-        const parseResults = await this.#execProtocolNoSync(
-          serializeProtocol.parse({ text: query, types: options?.paramTypes }),
-          options,
-        )
+      this.#statements.invalidate(results)
+      await this._cleanupBlob()
+      if (!this.#inTransaction) {
+        await this.syncToFs()
+      }
+      const blob = await this._getWrittenBlob()
+      return parseResults(results, this.parsers, options, blob)[0] as Results<T>
+    })
+  }
 
-        const dataTypeIDs = parseDescribeStatementResults(
-          await this.#execProtocolNoSync(
-            serializeProtocol.describe({ type: 'S' }),
-            options,
-          ),
+  /**
+   * Parse (unless cached), bind and execute a query, then sync
+   * @param retry Whether a cached statement that can no longer run may be
+   * prepared again, once
+   * @returns The messages from describing and executing it
+   */
+  async #executeQuery(
+    query: string,
+    params: any[],
+    options: QueryOptions | undefined,
+    retry = true,
+  ): Promise<BackendMessage[]> {
+    let results: BackendMessage[] = []
+    const cache = this.#statements
+    const key = cache.enabled
+      ? StatementCache.key(query, options?.paramTypes)
+      : undefined
+    const cached = key === undefined ? undefined : cache.get(key)
+    let name = cached?.name
+    // Set while a statement is prepared but not yet cached, so that it's
+    // closed if preparing it fails
+    let preparing: string | undefined
+    let closing: string[] = []
+    // Set when the cached statement was invalidated behind the cache's back,
+    // e.g. by DDL in a DO block or a function
+    let stale: DatabaseError | undefined
+
+    try {
+      let statement: BackendMessage[]
+      if (cached) {
+        statement = cached.description
+      } else {
+        name = preparing = key === undefined ? undefined : cache.nextName()
+        statement = await this.#execProtocolNoSync(
+          this.#batch
+            .parse({ name, text: query, types: options?.paramTypes })
+            .describe({ type: 'S', name })
+            .finish(),
+          options,
         )
+        if (key !== undefined) {
+          cache.set(key, { name: name!, description: statement })
+          preparing = undefined
+        }
+      }
+      const dataTypeIDs = parseDescribeStatementResults(statement)
 
-        const values = params.map((param, i) => {
-          const oid = dataTypeIDs[i]
-          if (param === null || param === undefined) {
-            return null
-          }
-          const serialize = options?.serializers?.[oid] ?? this.serializers[oid]
-          if (serialize) {
-            return serialize(param)
-          } else {
-            return param.toString()
-          }
-        })
+      const values = this.#serializeParams(params, dataTypeIDs, options)
+      const resultFormats =
+        options?.resultFormat === 'binary'
+          ? this.#binaryResultFormats(statement, options)
+          : undefined
 
-        results = [
-          ...parseResults,
-          ...(await this.#execProtocolNoSync(
-            serializeProtocol.bind({
-              values,
-            }),
-            options,
-          )),
-          ...(await this.#execProtocolNoSync(
-            serializeProtocol.describe({ type: 'P' }),
-            options,
-          )),
-          ...(await this.#execProtocolNoSync(
-            serializeProtocol.execute({}),
-            options,
-          )),
-        ]
-      } catch (e) {
-        if (e instanceof DatabaseError) {
-          const pgError = makePGliteError({ e, options, params, query })
-          throw pgError
+      closing = this.#closeStatements()
+      results = [
+        ...statement,
+        ...(await this.#execProtocolNoSync(
+          this.#batch
+            .bind({ statement: name, values, resultFormats })
+            .describe({ type: 'P' })
+            .execute()
+            .finish(),
+          options,
+        )),
+      ]
+    } catch (e) {
+      if (preparing !== undefined) {
+        cache.discard(preparing)
+      }
+      if (e instanceof DatabaseError) {
+        if (cached && cache.deleteIfInvalid(key!, e) && retry) {
+          stale = e
+        } else {
+          throw makePGliteError({ e, options, params, query })
         }
+      } else {
+        // The Closes may not have been sent; closing twice is harmless
+        closing.forEach((name) => cache.discard(name))
         throw e
-      } finally {
-        results.push(
-          ...(await this.#execProtocolNoSync(
-            serializeProtocol.sync(),
-            options,
-          )),
-        )
       }
+    } finally {
+      results.push(
+        ...(await this.#execProtocolNoSync(serializeProtocol.sync(), options)),
+      )
+    }
 
-      await this._cleanupBlob()
-      if (!this.#inTransaction) {
+    if (stale) {
+      // Outside a transaction block nothing but the failed query was rolled
+      // back, so it can run again; inside one the transaction has failed
+      const ready = results.find(
+        (msg): msg is ReadyForQueryMessage => msg.name === 'readyForQuery',
+      )
+      if (ready?.status !== 'I') {
+        throw makePGliteError({ e: stale, options, params, query })
+      }
+      return await this.#executeQuery(query, params, options, false)
+    }
+    return results
+  }
+
+  /**
+   * Queue a Close for each prepared statement dropped from the cache
+   * @returns The names of the statements
+   */
+  #closeStatements() {
+    const names = this.#statements.takeClosed()
+    for (const name of names) {
+      this.#batch.close({ type: 'S', name })
+    }
+    return names
+  }
+
+  /**
+   * Get hit and miss counts for the prepared statements kept by query()
+   * @returns The statement cache statistics
+   */
+  getStatementCacheStats(): StatementCacheStats {
+    return this.#statements.stats()
+  }
+
+  /**
+   * Forget every prepared statement kept by query(), e.g. after changing the
+   * schema with execProtocol(). They're closed with the next query.
+   */
+  clearStatementCache() {
+    this.#statements.clear()
+  }
+
+  /**
+   * Internal method to iterate over the rows of a query
+   * Each round trip takes the locks from the given runExclusive afresh, so
+   * they're free while rows are handed out and an iterator that's never
+   * finished blocks nothing. Inside a transaction the portal outlives the
+   * queries run in between. Outside one it's in the implicit transaction
+   * that the next query's Sync ends, so that query ends the iteration first
+   * and the iterator then fails.
+   * @param runExclusive Runs a function under the locks the query needs
+   * @param tx The transaction iterated in, if any
+   */
+  async *#iterateQuery<T>(
+    query: string,
+    params: any[] = [],
+    options: QueryIteratorOptions | undefined,
+    runExclusive: (fn: () => Promise<void>) => Promise<void>,
+    tx?: Transaction,
+  ): AsyncGenerator<T, void, undefined> {
+    const rows = options?.batchSize ?? DEFAULT_ITERATOR_BATCH_SIZE
+    if (!Number.isInteger(rows) || rows < 1) {
+      throw new Error('batchSize must be a positive integer')
+    }
+
+    this.#log('iterateQuery', query, params, options)
+    // Named, so that the unnamed portals of other queries leave it alone
+    const portal = `pglite_portal_${this.#nextPortalId++}`
+    let messages: BackendMessage[] = []
+    let closed = false
+    let interrupted = false
+
+    const close = async (failed: boolean) => {
+      if (closed) return
+      closed = true
+      if (this.#pausedIteration === pause) {
+        this.#pausedIteration = undefined
+      }
+      // Closing the portal ends a query that was left before its last row
+      await this.#execProtocolNoSync(
+        this.#batch.close({ type: 'P', name: portal }).sync().finish(),
+        options,
+      )
+      this.#statements.invalidate(messages)
+      if (!failed && !this.#inTransaction) {
         await this.syncToFs()
       }
-      const blob = await this._getWrittenBlob()
-      return parseResults(results, this.parsers, options, blob)[0] as Results<T>
+    }
+    const pause = async () => {
+      interrupted = true
+      await close(false)
+    }
+    const suspended = () =>
+      messages.some((msg) => msg.name === 'portalSuspended')
+
+    // A failed round trip is synced before the locks are released, as other
+    // queries' messages would be ignored until then
+    const locked = async (fn: () => Promise<void>) => {
+      if (tx?.closed) {
+        throw new Error('Transaction is closed')
+      }
+      await runExclusive(async () => {
+        if (interrupted) throw iteratorInterrupted()
+        if (this.#pausedIteration === pause) {
+          this.#pausedIteration = undefined
+        } else {
+          await this.#endPausedIteration()
+        }
+        try {
+          await fn()
+        } catch (e) {
+          await close(true)
+          throw e
+        }
+        if (!tx && suspended()) {
+          this.#pausedIteration = pause
+        }
+      })
+    }
+
+    try {
+      await locked(async () => {
+        const statement = await this.#execProtocolNoSync(
+          this.#batch
+            .parse({ text: query, types: options?.paramTypes })
+            .describe({ type: 'S' })
+            .finish(),
+          options,
+        )
+        const dataTypeIDs = parseDescribeStatementResults(statement)
+        const values = this.#serializeParams(params, dataTypeIDs, options)
+        const resultFormats =
+          options?.resultFormat === 'binary'
+            ? this.#binaryResultFormats(statement, options)
+            : undefined
+
+        messages = await this.#execProtocolNoSync(
+          this.#batch
+            .bind({ portal, values, resultFormats })
+            .describe({ type: 'P', name: portal })
+            .execute({ portal, rows })
+            .finish(),
+          options,
+        )
+      })
+      const description = messages.find(
+        (msg): msg is RowDescriptionMessage => msg.name === 'rowDescription',
+      )
+      if (!description) return
+
+      const parseRows = batchRowParser(description, this.parsers, options)
+      for (;;) {
+        yield* parseRows(messages) as T[]
+        if (!suspended()) break
+        await locked(async () => {
+          messages = await this.#execProtocolNoSync(
+            this.#batch.execute({ portal, rows }).finish(),
+            options,
+          )
+        })
+      }
+    } catch (e) {
+      if (e instanceof DatabaseError) {
+        // The portal was closed behind our back, e.g. by execProtocol()
+        if (e.code === UNDEFINED_CURSOR) throw iteratorInterrupted()
+        throw makePGliteError({ e, options, params, query })
+      }
+      throw e
+    } finally {
+      // Once the transaction has ended, so has the portal
+      if (!closed && !tx?.closed) {
+        await runExclusive(() => close(false))
+      }
+    }
+  }
+
+  /**
+   * End a queryIterator() paused between batches outside a transaction,
+   * before another query's Sync ends the implicit transaction its portal is
+   * in. The iterator fails on its next batch rather than this query running
+   * inside its transaction.
+   */
+  async #endPausedIteration() {
+    const end = this.#pausedIteration
+    this.#pausedIteration = undefined
+    await end?.()
+  }
+
+  /**
+   * Serialize query parameters to text using the serializers for their types
+   * @param params The parameters to serialize
+   * @param dataTypeIDs The parameter types, as described by Postgres
+   * @returns The values to bind
+   */
+  #serializeParams(
+    params: any[],
+    dataTypeIDs: number[],
+    options?: QueryOptions,
+  ) {
+    return params.map((param, i) => {
+      const oid = dataTypeIDs[i]
+      if (param === null || param === undefined) {
+        return null
+      }
+      const serialize = options?.serializers?.[oid] ?? this.serializers[oid]
+      if (serialize) {
+        return serialize(param)
+      } else {
+        return param.toString()
+      }
     })
   }
 
@@ -323,6 +677,7 @@ export abstract class BasePGlite
     options?: QueryOptions,
   ): Promise<Array<Results>> {
     return await this._runExclusiveQuery(async () => {
+      await this.#endPausedIteration()
       // No params so we can just send the query
       this.#log('runExec', query, options)
       await this._handleBlob(options?.blob)
@@ -351,6 +706,7 @@ export abstract class BasePGlite
           )),
         )
       }
+      this.#statements.invalidate(results)
       this._cleanupBlob()
       if (!this.#inTransaction) {
         await this.syncToFs()
@@ -365,6 +721,219 @@ export abstract class BasePGlite
     })
   }
 
+  /**
+   * Create a pipeline: queue many extended-protocol queries and send them to
+   * Postgres in one round trip, instead of one per protocol message.
+   * See {@link Pipeline}.
+   *
+   * @example
+   * ```ts
+   * const pipeline = db.pipeline()
+   * for (const todo of todos) {
+   *   pipeline.query('INSERT INTO todo (task) VALUES ($1)', [todo])
+   * }
+   * await pipeline.run()
+   * ```
+   */
+  pipeline(): Pipeline {
+    return this.#createPipeline(async (entries) => {
+      await this._checkReady()
+      return await this._runExclusiveTransaction(async () => {
+        return await this.#runPipeline(entries)
+      })
+    })
+  }
+
+  /**
+   * Queue statements until run() hands them to the given runner
+   */
+  #createPipeline(
+    run: (entries: PipelineEntry[]) => Promise<Array<Results>>,
+  ): Pipeline {
+    let entries: PipelineEntry[] = []
+
+    const pipeline: Pipeline = {
+      query: <T>(
+        query: string,
+        params: any[] = [],
+        options?: PipelineQueryOptions,
+      ): Promise<Results<T>> => {
+        const result = new Promise<Results<T>>((resolve, reject) => {
+          entries.push({ query, params, options, resolve, reject })
+        })
+        // Failures also surface through run(), so callers that only await
+        // run() must not see unhandled rejections
+        result.catch(() => {})
+        return result
+      },
+      sql: <T>(
+        sqlStrings: TemplateStringsArray,
+        ...params: any[]
+      ): Promise<Results<T>> => {
+        const { query, params: actualParams } = queryTemplate(
+          sqlStrings,
+          ...params,
+        )
+        return pipeline.query<T>(query, actualParams)
+      },
+      run: async () => {
+        const queued = entries
+        entries = []
+        return await run(queued)
+      },
+    }
+    return pipeline
+  }
+
+  /**
+   * Internal method to execute a pipeline
+   * Not protected by the transaction mutex, so it can be used inside a transaction
+   *
+   * Every statement's Parse/Bind/Describe/Execute goes into one message
+   * buffer with a single Sync, so the backend works through all of them in
+   * one call. Statements with parameters but no paramTypes need one more
+   * round trip first, to describe each distinct query text.
+   * @param entries The queued statements
+   * @returns The result of each statement
+   */
+  async #runPipeline(entries: PipelineEntry[]): Promise<Array<Results>> {
+    if (entries.length === 0) return []
+
+    return await this._runExclusiveQuery(async () => {
+      await this.#endPausedIteration()
+      this.#log('runPipeline', entries.length)
+
+      let messages: BackendMessage[]
+      try {
+        const paramTypes = await this.#describePipelineParams(entries)
+        const values = entries.map((entry) =>
+          this.#serializeParams(
+            entry.params,
+            entry.options?.paramTypes ?? paramTypes.get(entry.query) ?? [],
+            entry.options,
+          ),
+        )
+        entries.forEach((entry, i) => {
+          this.#batch
+            .parse({ text: entry.query, types: entry.options?.paramTypes })
+            .bind({ values: values[i] })
+            .describe({ type: 'P' })
+            .execute()
+        })
+        messages = await this.#execProtocolNoSync(this.#batch.sync().finish(), {
+          throwOnError: false,
+        })
+      } catch (e) {
+        // Leave the extended protocol error state, in case the failure came
+        // before our Sync was processed
+        await this.#execProtocolNoSync(serializeProtocol.sync(), {
+          throwOnError: false,
+        })
+        entries.forEach((entry) => entry.reject(e))
+        throw e
+      }
+
+      // Each statement's messages run up to its CommandComplete (or
+      // EmptyQueryResponse); an error ends the pipeline at the statement it
+      // belongs to
+      this.#statements.invalidate(messages)
+      const perEntry: BackendMessage[][] = entries.map(() => [])
+      let current = 0
+      for (const msg of messages) {
+        if (msg instanceof DatabaseError) {
+          throw this.#abortPipeline(entries, current, msg)
+        }
+        if (current < entries.length) {
+          perEntry[current].push(msg)
+        }
+        if (msg.name === 'commandComplete' || msg.name === 'emptyQuery') {
+          current++
+        }
+      }
+
+      if (!this.#inTransaction) {
+        await this.syncToFs()
+      }
+      const results = entries.map(
+        (entry, i) =>
+          parseResults(perEntry[i], this.parsers, entry.options)[0],
+      )
+      entries.forEach((entry, i) => entry.resolve(results[i]))
+      return results
+    })
+  }
+
+  /**
+   * Get the parameter types of every pipelined query text that needs them,
+   * with a single Parse/Describe round trip
+   * @returns The parameter types by query text
+   */
+  async #describePipelineParams(
+    entries: PipelineEntry[],
+  ): Promise<Map<string, number[]>> {
+    const paramTypes = new Map<string, number[]>()
+    const texts = [
+      ...new Set(
+        entries
+          .filter((entry) => entry.params.length && !entry.options?.paramTypes)
+          .map((entry) => entry.query),
+      ),
+    ]
+    if (texts.length === 0) return paramTypes
+
+    for (const text of texts) {
+      this.#batch.parse({ text }).describe({ type: 'S' })
+    }
+    const messages = await this.#execProtocolNoSync(this.#batch.finish(), {
+      throwOnError: false,
+    })
+    const descriptions = messages.filter(
+      (msg): msg is ParameterDescriptionMessage =>
+        msg.name === 'parameterDescription',
+    )
+
+    const error = messages.find((msg) => msg instanceof DatabaseError)
+    if (error) {
+      // Texts are described in order, so the error belongs to the first one
+      // without a ParameterDescription
+      const failed = texts[descriptions.length]
+      throw this.#abortPipeline(
+        entries,
+        entries.findIndex((entry) => entry.query === failed),
+        error as DatabaseError,
+      )
+    }
+
+    descriptions.forEach((msg, i) => paramTypes.set(texts[i], msg.dataTypeIDs))
+    return paramTypes
+  }
+
+  /**
+   * Reject every statement in a failed pipeline: the failing one with its
+   * error, the rest as aborted
+   * @returns The error for the pipeline as a whole
+   */
+  #abortPipeline(entries: PipelineEntry[], failed: number, e: DatabaseError) {
+    const entry = entries[failed]
+    const pgError = makePGliteError({
+      e,
+      options: entry.options,
+      params: entry.params,
+      query: entry.query,
+    })
+    const aborted = new Error(
+      `Pipeline aborted: statement ${failed + 1} of ${entries.length} failed: ${pgError.message}`,
+    )
+    entries.forEach((other, i) => {
+      if (i === failed) {
+        other.reject(pgError)
+      } else {
+        other.reject(aborted)
+      }
+    })
+    return pgError
+  }
+
   /**
    * Describe a query
    * @param query The query to describe
@@ -471,6 +1040,27 @@ export abstract class BasePGlite
           checkClosed()
           return await this.#runExec(query, options)
         },
+        queryIterator: <T>(
+          query: string,
+          params?: any[],
+          options?: QueryIteratorOptions,
+        ) => {
+          checkClosed()
+          return this.#iterateQuery<T>(
+            query,
+            params,
+            options,
+            (fn) => this._runExclusiveQuery(fn),
+            tx,
+          )
+        },
+        pipeline: () => {
+          checkClosed()
+          return this.#createPipeline(async (entries) => {
+            checkClosed()
+            return await this.#runPipeline(entries)
+          })
+        },
         rollback: async () => {
           checkClosed()
           // Rollback and set the closed flag to prevent further use of this
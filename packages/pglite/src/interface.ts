@@ -95,7 +95,12 @@ export type FilesystemType = 'nodefs' | 'idbfs' | 'memoryfs'
 
 export type DebugLevel = 0 | 1 | 2 | 3 | 4 | 5
 
-export type RowMode = 'array' | 'object'
+/**
+ * How rows are returned: as objects keyed by field name, as arrays, or, for
+ * 'columnar', not as rows at all but as one array of values per column in
+ * `Results.columns`
+ */
+export type RowMode = 'array' | 'object' | 'columnar'
 
 export interface ParserOptions {
   [pgType: number]: (value: string) => unknown
@@ -107,6 +112,19 @@ export interface SerializerOptions {
 
 export interface QueryOptions {
   rowMode?: RowMode
+  /**
+   * Decode and parse each column of a row the first time it is read instead
+   * of up front. Rows are proxies that enumerate and serialize like plain
+   * objects or arrays, but cannot be structured-cloned without a copy.
+   */
+  lazyRows?: boolean
+  /**
+   * Have Postgres send result columns in binary where PGlite can parse them
+   * to the same values as their text form: numbers, booleans, bytea, uuid,
+   * dates and timestamps, numeric, text, and arrays of these. Columns of
+   * other types, or with custom parsers, stay text. Ignored by exec().
+   */
+  resultFormat?: 'text' | 'binary'
   parsers?: ParserOptions
   serializers?: SerializerOptions
   blob?: Blob | File
@@ -114,10 +132,30 @@ export interface QueryOptions {
   paramTypes?: number[]
 }
 
+/**
+ * Options for queryIterator(), which returns rows one at a time: there's no
+ * 'columnar' row mode, and no blob.
+ */
+export interface QueryIteratorOptions
+  extends Omit<QueryOptions, 'rowMode' | 'blob'> {
+  rowMode?: 'object' | 'array'
+  /**
+   * How many rows to fetch from Postgres at a time
+   * @default 1000
+   */
+  batchSize?: number
+}
+
 export interface ExecProtocolOptions {
   syncToFs?: boolean
   throwOnError?: boolean
   onNotice?: (notice: NoticeMessage) => void
+  /**
+   * Return dataRows as LazyDataRowMessages, which decode a field only when
+   * it is read. query() and exec() use this; by default dataRows are plain
+   * DataRowMessages.
+   */
+  lazyDataRows?: boolean
 }
 
 export interface ExtensionSetupResult<TNamespace = unknown> {
@@ -225,6 +263,23 @@ export interface MemoryStats {
   }
 }
 
+/**
+ * Usage of the prepared statement cache, see
+ * {@link PGliteOptions.statementCacheSize}
+ */
+export interface StatementCacheStats {
+  /** Queries that reused a prepared statement */
+  hits: number
+  /** Queries that had to prepare one */
+  misses: number
+  /** Statements dropped to make room for newer ones */
+  evictions: number
+  /** Statements currently cached */
+  size: number
+  /** The most statements that will be cached */
+  capacity: number
+}
+
 export interface PGliteOptions<TExtensions extends Extensions = Extensions> {
   dataDir?: string
   username?: string
@@ -239,6 +294,21 @@ export interface PGliteOptions<TExtensions extends Extensions = Extensions> {
   fsBundle?: Blob | File
   parsers?: ParserOptions
   serializers?: SerializerOptions
+  /**
+   * How many of the most recently used `query()` texts to keep prepared as
+   * named statements, so that running one again skips parsing and planning.
+   *
+   * The cache is cleared after DDL, `DISCARD`, `DEALLOCATE` and `ROLLBACK`
+   * run through `query()`, `exec()` or a pipeline. A cached query that
+   * fails because the schema changed some other way, e.g. in a `DO` block,
+   * is prepared again and rerun, except inside a transaction; call
+   * `clearStatementCache()` after such changes there. Set to 0 to prepare
+   * every query as an unnamed statement.
+   * `PGliteWorker` always does, as its backend is shared between tabs.
+   *
+   * @default 100
+   */
+  statementCacheSize?: number
   /**
    * Pre-initialized memory snapshot for fast cold starts.
    * When provided, skips initdb and restores from the snapshot.
@@ -399,8 +469,14 @@ export interface PGliteInterfaceBase {
     ...params: unknown[]
   ): Promise<Results<T>>
   exec(query: string, options?: QueryOptions): Promise<Array<Results>>
+  queryIterator<T>(
+    query: string,
+    params?: unknown[],
+    options?: QueryIteratorOptions,
+  ): AsyncGenerator<T, void, undefined>
   describeQuery(query: string): Promise<DescribeQueryResult>
   transaction<T>(callback: (tx: Transaction) => Promise<T>): Promise<T>
+  pipeline(): Pipeline
   execProtocolRaw(
     message: Uint8Array,
     options?: ExecProtocolOptions,
@@ -427,6 +503,8 @@ export interface PGliteInterfaceBase {
   dumpDataDir(compression?: DumpTarCompressionOptions): Promise<File | Blob>
   refreshArrayTypes(): Promise<void>
   getMemoryStats(): Promise<MemoryStats>
+  getStatementCacheStats(): StatementCacheStats
+  clearStatementCache(): void
 }
 
 /**
@@ -450,10 +528,25 @@ export type PGliteInterfaceExtensions<E> = E extends Extensions
 
 export type Row<T = { [key: string]: unknown }> = T
 
+/**
+ * One column of a result in 'columnar' row mode. int2 and int4 columns are
+ * Int32Arrays, int8 columns BigInt64Arrays, and float4, float8 and oid
+ * columns Float64Arrays, unless their type has a custom parser; every other
+ * column is an array of parsed values.
+ */
+export type Column = {
+  /** The value of each row; a null is 0 in a typed array, else null */
+  values: Int32Array | Float64Array | BigInt64Array | unknown[]
+  /** Bit `i & 7` of byte `i >> 3` is set when row i is null */
+  nulls: Uint8Array
+}
+
 export type Results<T = { [key: string]: unknown }> = {
   rows: Row<T>[]
   affectedRows?: number
   fields: { name: string; dataTypeID: number }[]
+  /** The result by column, in 'columnar' row mode, where rows is empty */
+  columns?: Column[]
   blob?: Blob // Only set when a file is returned, such as from a COPY command
 }
 
@@ -468,7 +561,13 @@ export interface Transaction {
     ...params: unknown[]
   ): Promise<Results<T>>
   exec(query: string, options?: QueryOptions): Promise<Array<Results>>
+  queryIterator<T>(
+    query: string,
+    params?: unknown[],
+    options?: QueryIteratorOptions,
+  ): AsyncGenerator<T, void, undefined>
   rollback(): Promise<void>
+  pipeline(): Pipeline
   listen(
     channel: string,
     callback: (payload: string) => void,
@@ -476,6 +575,35 @@ export interface Transaction {
   get closed(): boolean
 }
 
+/**
+ * A batch of extended-protocol queries sent to Postgres in one round trip.
+ *
+ * `query()` and `sql()` only queue a statement; nothing is sent until
+ * `run()`. The statements then execute in order up to a single Sync, so they
+ * share one implicit transaction: if one fails, none of them take effect,
+ * its promise rejects with the error and the others reject as aborted.
+ */
+export interface Pipeline {
+  query<T>(
+    query: string,
+    params?: unknown[],
+    options?: PipelineQueryOptions,
+  ): Promise<Results<T>>
+  sql<T>(
+    sqlStrings: TemplateStringsArray,
+    ...params: unknown[]
+  ): Promise<Results<T>>
+  /**
+   * Send every queued statement and settle their promises.
+   * @returns The results in the order the statements were queued
+   */
+  run(): Promise<Array<Results>>
+}
+
+// Pipelined statements are bound without describing their results first, so
+// their results are always text
+export type PipelineQueryOptions = Omit<QueryOptions, 'blob' | 'resultFormat'>
+
 export type DescribeQueryResult = {
   queryParams: { dataTypeID: number; serializer: Serializer }[]
   resultFields: { name: string; dataTypeID: number; parser: Parser }[]
@@ -2,11 +2,336 @@ import {
   BackendMessage,
   RowDescriptionMessage,
   DataRowMessage,
+  LazyDataRowMessage,
   CommandCompleteMessage,
   ParameterDescriptionMessage,
 } from '@electric-sql/pg-protocol/messages'
-import type { Results, QueryOptions, Row } from './interface.js'
-import { parseType, type Parser } from './types.js'
+import type {
+  Results,
+  QueryOptions,
+  QueryIteratorOptions,
+  Row,
+  Column,
+} from './interface.js'
+import {
+  parseType,
+  parsers as builtInParsers,
+  binaryParsers,
+  BINARY_FORMAT,
+  INT2,
+  INT4,
+  INT8,
+  OID,
+  FLOAT4,
+  FLOAT8,
+  type BinaryParser,
+  type Parser,
+} from './types.js'
+
+type RowMessage = DataRowMessage | LazyDataRowMessage
+
+const rowMessage = Symbol('rowMessage')
+
+/**
+ * Parse one field of a row, from its text or, for a binary column, its bytes
+ */
+function parseField(
+  msg: RowMessage,
+  i: number,
+  dataTypeID: number,
+  binaryParser: BinaryParser | undefined,
+  parsers: Record<number | string, Parser>,
+) {
+  if (binaryParser) {
+    return readBinaryField(msg, i, binaryParser)
+  }
+  return parseType(msg.field(i), dataTypeID, parsers)
+}
+
+function readBinaryField(msg: RowMessage, i: number, read: BinaryParser) {
+  // Eager rows have already decoded every field as text
+  if (!(msg instanceof LazyDataRowMessage)) {
+    throw new Error('Binary results need a parser with lazyDataRows')
+  }
+  return msg.binaryField(i, read)
+}
+
+// The typed array for each type a 'columnar' result keeps unboxed
+const typedColumns: {
+  [type: number]:
+    | Int32ArrayConstructor
+    | Float64ArrayConstructor
+    | BigInt64ArrayConstructor
+} = {
+  [INT2]: Int32Array,
+  [INT4]: Int32Array,
+  [INT8]: BigInt64Array,
+  [OID]: Float64Array,
+  [FLOAT4]: Float64Array,
+  [FLOAT8]: Float64Array,
+}
+
+// An int2 or int4 straight from its text digits, without making a string
+function readTextInt(view: DataView, offset: number, length: number) {
+  const end = offset + length
+  const negative = view.getUint8(offset) === 0x2d // '-'
+  let n = 0
+  for (let at = negative ? offset + 1 : offset; at < end; at++) {
+    n = n * 10 + view.getUint8(at) - 0x30
+  }
+  return negative ? -n : n
+}
+
+function readBinaryInt8(view: DataView, offset: number) {
+  return view.getBigInt64(offset)
+}
+
+/**
+ * How to read a field of a typed column, as the number or bigint its typed
+ * array holds
+ */
+function typedColumnReader(
+  type: number,
+  binaryParser: BinaryParser | undefined,
+): (msg: RowMessage, i: number) => number | bigint | null {
+  if (binaryParser) {
+    const read = type === INT8 ? readBinaryInt8 : binaryParser
+    return (msg, i) => readBinaryField(msg, i, read)
+  }
+  if (type === INT8) {
+    return (msg, i) => {
+      const text = msg.field(i)
+      return text === null ? null : BigInt(text)
+    }
+  }
+  if (type === INT2 || type === INT4) {
+    return (msg, i) => {
+      if (msg instanceof LazyDataRowMessage) {
+        return msg.binaryField(i, readTextInt)
+      }
+      const text = msg.field(i)
+      return text === null ? null : +text
+    }
+  }
+  return (msg, i) => {
+    const text = msg.field(i)
+    return text === null ? null : +text
+  }
+}
+
+/**
+ * Build a 'columnar' result's columns from its rows. Numeric columns with
+ * the built-in parsers go into typed arrays without boxing each value.
+ */
+function buildColumns(
+  fields: Results['fields'],
+  binaryColumns: (BinaryParser | undefined)[],
+  rows: RowMessage[],
+  parsers: Record<number | string, Parser>,
+): Column[] {
+  return fields.map(({ dataTypeID }, i) => {
+    const nulls = new Uint8Array((rows.length + 7) >> 3)
+    const TypedColumn =
+      parsers[dataTypeID] === builtInParsers[dataTypeID]
+        ? typedColumns[dataTypeID]
+        : undefined
+
+    if (!TypedColumn) {
+      const values: unknown[] = new Array(rows.length)
+      for (let row = 0; row < rows.length; row++) {
+        const value = parseField(
+          rows[row],
+          i,
+          dataTypeID,
+          binaryColumns[i],
+          parsers,
+        )
+        if (value === null) nulls[row >> 3] |= 1 << (row & 7)
+        values[row] = value
+      }
+      return { values, nulls }
+    }
+
+    const values = new TypedColumn(rows.length)
+    const read = typedColumnReader(dataTypeID, binaryColumns[i])
+    for (let row = 0; row < rows.length; row++) {
+      const value = read(rows[row], i)
+      if (value === null) {
+        nulls[row >> 3] |= 1 << (row & 7)
+      } else {
+        values[row] = value as never
+      }
+    }
+    return { values, nulls }
+  })
+}
+
+/**
+ * Build the decoder for the rows of one result set, once per
+ * RowDescription. Each column's parser is looked up here instead of once per
+ * field, and object rows are cloned from a template so they all share one
+ * shape. This is closures rather than generated code, so it also runs where
+ * `new Function` is not allowed.
+ */
+function rowDecoder(
+  fields: Results['fields'],
+  binaryColumns: (BinaryParser | undefined)[],
+  parsers: Record<number | string, Parser>,
+  rowMode: QueryOptions['rowMode'],
+): (msg: RowMessage) => Row {
+  const count = fields.length
+  const names = fields.map((field) => field.name)
+  const types = fields.map((field) => field.dataTypeID)
+  const columnParsers: (Parser | undefined)[] = types.map(
+    (type) => parsers[type] ?? builtInParsers[type],
+  )
+
+  const parseColumn = (msg: RowMessage, i: number) => {
+    const binaryParser = binaryColumns[i]
+    if (binaryParser) {
+      return readBinaryField(msg, i, binaryParser)
+    }
+    const text = msg.field(i)
+    if (text === null) {
+      return null
+    }
+    const parse = columnParsers[i]
+    return parse ? parse(text, types[i]) : text
+  }
+
+  if (rowMode === 'array') {
+    // In array mode, rows contain arrays instead of objects
+    // Type assertion needed because Row type defaults to object
+    return (msg) => {
+      const row: unknown[] = []
+      for (let i = 0; i < count; i++) {
+        row.push(parseColumn(msg, i))
+      }
+      return row as unknown as Row
+    }
+  }
+
+  // Later columns win on duplicate names, keeping the first one's position
+  const template = Object.fromEntries(names.map((name) => [name, null]))
+  return (msg) => {
+    const row: Row = { ...template }
+    for (let i = 0; i < count; i++) {
+      row[names[i]] = parseColumn(msg, i)
+    }
+    return row
+  }
+}
+
+type LazyRow = Record<string | symbol, unknown> & {
+  [rowMessage]: RowMessage
+}
+
+/**
+ * Proxy handler shared by the rows of one result set. A column is parsed the
+ * first time it is read and then kept on the row, so the row still
+ * enumerates, spreads and serializes like a plain object or array.
+ */
+function lazyRowHandler(
+  fields: Results['fields'],
+  binaryColumns: (BinaryParser | undefined)[],
+  parsers: Record<number | string, Parser>,
+  rowMode: QueryOptions['rowMode'],
+): ProxyHandler<LazyRow> {
+  // Later columns win on duplicate names, as with eager rows
+  const columns = new Map<string, number>(
+    fields.map((field, i) => [rowMode === 'array' ? String(i) : field.name, i]),
+  )
+  const columnKeys = [...columns.keys()]
+
+  const handler: ProxyHandler<LazyRow> = {
+    get(row, key) {
+      if (
+        typeof key === 'string' &&
+        !Object.prototype.hasOwnProperty.call(row, key)
+      ) {
+        const i = columns.get(key)
+        if (i !== undefined) {
+          const value = parseField(
+            row[rowMessage],
+            i,
+            fields[i].dataTypeID,
+            binaryColumns[i],
+            parsers,
+          )
+          Object.defineProperty(row, key, {
+            value,
+            writable: true,
+            enumerable: true,
+            configurable: true,
+          })
+          return value
+        }
+      }
+      return Reflect.get(row, key)
+    },
+    has(row, key) {
+      return (typeof key === 'string' && columns.has(key)) || key in row
+    },
+    ownKeys(row) {
+      const extra = Reflect.ownKeys(row).filter((key) =>
+        typeof key === 'string' ? !columns.has(key) : key !== rowMessage,
+      )
+      return [...columnKeys, ...extra]
+    },
+    getOwnPropertyDescriptor(row, key) {
+      if (key === rowMessage) {
+        return undefined
+      }
+      if (typeof key === 'string' && columns.has(key)) {
+        handler.get!(row, key, row)
+      }
+      return Reflect.getOwnPropertyDescriptor(row, key)
+    },
+  }
+  return handler
+}
+
+/**
+ * The fields of a result, and the binary parser of each column sent in binary
+ */
+function describeResult(msg: RowDescriptionMessage) {
+  return {
+    fields: msg.fields.map((field) => ({
+      name: field.name,
+      dataTypeID: field.dataTypeID,
+    })),
+    binaryColumns: msg.fields.map((field) =>
+      field.format === BINARY_FORMAT
+        ? binaryParsers[field.dataTypeID]
+        : undefined,
+    ),
+  }
+}
+
+/**
+ * Build the function that makes a row of each dataRow of one result set:
+ * a lazy proxy with the lazyRows option, or else decoded up front
+ */
+function rowParser(
+  fields: Results['fields'],
+  binaryColumns: (BinaryParser | undefined)[],
+  parsers: Record<number | string, Parser>,
+  options?: QueryOptions | QueryIteratorOptions,
+): (msg: RowMessage) => Row {
+  if (!options?.lazyRows) {
+    return rowDecoder(fields, binaryColumns, parsers, options?.rowMode)
+  }
+  const rowMode = options.rowMode
+  const handler = lazyRowHandler(fields, binaryColumns, parsers, rowMode)
+  return (msg) => {
+    const row = (
+      rowMode === 'array'
+        ? Object.assign(new Array(msg.fieldCount), { [rowMessage]: msg })
+        : { [rowMessage]: msg }
+    ) as LazyRow
+    return new Proxy(row, handler) as Row
+  }
+}
 
 /**
  * This function is used to parse the results of either a simple or extended query.
@@ -22,48 +347,50 @@ export function parseResults(
   let currentResultSet: Results = { rows: [], fields: [] }
   let affectedRows = 0
   const parsers = { ...defaultParsers, ...options?.parsers }
+  let parseRow: ((msg: RowMessage) => Row) | undefined
+  // The parser for each column sent in binary, by index
+  let binaryColumns: (BinaryParser | undefined)[] = []
+  // The current result's rows, in 'columnar' row mode
+  let columnRows: RowMessage[] = []
 
   messages.forEach((message) => {
     switch (message.name) {
       case 'rowDescription': {
-        const msg = message as RowDescriptionMessage
-        currentResultSet.fields = msg.fields.map((field) => ({
-          name: field.name,
-          dataTypeID: field.dataTypeID,
-        }))
+        const result = describeResult(message as RowDescriptionMessage)
+        currentResultSet.fields = result.fields
+        binaryColumns = result.binaryColumns
+        parseRow = undefined
+        columnRows = []
         break
       }
       case 'dataRow': {
         if (!currentResultSet) break
-        const msg = message as DataRowMessage
-        if (options?.rowMode === 'array') {
-          // In array mode, rows contain arrays instead of objects
-          // Type assertion needed because Row type defaults to object
-          currentResultSet.rows.push(
-            msg.fields.map((field, i) =>
-              parseType(field, currentResultSet!.fields[i].dataTypeID, parsers),
-            ) as unknown as Row,
-          )
+        const msg = message as RowMessage
+        if (options?.rowMode === 'columnar') {
+          columnRows.push(msg)
         } else {
-          // rowMode === "object"
-          currentResultSet.rows.push(
-            Object.fromEntries(
-              msg.fields.map((field, i) => [
-                currentResultSet!.fields[i].name,
-                parseType(
-                  field,
-                  currentResultSet!.fields[i].dataTypeID,
-                  parsers,
-                ),
-              ]),
-            ),
+          parseRow ??= rowParser(
+            currentResultSet.fields,
+            binaryColumns,
+            parsers,
+            options,
           )
+          currentResultSet.rows.push(parseRow(msg))
         }
         break
       }
       case 'commandComplete': {
         const msg = message as CommandCompleteMessage
         affectedRows += retrieveRowCount(msg)
+        if (options?.rowMode === 'columnar') {
+          currentResultSet.columns = buildColumns(
+            currentResultSet.fields,
+            binaryColumns,
+            columnRows,
+            parsers,
+          )
+          columnRows = []
+        }
 
         resultSets.push({
           ...currentResultSet,
@@ -103,6 +430,31 @@ function retrieveRowCount(msg: CommandCompleteMessage): number {
   }
 }
 
+/**
+ * Build the parser for a result that arrives in batches of rows, like a
+ * portal executed with a row limit
+ * @param description The result's RowDescription
+ * @returns A function that parses the rows among one batch of messages
+ */
+export function batchRowParser(
+  description: RowDescriptionMessage,
+  defaultParsers: Record<number | string, Parser>,
+  options?: QueryIteratorOptions,
+): (messages: BackendMessage[]) => Row[] {
+  const parsers = { ...defaultParsers, ...options?.parsers }
+  const { fields, binaryColumns } = describeResult(description)
+  const parseRow = rowParser(fields, binaryColumns, parsers, options)
+  return (messages) => {
+    const rows: Row[] = []
+    for (const msg of messages) {
+      if (msg.name === 'dataRow') {
+        rows.push(parseRow(msg as RowMessage))
+      }
+    }
+    return rows
+  }
+}
+
 /** Get the dataTypeIDs from a list of messages, if it's available. */
 export function parseDescribeStatementResults(
   messages: Array<BackendMessage>,
@@ -123,6 +123,8 @@ export class PGlite
   #inputData = new Uint8Array(0)
   // write index in the buffer
   #writeOffset: number = 0
+  // output arena in WASM memory that send() appends to (0 if the build has none)
+  #outputArenaPtr: number = 0
 
   // Memory monitoring: track peak heap size observed during this session
   #peakHeapSize: number = 0
@@ -165,6 +167,10 @@ export class PGlite
       this.serializers = { ...this.serializers, ...options.serializers }
     }
 
+    if (options.statementCacheSize !== undefined) {
+      this._setStatementCacheSize(options.statementCacheSize)
+    }
+
     // Enable debug logging if requested
     if (options?.debug !== undefined) {
       this.debug = options.debug
@@ -474,40 +480,8 @@ export class PGlite
     // avoiding runtime WASM generation (addFunction) that Cloudflare blocks.
     // MUST be set BEFORE _pgl_initdb is called.
     this.mod._pgliteCallbacks = {
-      write: (ptr: number, length: number): number => {
-        let bytes
-        try {
-          bytes = this.mod!.HEAPU8.subarray(ptr, ptr + length)
-        } catch (e: any) {
-          console.error('error', e)
-          throw e
-        }
-        this.#protocolParser.parse(bytes, (msg) => {
-          this.#parse(msg)
-        })
-        if (this.#keepRawResponse) {
-          const copied = bytes.slice()
-
-          let requiredSize = this.#writeOffset + copied.length
-
-          if (requiredSize > this.#inputData.length) {
-            const newSize =
-              this.#inputData.length +
-              (this.#inputData.length >> 1) +
-              requiredSize
-            if (requiredSize > PGlite.MAX_BUFFER_SIZE) {
-              requiredSize = PGlite.MAX_BUFFER_SIZE
-            }
-            const newBuffer = new Uint8Array(newSize)
-            newBuffer.set(this.#inputData.subarray(0, this.#writeOffset))
-            this.#inputData = newBuffer
-          }
-
-          this.#inputData.set(copied, this.#writeOffset)
-          this.#writeOffset += copied.length
-        }
-        return length
-      },
+      write: (ptr: number, length: number): number =>
+        this.#handleWrite(ptr, length),
       read: (ptr: number, maxLength: number): number => {
         // copy current data to wasm buffer
         let length = this.#outputData.length - this.#readOffset
@@ -793,40 +767,8 @@ export class PGlite
     // Using _pgliteCallbacks for Cloudflare Workers compatibility.
     this.#log('pglite: re-registering callbacks after snapshot restore')
     this.mod._pgliteCallbacks = {
-      write: (ptr: number, length: number): number => {
-        let bytes
-        try {
-          bytes = this.mod!.HEAPU8.subarray(ptr, ptr + length)
-        } catch (e: any) {
-          console.error('error', e)
-          throw e
-        }
-        this.#protocolParser.parse(bytes, (msg) => {
-          this.#parse(msg)
-        })
-        if (this.#keepRawResponse) {
-          const copied = bytes.slice()
-
-          let requiredSize = this.#writeOffset + copied.length
-
-          if (requiredSize > this.#inputData.length) {
-            const newSize =
-              this.#inputData.length +
-              (this.#inputData.length >> 1) +
-              requiredSize
-            if (requiredSize > PGlite.MAX_BUFFER_SIZE) {
-              requiredSize = PGlite.MAX_BUFFER_SIZE
-            }
-            const newBuffer = new Uint8Array(newSize)
-            newBuffer.set(this.#inputData.subarray(0, this.#writeOffset))
-            this.#inputData = newBuffer
-          }
-
-          this.#inputData.set(copied, this.#writeOffset)
-          this.#writeOffset += copied.length
-        }
-        return length
-      },
+      write: (ptr: number, length: number): number =>
+        this.#handleWrite(ptr, length),
       read: (ptr: number, maxLength: number): number => {
         let length = this.#outputData.length - this.#readOffset
         if (length > maxLength) {
@@ -863,6 +805,14 @@ export class PGlite
     this.#log('pglite: restarting backend after snapshot restore')
     this.mod._pgl_backend()
 
+    // The restored heap holds the source's output arena, still active on the
+    // C side. Register it before the first query so JS drains it, and drop
+    // whatever the restart left in it
+    this.#initOutputArena()
+    if (this.#outputArenaPtr) {
+      this.mod._pglite_reset_output_arena!()
+    }
+
     // Sync changes to filesystem
     await this.syncToFs()
 
@@ -874,6 +824,10 @@ export class PGlite
     // Set the search path to public
     await this.exec('SET search_path TO public;')
 
+    // The source's statement cache prepared statements in the restored
+    // backend, under the names this instance's cache starts from again
+    await this.exec('DEALLOCATE ALL;')
+
     // Init array types
     await this._initArrayTypes()
 
@@ -1573,6 +1527,93 @@ export class PGlite
     }
   }
 
+  /**
+   * Handle bytes written by postgres through the write callback. With an
+   * output arena this only runs when a result overflows the arena.
+   */
+  #handleWrite(ptr: number, length: number): number {
+    let bytes
+    try {
+      bytes = this.mod!.HEAPU8.subarray(ptr, ptr + length)
+    } catch (e: any) {
+      console.error('error', e)
+      throw e
+    }
+    this.#protocolParser.parseInPlace(bytes, (msg) => {
+      this.#parse(msg)
+    })
+    if (this.#keepRawResponse) {
+      this.#appendRawResponse(bytes)
+    }
+    return length
+  }
+
+  /**
+   * Append response bytes to #inputData, growing it as needed. `bytes` may
+   * be a view into WASM memory; set() copies it directly, no slice needed.
+   */
+  #appendRawResponse(bytes: Uint8Array) {
+    let requiredSize = this.#writeOffset + bytes.length
+
+    if (requiredSize > this.#inputData.length) {
+      const newSize =
+        this.#inputData.length + (this.#inputData.length >> 1) + requiredSize
+      if (requiredSize > PGlite.MAX_BUFFER_SIZE) {
+        requiredSize = PGlite.MAX_BUFFER_SIZE
+      }
+      const newBuffer = new Uint8Array(newSize)
+      newBuffer.set(this.#inputData.subarray(0, this.#writeOffset))
+      this.#inputData = newBuffer
+    }
+
+    this.#inputData.set(bytes, this.#writeOffset)
+    this.#writeOffset += bytes.length
+  }
+
+  /**
+   * Register the output arena with the C comm layer, if the build supports it.
+   * Done lazily on the first query so that startup output still goes through
+   * the write callback. Safe to repeat, e.g. after a snapshot restore: the C
+   * side reuses the arena it already has.
+   */
+  #initOutputArena() {
+    const mod = this.mod!
+    if (mod._pglite_alloc_output_arena) {
+      this.#outputArenaPtr = mod._pglite_alloc_output_arena(
+        PGlite.DEFAULT_RECV_BUF_SIZE,
+      )
+    }
+  }
+
+  /**
+   * Parse whatever send() left in the output arena, in place: the parser
+   * reads messages straight from the heap view and copies only the rows it
+   * hands out lazily.
+   * @returns The raw response bytes if the caller keeps them
+   */
+  #drainOutputArena(): Uint8Array | undefined {
+    const mod = this.mod!
+    const used = mod._pglite_get_output_arena_used!()
+    if (used === 0) return undefined
+
+    const bytes = mod.HEAPU8.subarray(
+      this.#outputArenaPtr,
+      this.#outputArenaPtr + used,
+    )
+    this.#protocolParser.parseInPlace(bytes, (msg) => {
+      this.#parse(msg)
+    })
+    if (!this.#keepRawResponse) return undefined
+
+    if (this.#writeOffset === 0) {
+      // The whole response fit: this is the only copy we make
+      return bytes.slice()
+    }
+    // Earlier parts spilled through the write callback
+    this.#appendRawResponse(bytes)
+    return undefined
+  }
+
   /**
    * Execute a postgres wire protocol synchronously
    * @param message The postgres wire protocol message to execute
@@ -1585,19 +1626,33 @@ export class PGlite
     this.#writeOffset = 0
     this.#outputData = message
 
-    if (
-      this.#keepRawResponse &&
-      this.#inputData.length !== PGlite.DEFAULT_RECV_BUF_SIZE
-    ) {
+    if (!this.#outputArenaPtr) {
+      this.#initOutputArena()
+    }
+
+    // With an output arena #inputData only collects spilled results, so it
+    // can start empty
+    const recvBufSize = this.#outputArenaPtr ? 0 : PGlite.DEFAULT_RECV_BUF_SIZE
+    if (this.#keepRawResponse && this.#inputData.length !== recvBufSize) {
       // the previous call might have increased the size of the buffer so reset it to its default
-      this.#inputData = new Uint8Array(PGlite.DEFAULT_RECV_BUF_SIZE)
+      this.#inputData = new Uint8Array(recvBufSize)
+    }
+
+    if (this.#outputArenaPtr) {
+      mod._pglite_reset_output_arena!()
     }
+    mod._pglite_reset_comm_stats?.()
 
     // execute the message
     mod._interactive_one(message.length, message[0])
 
     this.#outputData = []
 
+    if (this.#outputArenaPtr) {
+      const data = this.#drainOutputArena()
+      if (data) return data
+    }
+
     if (this.#keepRawResponse && this.#writeOffset)
       return this.#inputData.subarray(0, this.#writeOffset)
     return new Uint8Array(0)
@@ -1636,6 +1691,7 @@ export class PGlite
       syncToFs = true,
       throwOnError = true,
       onNotice,
+      lazyDataRows = false,
     }: ExecProtocolOptions = {},
   ): Promise<ExecProtocolResult> {
     this.#currentThrowOnError = throwOnError
@@ -1643,7 +1699,13 @@ export class PGlite
     this.#currentResults = []
     this.#currentDatabaseError = null
 
-    const data = await this.execProtocolRaw(message, { syncToFs })
+    let data: Uint8Array
+    this.#protocolParser.lazyDataRows = lazyDataRows
+    try {
+      data = await this.execProtocolRaw(message, { syncToFs })
+    } finally {
+      this.#protocolParser.lazyDataRows = false
+    }
 
     const databaseError = this.#currentDatabaseError
     this.#currentThrowOnError = false
@@ -1667,7 +1729,12 @@ export class PGlite
    */
   async execProtocolStream(
     message: Uint8Array,
-    { syncToFs, throwOnError = true, onNotice }: ExecProtocolOptions = {},
+    {
+      syncToFs,
+      throwOnError = true,
+      onNotice,
+      lazyDataRows = false,
+    }: ExecProtocolOptions = {},
   ): Promise<BackendMessage[]> {
     this.#currentThrowOnError = throwOnError
     this.#currentOnNotice = onNotice
@@ -1675,10 +1742,13 @@ export class PGlite
     this.#currentDatabaseError = null
 
     this.#keepRawResponse = false
-
-    await this.execProtocolRaw(message, { syncToFs })
-
-    this.#keepRawResponse = true
+    this.#protocolParser.lazyDataRows = lazyDataRows
+    try {
+      await this.execProtocolRaw(message, { syncToFs })
+    } finally {
+      this.#keepRawResponse = true
+      this.#protocolParser.lazyDataRows = false
+    }
 
     const databaseError = this.#currentDatabaseError
     this.#currentThrowOnError = false
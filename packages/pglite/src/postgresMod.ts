@@ -58,6 +58,19 @@ export interface PostgresMod
   _pgl_reseed_random: (seed_high: number, seed_low: number) => void
   _interactive_write: (msgLength: number) => void
   _interactive_one: (length: number, peek: number) => void
+  /**
+   * Output arena (pglite-comm-trampoline.h). Optional: older builds send
+   * every write through _pgliteCallbacks.write instead.
+   */
+  _pglite_alloc_output_arena?: (capacity: number) => number
+  _pglite_get_output_arena_used?: () => number
+  _pglite_reset_output_arena?: () => void
+  /**
+   * Comm stats block, only in builds with -DPGLITE_COMM_STATS. Reset before
+   * every _interactive_one, so it describes the last query.
+   */
+  _pglite_get_comm_stats?: () => number
+  _pglite_reset_comm_stats?: () => void
   _set_read_write_cbs: (read_cb: number, write_cb: number) => void
   addFunction: (
     cb: (ptr: any, length: number) => void,
@@ -0,0 +1,170 @@
+import type {
+  BackendMessage,
+  CommandCompleteMessage,
+  DatabaseError,
+} from '@electric-sql/pg-protocol/messages'
+import type { StatementCacheStats } from './interface.js'
+
+export const DEFAULT_STATEMENT_CACHE_SIZE = 100
+
+// Command tags after which cached statements may describe the wrong schema,
+// or no longer exist on the backend. ROLLBACK covers DDL that was undone.
+const INVALIDATING_COMMAND =
+  /^(?:ALTER|CREATE|DROP|DISCARD|DEALLOCATE|IMPORT|ROLLBACK)\b/
+
+// Errors from executing a cached statement that mean it can't be used again:
+// feature_not_supported ("cached plan must not change result type") and
+// invalid_sql_statement_name. Outside a transaction the query is prepared
+// again and rerun.
+const INVALID_STATEMENT_CODES = new Set(['0A000', '26000'])
+
+export interface CachedStatement {
+  /** The name it's prepared under */
+  name: string
+  /** The messages from describing it, ParameterDescription first */
+  description: BackendMessage[]
+}
+
+/**
+ * An LRU cache of named prepared statements, keyed by query text and
+ * parameter types.
+ *
+ * The cache only tracks names; closing them on the backend is left to the
+ * caller, which sends a Close for each of {@link StatementCache.takeClosed}
+ * ahead of its next message.
+ */
+export class StatementCache {
+  #capacity: number
+  #statements = new Map<string, CachedStatement>()
+  #closed: string[] = []
+  #nextId = 0
+  #hits = 0
+  #misses = 0
+  #evictions = 0
+
+  constructor(capacity = DEFAULT_STATEMENT_CACHE_SIZE) {
+    this.#capacity = capacity
+  }
+
+  get enabled() {
+    return this.#capacity > 0
+  }
+
+  /**
+   * The key a query is cached under
+   */
+  static key(text: string, types?: number[]) {
+    return types?.length ? `${types.join(',')}:${text}` : text
+  }
+
+  /**
+   * Look up a statement, marking it as the most recently used
+   */
+  get(key: string): CachedStatement | undefined {
+    const statement = this.#statements.get(key)
+    if (statement) {
+      this.#hits++
+      this.#statements.delete(key)
+      this.#statements.set(key, statement)
+    } else {
+      this.#misses++
+    }
+    return statement
+  }
+
+  /**
+   * A fresh name to prepare a statement under
+   */
+  nextName() {
+    return `pglite_stmt_${this.#nextId++}`
+  }
+
+  /**
+   * Cache a prepared statement, evicting the least recently used one if full
+   */
+  set(key: string, statement: CachedStatement) {
+    this.#statements.set(key, statement)
+    if (this.#statements.size > this.#capacity) {
+      const [oldest] = this.#statements.keys()
+      this.delete(oldest)
+      this.#evictions++
+    }
+  }
+
+  /**
+   * Drop a cached statement
+   */
+  delete(key: string) {
+    const statement = this.#statements.get(key)
+    if (statement) {
+      this.#statements.delete(key)
+      this.#closed.push(statement.name)
+    }
+  }
+
+  /**
+   * Drop a statement that was prepared but never cached
+   */
+  discard(name: string) {
+    this.#closed.push(name)
+  }
+
+  /**
+   * Drop every cached statement
+   */
+  clear() {
+    for (const statement of this.#statements.values()) {
+      this.#closed.push(statement.name)
+    }
+    this.#statements.clear()
+  }
+
+  /**
+   * Drop a statement whose execution failed, if the error means it's no
+   * longer usable
+   * @returns Whether it was dropped
+   */
+  deleteIfInvalid(key: string, error: DatabaseError) {
+    if (error.code && INVALID_STATEMENT_CODES.has(error.code)) {
+      this.delete(key)
+      return true
+    }
+    return false
+  }
+
+  /**
+   * Clear the cache if any of the messages completed a command that can
+   * change the schema or deallocate statements
+   */
+  invalidate(messages: BackendMessage[]) {
+    if (this.#statements.size === 0) return
+    for (const msg of messages) {
+      if (
+        msg.name === 'commandComplete' &&
+        INVALIDATING_COMMAND.test((msg as CommandCompleteMessage).text)
+      ) {
+        this.clear()
+        return
+      }
+    }
+  }
+
+  /**
+   * The names dropped since the last call, to be closed on the backend
+   */
+  takeClosed(): string[] {
+    const closed = this.#closed
+    this.#closed = []
+    return closed
+  }
+
+  stats(): StatementCacheStats {
+    return {
+      hits: this.#hits,
+      misses: this.#misses,
+      evictions: this.#evictions,
+      size: this.#statements.size,
+      capacity: this.#capacity,
+    }
+  }
+}
@@ -231,6 +231,244 @@ function typeHandlers(types: TypeHandlers) {
   )
 }
 
+export type BinaryParser = (
+  view: DataView,
+  offset: number,
+  length: number,
+) => any
+
+// Result column format codes
+export const TEXT_FORMAT = 0
+export const BINARY_FORMAT = 1
+
+const utf8 = new TextDecoder()
+
+// 2000-01-01, the Postgres epoch
+const PG_EPOCH_MS = 946684800000
+const DAY_MS = 86400000
+
+// Shortest decimal that reads back as the same float4, which is what
+// Postgres prints
+function parseBinaryFloat4(view: DataView, offset: number) {
+  const x = view.getFloat32(offset)
+  if (!isFinite(x) || (Number.isInteger(x) && Math.abs(x) < 0x1000000)) {
+    return x
+  }
+  for (let precision = 1; precision < 9; precision++) {
+    const shortest = +x.toPrecision(precision)
+    if (Math.fround(shortest) === x) return shortest
+  }
+  return +x.toPrecision(9)
+}
+
+// Milliseconds since the Postgres epoch, floored, from the int64 count of
+// microseconds; exact without going through a BigInt
+function binaryTimestampMs(view: DataView, offset: number) {
+  const hi = view.getInt32(offset)
+  const lo = view.getUint32(offset + 4)
+  if (hi === 0x7fffffff && lo === 0xffffffff) return NaN // infinity
+  if (hi === -0x80000000 && lo === 0) return NaN // -infinity
+  // 2^32 = 4294967 * 1000 + 296
+  return hi * 4294967 + Math.floor((hi * 296 + lo) / 1000)
+}
+
+function parseBinaryTimestamp(view: DataView, offset: number) {
+  // The text format has no zone either, so it's read as local time
+  const utc = new Date(PG_EPOCH_MS + binaryTimestampMs(view, offset))
+  const local = new Date(
+    utc.getUTCFullYear(),
+    utc.getUTCMonth(),
+    utc.getUTCDate(),
+    utc.getUTCHours(),
+    utc.getUTCMinutes(),
+    utc.getUTCSeconds(),
+    utc.getUTCMilliseconds(),
+  )
+  // The Date constructor maps years 0-99 to 1900-1999
+  local.setFullYear(utc.getUTCFullYear())
+  return local
+}
+
+const NUMERIC_NEG = 0x4000
+const NUMERIC_NAN = 0xc000
+const NUMERIC_PINF = 0xd000
+const NUMERIC_NINF = 0xf000
+
+// Base 10000 digits back to the text Postgres would have sent; numerics
+// stay strings, as they do without a parser in text format
+function parseBinaryNumeric(view: DataView, offset: number) {
+  const ndigits = view.getInt16(offset)
+  const weight = view.getInt16(offset + 2)
+  const sign = view.getUint16(offset + 4)
+  const dscale = view.getInt16(offset + 6)
+  if (sign === NUMERIC_NAN) return 'NaN'
+  if (sign === NUMERIC_PINF) return 'Infinity'
+  if (sign === NUMERIC_NINF) return '-Infinity'
+
+  const digit = (i: number) =>
+    i >= 0 && i < ndigits ? view.getInt16(offset + 8 + i * 2) : 0
+  let text = sign === NUMERIC_NEG ? '-' : ''
+  if (weight < 0) {
+    text += '0'
+  } else {
+    text += digit(0)
+    for (let i = 1; i <= weight; i++) {
+      text += String(digit(i)).padStart(4, '0')
+    }
+  }
+  if (dscale > 0) {
+    let fraction = ''
+    for (let i = weight + 1; fraction.length < dscale; i++) {
+      fraction += String(digit(i)).padStart(4, '0')
+    }
+    text += '.' + fraction.slice(0, dscale)
+  }
+  return text
+}
+
+const hexBytes = Array.from({ length: 256 }, (_, i) =>
+  i.toString(16).padStart(2, '0'),
+)
+
+function parseBinaryUuid(view: DataView, offset: number) {
+  let hex = ''
+  for (let i = 0; i < 16; i++) {
+    if (i === 4 || i === 6 || i === 8 || i === 10) hex += '-'
+    hex += hexBytes[view.getUint8(offset + i)]
+  }
+  return hex
+}
+
+function parseBinaryBytes(view: DataView, offset: number, length: number) {
+  return new Uint8Array(view.buffer, view.byteOffset + offset, length).slice()
+}
+
+function parseBinaryText(view: DataView, offset: number, length: number) {
+  return utf8.decode(
+    new Uint8Array(view.buffer, view.byteOffset + offset, length),
+  )
+}
+
+// Header: ndim, has nulls, element type, then a size and lower bound per
+// dimension. Elements follow in row-major order, each with its length.
+function parseBinaryArray(view: DataView, offset: number): any[] {
+  const ndim = view.getInt32(offset)
+  if (ndim === 0) return []
+  const parse = binaryParsers[view.getUint32(offset + 8)] ?? parseBinaryBytes
+  const dims: number[] = []
+  let at = offset + 12
+  for (let i = 0; i < ndim; i++, at += 8) {
+    dims.push(view.getInt32(at))
+  }
+  const readDimension = (dim: number): any[] => {
+    const xs = new Array(dims[dim])
+    for (let i = 0; i < xs.length; i++) {
+      if (dim < ndim - 1) {
+        xs[i] = readDimension(dim + 1)
+        continue
+      }
+      const length = view.getInt32(at)
+      at += 4
+      if (length === -1) {
+        xs[i] = null
+      } else {
+        xs[i] = parse(view, at, length)
+        at += length
+      }
+    }
+    return xs
+  }
+  return readDimension(0)
+}
+
+/**
+ * Array types with a binary parser for their elements, by array type
+ */
+const binaryArrayElementTypes: { [key: number]: number } = {
+  1000: BOOL,
+  1001: BYTEA,
+  1005: INT2,
+  1007: INT4,
+  1009: TEXT,
+  1014: BPCHAR,
+  1015: VARCHAR,
+  1016: INT8,
+  1021: FLOAT4,
+  1022: FLOAT8,
+  1028: OID,
+  1115: TIMESTAMP,
+  1182: DATE,
+  1185: TIMESTAMPTZ,
+  1231: NUMERIC,
+  2951: UUID,
+}
+
+/**
+ * Parsers for results sent in binary format. Each gives the same value the
+ * default text parser gives for the type.
+ */
+export const binaryParsers: { [key: number]: BinaryParser } = {
+  [BOOL]: (view, offset) => view.getUint8(offset) !== 0,
+  [BYTEA]: parseBinaryBytes,
+  [INT2]: (view, offset) => view.getInt16(offset),
+  [INT4]: (view, offset) => view.getInt32(offset),
+  [INT8]: (view, offset) => {
+    const n = view.getInt32(offset) * 4294967296 + view.getUint32(offset + 4)
+    // Out of the safe range the sum may have been rounded, so take the
+    // exact value as a BigInt, as the text parser does
+    return Number.isSafeInteger(n) ? n : view.getBigInt64(offset)
+  },
+  [OID]: (view, offset) => view.getUint32(offset),
+  [FLOAT4]: parseBinaryFloat4,
+  [FLOAT8]: (view, offset) => view.getFloat64(offset),
+  [TEXT]: parseBinaryText,
+  [VARCHAR]: parseBinaryText,
+  [BPCHAR]: parseBinaryText,
+  [NUMERIC]: parseBinaryNumeric,
+  [UUID]: parseBinaryUuid,
+  [DATE]: (view, offset) => {
+    const days = view.getInt32(offset)
+    // int32 max and min are infinity and -infinity
+    return days === 0x7fffffff || days === -0x80000000
+      ? new Date(NaN)
+      : new Date(PG_EPOCH_MS + days * DAY_MS)
+  },
+  [TIMESTAMP]: parseBinaryTimestamp,
+  [TIMESTAMPTZ]: (view, offset) =>
+    new Date(PG_EPOCH_MS + binaryTimestampMs(view, offset)),
+}
+for (const arrayType in binaryArrayElementTypes) {
+  binaryParsers[arrayType] = parseBinaryArray
+}
+
+/**
+ * Whether a result column can be sent in binary: there is a binary parser
+ * for its type, or its element type, and the text parser it would otherwise
+ * go through is the default one, so both formats give the same value
+ * @param type The column's type
+ * @param parsers The instance's parsers
+ * @param queryParsers Parsers passed with the query
+ */
+export function canParseBinary(
+  type: number,
+  parsers: ParserOptions,
+  queryParsers?: ParserOptions,
+): boolean {
+  if (queryParsers?.[type]) return false
+  const elementType = binaryArrayElementTypes[type]
+  if (elementType !== undefined) {
+    // Text arrays are only parsed once their types have been loaded
+    return (
+      parsers[type] !== undefined &&
+      parsers[elementType] === defaultHandlers.parsers[elementType]
+    )
+  }
+  return (
+    binaryParsers[type] !== undefined &&
+    parsers[type] === defaultHandlers.parsers[type]
+  )
+}
+
 const escapeBackslash = /\\/g
 const escapeQuote = /"/g
 
@@ -1,5 +1,6 @@
 import type {
   DebugLevel,
+  ExecProtocolOptions,
   ExecProtocolResult,
   Extensions,
   MemoryStats,
@@ -12,7 +13,11 @@ import type { PGlite } from '../pglite.js'
 import { BasePGlite } from '../base.js'
 import { toPostgresName, uuid } from '../utils.js'
 import { DumpTarCompressionOptions } from '../fs/tarUtils.js'
-import { BackendMessage } from '@electric-sql/pg-protocol/messages'
+import {
+  BackendMessage,
+  DatabaseError,
+  LazyDataRowMessage,
+} from '@electric-sql/pg-protocol/messages'
 
 export type PGliteWorkerOptions<E extends Extensions = Extensions> =
   PGliteOptions<E> & {
@@ -54,6 +59,9 @@ export class PGliteWorker
 
   constructor(worker: Worker, options?: PGliteWorkerOptions) {
     super()
+    // The backend is shared by every tab and replaced when the leader changes,
+    // so statements prepared by one client can't be relied on
+    this._setStatementCacheSize(0)
     this.#workerProcess = worker
     this.#tabId = uuid()
     this.#extensions = options?.extensions ?? {}
@@ -342,8 +350,16 @@ export class PGliteWorker
    * @param message The postgres wire protocol message to execute
    * @returns The result of the query
    */
-  async execProtocol(message: Uint8Array): Promise<ExecProtocolResult> {
-    return await this.#rpc('execProtocol', message)
+  async execProtocol(
+    message: Uint8Array,
+    { lazyDataRows, throwOnError }: ExecProtocolOptions = {},
+  ): Promise<ExecProtocolResult> {
+    const result: ExecProtocolResult = await this.#rpc(
+      'execProtocol',
+      message,
+      { lazyDataRows, throwOnError },
+    )
+    return { ...result, messages: restoreMessages(result.messages) }
   }
 
   /**
@@ -351,8 +367,16 @@ export class PGliteWorker
    * @param message The postgres wire protocol message to execute
    * @returns The result of the query
    */
-  async execProtocolStream(message: Uint8Array): Promise<BackendMessage[]> {
-    return await this.#rpc('execProtocolStream', message)
+  async execProtocolStream(
+    message: Uint8Array,
+    { lazyDataRows, throwOnError }: ExecProtocolOptions = {},
+  ): Promise<BackendMessage[]> {
+    return restoreMessages(
+      await this.#rpc('execProtocolStream', message, {
+        lazyDataRows,
+        throwOnError,
+      }),
+    )
   }
 
   /**
@@ -642,8 +666,10 @@ function makeWorkerApi(tabId: string, db: PGlite) {
     async close() {
       await db.close()
     },
-    async execProtocol(message: Uint8Array) {
-      const { messages, data } = await db.execProtocol(message)
+    async execProtocol(message: Uint8Array, options?: RpcExecProtocolOptions) {
+      const result = await db.execProtocol(message, options)
+      const messages = cloneableMessages(result.messages)
+      const data = result.data
       if (data.byteLength !== data.buffer.byteLength) {
         const buffer = new ArrayBuffer(data.byteLength)
         const dataCopy = new Uint8Array(buffer)
@@ -653,9 +679,12 @@ function makeWorkerApi(tabId: string, db: PGlite) {
         return { messages, data }
       }
     },
-    async execProtocolStream(message: Uint8Array) {
-      const messages = await db.execProtocolStream(message)
-      return messages
+    async execProtocolStream(
+      message: Uint8Array,
+      options?: RpcExecProtocolOptions,
+    ) {
+      const messages = await db.execProtocolStream(message, options)
+      return cloneableMessages(messages)
     },
     async execProtocolRaw(message: Uint8Array) {
       const result = await db.execProtocolRaw(message)
@@ -767,3 +796,61 @@ type WorkerRpcError = {
 type WorkerRpcResponse<Method extends WorkerRpcMethod> =
   | WorkerRpcResult<Method>
   | WorkerRpcError
+
+/** The execProtocol options that can be sent to the leader */
+type RpcExecProtocolOptions = Pick<
+  ExecProtocolOptions,
+  'lazyDataRows' | 'throwOnError'
+>
+
+type ClonedDataRow = Pick<
+  LazyDataRowMessage,
+  'name' | 'length' | 'fieldCount' | 'raw'
+>
+
+type ClonedDatabaseError = Omit<DatabaseError, 'stack' | 'cause'>
+
+/**
+ * Lazy rows keep their bytes in private fields, which postMessage drops;
+ * send the bytes and index they read from instead. The rows of a response
+ * share these buffers, so they are only copied once.
+ * Errors keep only their message through postMessage, so their fields are
+ * sent as a plain object.
+ */
+function cloneableMessages(messages: BackendMessage[]): BackendMessage[] {
+  return messages.map((msg) => {
+    if (msg instanceof LazyDataRowMessage) {
+      return {
+        name: msg.name,
+        length: msg.length,
+        fieldCount: msg.fieldCount,
+        raw: msg.raw,
+      } satisfies ClonedDataRow
+    }
+    if (msg instanceof DatabaseError) {
+      return { ...msg, message: msg.message } satisfies ClonedDatabaseError
+    }
+    return msg
+  })
+}
+
+/** Rebuild the lazy rows and errors sent by cloneableMessages */
+function restoreMessages(messages: BackendMessage[]): BackendMessage[] {
+  return messages.map((msg) => {
+    if (msg.name === 'dataRow' && 'raw' in msg) {
+      const { length, fieldCount, raw } = msg as ClonedDataRow
+      return new LazyDataRowMessage(
+        length,
+        fieldCount,
+        raw.bytes,
+        raw.columns,
+        raw.first,
+      )
+    }
+    if (msg.name === 'error' && !(msg instanceof DatabaseError)) {
+      const { message, length, name, ...fields } = msg as ClonedDatabaseError
+      return Object.assign(new DatabaseError(message, length, name), fields)
+    }
+    return msg
+  })
+}
@@ -627,6 +627,25 @@ await testEsmCjsAndDTC(async (importType) => {
         affectedRows: 0,
       })
     })
+
+    it('duplicate column names', async () => {
+      const db = new PGlite()
+      const result = await db.query(
+        `SELECT 1 AS a, 'x' AS "__proto__", 2 AS b, 3 AS a`,
+      )
+      const [row] = result.rows as Record<string, unknown>[]
+      expect(Object.keys(row)).toEqual(['a', '__proto__', 'b'])
+      expect(row.a).toBe(3)
+      expect(Object.getPrototypeOf(row)).toBe(Object.prototype)
+      expect(Object.getOwnPropertyDescriptor(row, '__proto__')?.value).toBe(
+        'x',
+      )
+
+      const arrays = await db.query(`SELECT 1 AS a, 2 AS a`, [], {
+        rowMode: 'array',
+      })
+      expect(arrays.rows).toEqual([[1, 2]])
+    })
     it('timezone', async () => {
       const db = new PGlite()
 
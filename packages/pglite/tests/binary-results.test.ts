@@ -0,0 +1,122 @@
+import { describe, it, expect, beforeAll, afterAll } from 'vitest'
+import { PGlite, types } from '../dist/index.js'
+
+describe('binary results', () => {
+  let db: PGlite
+
+  beforeAll(async () => {
+    db = await PGlite.create()
+    await db.exec(`
+      CREATE TABLE typed (
+        i2 int2,
+        i4 int4,
+        i8 int8,
+        big int8,
+        o oid,
+        f4 float4,
+        f8 float8,
+        b bool,
+        bin bytea,
+        u uuid,
+        d date,
+        ts timestamp,
+        tz timestamptz,
+        n numeric,
+        small numeric(10, 6),
+        t text,
+        vc varchar(20),
+        ints int4[],
+        grid int4[][],
+        words text[],
+        stamps timestamptz[],
+        j jsonb
+      );
+      INSERT INTO typed VALUES (
+        -12, 2147483647, -9007199254740991, 9223372036854775807, 4000000000,
+        1.1, 0.1, true, '\\xdead00', 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11',
+        '2024-02-29', '2024-07-01 02:03:04.005',
+        '2024-01-15 10:30:00.123456+00', -123456.789, 0.000005, 'ünï ✓',
+        'short', '{1,2,3}', '{{1,2},{3,4}}', '{"a,b","\\"q\\""}',
+        '{"2024-01-15 10:30:00+00"}', '{"a": 1}'
+      ), (
+        NULL, NULL, NULL, NULL, NULL, 'NaN', '-Infinity', false, '', NULL,
+        'infinity', '-infinity', 'infinity', 'NaN', 0, '', NULL, '{}', NULL,
+        '{}', NULL, NULL
+      );
+    `)
+  })
+
+  afterAll(async () => {
+    await db.close()
+  })
+
+  it('parses the same values as text results', async () => {
+    const query = 'SELECT * FROM typed'
+    const text = await db.query(query)
+    const binary = await db.query(query, [], { resultFormat: 'binary' })
+
+    expect(binary.fields).toEqual(text.fields)
+    expect(binary.rows).toEqual(text.rows)
+    expect(binary.rows[0]).toMatchObject({
+      big: 9223372036854775807n,
+      f4: 1.1,
+      bin: new Uint8Array([0xde, 0xad, 0x00]),
+      u: 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11',
+      n: '-123456.789',
+      small: '0.000005',
+      grid: [
+        [1, 2],
+        [3, 4],
+      ],
+      words: ['a,b', '"q"'],
+      j: { a: 1 },
+    })
+  })
+
+  it('works with lazy and array rows', async () => {
+    const query = 'SELECT i4, tz, words FROM typed'
+    const text = await db.query(query, [], { rowMode: 'array' })
+    const binary = await db.query(query, [], {
+      resultFormat: 'binary',
+      rowMode: 'array',
+      lazyRows: true,
+    })
+    expect(binary.rows).toEqual(text.rows)
+  })
+
+  it('binds parameters as usual', async () => {
+    const res = await db.query<{ i4: number }>(
+      'SELECT i4 FROM typed WHERE i2 = $1',
+      [-12],
+      { resultFormat: 'binary' },
+    )
+    expect(res.rows).toEqual([{ i4: 2147483647 }])
+  })
+
+  it('keeps columns with custom parsers in text', async () => {
+    const parsed: string[] = []
+    const res = await db.query<{ i4: number; t: string }>(
+      'SELECT i4, t FROM typed WHERE i4 IS NOT NULL',
+      [],
+      {
+        resultFormat: 'binary',
+        parsers: {
+          [types.INT4]: (value) => {
+            parsed.push(value)
+            return Number(value)
+          },
+        },
+      },
+    )
+    expect(parsed).toEqual(['2147483647'])
+    expect(res.rows).toEqual([{ i4: 2147483647, t: 'ünï ✓' }])
+  })
+
+  it('handles statements without results', async () => {
+    const res = await db.query('UPDATE typed SET b = b', [], {
+      resultFormat: 'binary',
+    })
+    expect(res.affectedRows).toBe(2)
+    expect(res.rows).toEqual([])
+  })
+})
@@ -0,0 +1,104 @@
+import { describe, it, expect, beforeAll, afterAll } from 'vitest'
+import { PGlite, types, type Column } from '../dist/index.js'
+
+function isNull(column: Column, row: number) {
+  return (column.nulls[row >> 3] & (1 << (row & 7))) !== 0
+}
+
+describe('columnar rowMode', () => {
+  let db: PGlite
+
+  beforeAll(async () => {
+    db = await PGlite.create()
+    await db.exec(`
+      CREATE TABLE measurement (
+        id int4,
+        small int2,
+        total int8,
+        ratio float8,
+        label text
+      );
+      INSERT INTO measurement
+        SELECT i, -i, i * 10000000000, i / 4.0, 'label ' || i
+        FROM generate_series(1, 20) AS i;
+      INSERT INTO measurement VALUES (21, NULL, NULL, NULL, NULL);
+    `)
+  })
+
+  afterAll(async () => {
+    await db.close()
+  })
+
+  it('returns typed arrays for numeric columns', async () => {
+    const res = await db.query(
+      'SELECT id, small, total, ratio, label FROM measurement ORDER BY id',
+      [],
+      { rowMode: 'columnar' },
+    )
+    expect(res.rows).toEqual([])
+    expect(res.fields.map((field) => field.name)).toEqual([
+      'id',
+      'small',
+      'total',
+      'ratio',
+      'label',
+    ])
+
+    const [id, small, total, ratio, label] = res.columns!
+    expect(id.values).toBeInstanceOf(Int32Array)
+    expect(small.values).toBeInstanceOf(Int32Array)
+    expect(total.values).toBeInstanceOf(BigInt64Array)
+    expect(ratio.values).toBeInstanceOf(Float64Array)
+    expect(Array.isArray(label.values)).toBe(true)
+
+    expect(id.values.length).toBe(21)
+    expect(id.values[0]).toBe(1)
+    expect(small.values[1]).toBe(-2)
+    expect(total.values[2]).toBe(30000000000n)
+    expect(ratio.values[3]).toBe(1)
+    expect(label.values[4]).toBe('label 5')
+  })
+
+  it('marks nulls in the bitmap', async () => {
+    const res = await db.query(
+      'SELECT small, label FROM measurement ORDER BY id',
+      [],
+      { rowMode: 'columnar' },
+    )
+    const [small, label] = res.columns!
+    expect(isNull(small, 19)).toBe(false)
+    expect(isNull(small, 20)).toBe(true)
+    expect(small.values[20]).toBe(0)
+    expect(isNull(label, 20)).toBe(true)
+    expect(label.values[20]).toBeNull()
+    expect(small.nulls).toHaveLength(3)
+  })
+
+  it('matches row results in binary format', async () => {
+    const query = 'SELECT id, total, ratio FROM measurement ORDER BY id'
+    const text = await db.query(query, [], { rowMode: 'columnar' })
+    const binary = await db.query(query, [], {
+      rowMode: 'columnar',
+      resultFormat: 'binary',
+    })
+    expect(binary.columns).toEqual(text.columns)
+  })
+
+  it('keeps values from custom parsers', async () => {
+    const res = await db.query('SELECT id FROM measurement ORDER BY id', [], {
+      rowMode: 'columnar',
+      parsers: { [types.INT4]: (value) => `#${value}` },
+    })
+    expect(res.columns![0].values.slice(0, 2)).toEqual(['#1', '#2'])
+  })
+
+  it('returns columns for each statement of exec', async () => {
+    const results = await db.exec(
+      'SELECT 1 AS one; UPDATE measurement SET id = id WHERE id > 20;',
+      { rowMode: 'columnar' },
+    )
+    expect(results[0].columns![0].values).toEqual(new Int32Array([1]))
+    expect(results[1].columns).toEqual([])
+    expect(results[1].affectedRows).toBe(1)
+  })
+})
@@ -1,5 +1,5 @@
 import { describe, it, expect, beforeAll, afterAll } from 'vitest'
-import { PGlite } from '../dist/index.js'
+import { PGlite, messages } from '../dist/index.js'
 import { serialize } from '@electric-sql/pg-protocol'
 
 describe('exec protocol', () => {
@@ -51,6 +51,50 @@ describe('exec protocol', () => {
     expect(messageNames5).toEqual(['readyForQuery'])
   })
 
+  it('should return raw data that survives the next query', async () => {
+    const r1 = await db.execProtocolRaw(serialize.query("SELECT 'first'"))
+    const before = r1.slice()
+    await db.execProtocolRaw(serialize.query("SELECT 'second', 'query'"))
+    expect(r1).toEqual(before)
+  })
+
+  it('should return large raw responses intact', async () => {
+    // Larger than the 1MB output arena, so part of it spills
+    const result = await db.execProtocol(
+      serialize.query(
+        'SELECT repeat($$x$$, 1000) FROM generate_series(1, 2000)',
+      ),
+    )
+    const rows = result.messages.filter((msg) => msg.name === 'dataRow')
+    expect(rows.length).toBe(2000)
+    expect(result.data.length).toBeGreaterThan(2000 * 1000)
+    expect(result.data[result.data.length - 6]).toBe(0x5a) // ReadyForQuery
+  })
+
+  it('should return plain dataRow messages', async () => {
+    const query = serialize.query("SELECT 1 AS one, 'two' AS two, NULL")
+    const expected = {
+      name: 'dataRow',
+      length: 22,
+      fieldCount: 3,
+      fields: ['1', 'two', null],
+    }
+    const result = await db.execProtocol(query)
+    const streamed = await db.execProtocolStream(query)
+    for (const row of [result.messages[1], streamed[1]]) {
+      expect(row).toBeInstanceOf(messages.DataRowMessage)
+      expect(row).toEqual(expected)
+      expect(Object.keys(row)).toContain('fields')
+      expect((row as messages.DataRowMessage).field(1)).toBe('two')
+    }
+
+    const lazy = await db.execProtocolStream(query, { lazyDataRows: true })
+    expect(lazy[1]).toBeInstanceOf(messages.LazyDataRowMessage)
+    expect((lazy[1] as messages.LazyDataRowMessage).fields).toEqual(
+      expected.fields,
+    )
+  })
+
   it('should handle error', async () => {
     const result = await db.execProtocol(serialize.query('invalid sql'), {
       throwOnError: false,
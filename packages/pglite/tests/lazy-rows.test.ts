@@ -0,0 +1,83 @@
+import { describe, it, expect, beforeEach, afterEach } from 'vitest'
+import { PGlite, types } from '../dist/index.js'
+
+describe('lazyRows', () => {
+  let db: PGlite
+
+  beforeEach(async () => {
+    db = await PGlite.create()
+    await db.exec(`
+      CREATE TABLE todo (
+        id SERIAL PRIMARY KEY,
+        task TEXT,
+        done BOOLEAN
+      );
+      INSERT INTO todo (task, done)
+        SELECT 'task ' || i, i % 2 = 0 FROM generate_series(1, 100) AS i;
+    `)
+  })
+
+  afterEach(async () => {
+    await db.close()
+  })
+
+  it('returns the same rows as an eager query', async () => {
+    const query = 'SELECT * FROM todo ORDER BY id'
+    const eager = await db.query(query)
+    const lazy = await db.query(query, [], { lazyRows: true })
+
+    expect(lazy.rows).toEqual(eager.rows)
+    expect(lazy.fields).toEqual(eager.fields)
+    expect(JSON.stringify(lazy.rows)).toBe(JSON.stringify(eager.rows))
+    expect(Object.keys(lazy.rows[0])).toEqual(['id', 'task', 'done'])
+    expect({ ...lazy.rows[1] }).toEqual({ id: 2, task: 'task 2', done: true })
+  })
+
+  it('only parses the columns that are read', async () => {
+    const parsed: string[] = []
+    const res = await db.query<{ id: number; task: string }>(
+      'SELECT id, task FROM todo ORDER BY id',
+      [],
+      {
+        lazyRows: true,
+        parsers: {
+          [types.INT4]: (value) => {
+            parsed.push(value)
+            return Number(value)
+          },
+        },
+      },
+    )
+    expect(parsed).toEqual([])
+
+    const page = res.rows.slice(0, 3).map((row) => row.id)
+    expect(page).toEqual([1, 2, 3])
+    expect(parsed).toEqual(['1', '2', '3'])
+
+    // A column is parsed once, then read like any other property
+    expect(res.rows[0].id).toBe(1)
+    expect(parsed).toHaveLength(3)
+  })
+
+  it('supports array rows', async () => {
+    const res = await db.query('SELECT id, task FROM todo WHERE id <= 2', [], {
+      lazyRows: true,
+      rowMode: 'array',
+    })
+    expect(res.rows).toEqual([
+      [1, 'task 1'],
+      [2, 'task 2'],
+    ])
+    expect(Array.isArray(res.rows[0])).toBe(true)
+  })
+
+  it('lets rows be modified', async () => {
+    const res = await db.query<{ task: string }>(
+      'SELECT task FROM todo WHERE id = 1',
+      [],
+      { lazyRows: true },
+    )
+    res.rows[0].task = 'changed'
+    expect(res.rows[0]).toEqual({ task: 'changed' })
+  })
+})
@@ -0,0 +1,131 @@
+import { describe, it, expect, beforeEach, afterEach, vi } from 'vitest'
+import { PGlite } from '../dist/index.js'
+
+describe('pipeline', () => {
+  let db: PGlite
+
+  beforeEach(async () => {
+    db = await PGlite.create()
+    await db.exec(`
+      CREATE TABLE todo (
+        id SERIAL PRIMARY KEY,
+        task TEXT,
+        done BOOLEAN
+      );
+    `)
+  })
+
+  afterEach(async () => {
+    await db.close()
+  })
+
+  it('resolves each query with its own result', async () => {
+    const pipeline = db.pipeline()
+    const inserts = [1, 2, 3].map((i) =>
+      pipeline.query<{ id: number }>(
+        'INSERT INTO todo (task, done) VALUES ($1, $2) RETURNING id',
+        [`task ${i}`, i % 2 === 0],
+      ),
+    )
+    const select = pipeline.query<{ task: string; done: boolean }>(
+      'SELECT task, done FROM todo WHERE done = $1 ORDER BY id',
+      [false],
+    )
+    const results = await pipeline.run()
+
+    expect(results).toHaveLength(4)
+    expect((await inserts[0]).rows).toEqual([{ id: 1 }])
+    expect((await inserts[2]).affectedRows).toBe(1)
+    expect((await select).rows).toEqual([
+      { task: 'task 1', done: false },
+      { task: 'task 3', done: false },
+    ])
+    expect(results[3]).toBe(await select)
+  })
+
+  it('sends the whole batch in one round trip', async () => {
+    const execProtocolStream = vi.spyOn(db, 'execProtocolStream')
+
+    // Statements with parameters are described once per query text first
+    const described = db.pipeline()
+    for (let i = 0; i < 100; i++) {
+      described.query('INSERT INTO todo (task) VALUES ($1)', [`task ${i}`])
+    }
+    await described.run()
+    expect(execProtocolStream).toHaveBeenCalledTimes(2)
+
+    execProtocolStream.mockClear()
+    const typed = db.pipeline()
+    for (let i = 0; i < 100; i++) {
+      typed.query('INSERT INTO todo (task) VALUES ($1)', [`task ${i}`], {
+        paramTypes: [25],
+      })
+    }
+    await typed.run()
+    expect(execProtocolStream).toHaveBeenCalledTimes(1)
+
+    const count = await db.query<{ count: number }>(
+      'SELECT count(*)::int AS count FROM todo',
+    )
+    expect(count.rows[0].count).toBe(200)
+  })
+
+  it('supports templated queries', async () => {
+    const pipeline = db.pipeline()
+    const task = 'templated'
+    pipeline.sql`INSERT INTO todo (task) VALUES (${task})`
+    const select = pipeline.sql<{ task: string }>`SELECT task FROM todo`
+    await pipeline.run()
+
+    expect((await select).rows).toEqual([{ task: 'templated' }])
+  })
+
+  it('rolls back the whole batch when a statement fails', async () => {
+    const pipeline = db.pipeline()
+    const first = pipeline.query('INSERT INTO todo (task) VALUES ($1)', ['a'])
+    // The first insert already took id 1
+    const failing = pipeline.query('INSERT INTO todo (id) VALUES ($1)', [1])
+    const last = pipeline.query('INSERT INTO todo (task) VALUES ($1)', ['b'])
+
+    await expect(pipeline.run()).rejects.toThrow('duplicate key')
+    await expect(failing).rejects.toThrow('duplicate key')
+    await expect(first).rejects.toThrow('Pipeline aborted: statement 2 of 3')
+    await expect(last).rejects.toThrow('Pipeline aborted')
+
+    const res = await db.query('SELECT * FROM todo')
+    expect(res.rows).toEqual([])
+  })
+
+  it('rejects a batch with an invalid statement before running any', async () => {
+    const pipeline = db.pipeline()
+    const valid = pipeline.query('INSERT INTO todo (task) VALUES ($1)', ['a'])
+    const invalid = pipeline.query('SELECT * FROM missing WHERE id = $1', [1])
+
+    await expect(pipeline.run()).rejects.toThrow('does not exist')
+    await expect(invalid).rejects.toThrow('does not exist')
+    await expect(valid).rejects.toThrow('Pipeline aborted')
+
+    // The connection is usable again afterwards
+    const res = await db.query('SELECT count(*)::int AS count FROM todo')
+    expect(res.rows).toEqual([{ count: 0 }])
+  })
+
+  it('runs inside a transaction', async () => {
+    await db.transaction(async (tx) => {
+      const pipeline = tx.pipeline()
+      pipeline.query('INSERT INTO todo (task) VALUES ($1)', ['a'])
+      pipeline.query('INSERT INTO todo (task) VALUES ($1)', ['b'])
+      await pipeline.run()
+      await tx.rollback()
+    })
+
+    const res = await db.query('SELECT * FROM todo')
+    expect(res.rows).toEqual([])
+  })
+
+  it('resolves an empty pipeline without touching the backend', async () => {
+    const execProtocolStream = vi.spyOn(db, 'execProtocolStream')
+    expect(await db.pipeline().run()).toEqual([])
+    expect(execProtocolStream).not.toHaveBeenCalled()
+  })
+})
@@ -0,0 +1,179 @@
+import { describe, it, expect, beforeAll, afterAll } from 'vitest'
+import { PGlite } from '../dist/index.js'
+
+describe('queryIterator', () => {
+  let db: PGlite
+
+  beforeAll(async () => {
+    db = await PGlite.create()
+    await db.exec(`
+      CREATE TABLE event (id int4, label text);
+      INSERT INTO event
+        SELECT i, 'event ' || i FROM generate_series(1, 2500) AS i;
+    `)
+  })
+
+  afterAll(async () => {
+    await db.close()
+  })
+
+  it('yields every row, in batches', async () => {
+    const rows: { id: number; label: string }[] = []
+    for await (const row of db.queryIterator<{ id: number; label: string }>(
+      'SELECT * FROM event WHERE id > $1 ORDER BY id',
+      [100],
+      { batchSize: 300 },
+    )) {
+      rows.push(row)
+    }
+    expect(rows).toHaveLength(2400)
+    expect(rows[0]).toEqual({ id: 101, label: 'event 101' })
+    expect(rows[2399]).toEqual({ id: 2500, label: 'event 2500' })
+  })
+
+  it('matches the rows of query()', async () => {
+    const query = 'SELECT id, label FROM event WHERE id <= 10 ORDER BY id'
+    const expected = await db.query(query, [], { rowMode: 'array' })
+    for (const options of [
+      { rowMode: 'array' as const, batchSize: 3 },
+      { rowMode: 'array' as const, batchSize: 3, lazyRows: true },
+      { rowMode: 'array' as const, resultFormat: 'binary' as const },
+    ]) {
+      const rows: unknown[] = []
+      for await (const row of db.queryIterator(query, [], options)) {
+        rows.push(row)
+      }
+      expect(rows).toEqual(expected.rows)
+    }
+  })
+
+  it('closes the portal when the loop ends early', async () => {
+    let count = 0
+    for await (const _row of db.queryIterator('SELECT * FROM event', [], {
+      batchSize: 10,
+    })) {
+      if (++count === 15) break
+    }
+    expect(count).toBe(15)
+
+    // The connection is usable again, outside any transaction
+    expect((await db.query('SELECT 1 AS one')).rows).toEqual([{ one: 1 }])
+    await db.transaction(async (tx) => {
+      await tx.query('SELECT 1')
+    })
+  })
+
+  it('does not block other queries when abandoned', async () => {
+    const iterator = db.queryIterator<{ id: number }>(
+      'SELECT id FROM event ORDER BY id',
+      [],
+      { batchSize: 5 },
+    )
+    expect((await iterator.next()).value).toEqual({ id: 1 })
+
+    // Never resumed nor returned
+    const timeout = new Promise((_, reject) =>
+      setTimeout(() => reject(new Error('query() was blocked')), 1000),
+    )
+    const result = await Promise.race([db.query('SELECT 1 AS one'), timeout])
+    expect(result).toMatchObject({ rows: [{ one: 1 }] })
+  })
+
+  it('is interrupted by a query run between batches', async () => {
+    const iterate = async () => {
+      for await (const _row of db.queryIterator(
+        'SELECT id FROM event ORDER BY id',
+        [],
+        { batchSize: 5 },
+      )) {
+        await db.query('SELECT 1')
+      }
+    }
+    await expect(iterate()).rejects.toThrow('interrupted')
+    expect((await db.query('SELECT 1 AS one')).rows).toEqual([{ one: 1 }])
+  })
+
+  it('rejects with errors raised while fetching', async () => {
+    const iterate = async () => {
+      for await (const _row of db.queryIterator(
+        'SELECT 1 / (id - 1500) FROM event ORDER BY id',
+        [],
+        { batchSize: 100 },
+      )) {
+        // drain
+      }
+    }
+    await expect(iterate()).rejects.toThrow('division by zero')
+    expect((await db.query('SELECT 1 AS one')).rows).toEqual([{ one: 1 }])
+  })
+
+  it('runs statements without rows', async () => {
+    const rows: unknown[] = []
+    for await (const row of db.queryIterator(
+      'UPDATE event SET label = label WHERE id = $1',
+      [1],
+    )) {
+      rows.push(row)
+    }
+    expect(rows).toEqual([])
+  })
+
+  it('iterates inside a transaction', async () => {
+    const ids = await db.transaction(async (tx) => {
+      await tx.query('INSERT INTO event VALUES (2501, $1)', ['in tx'])
+      const ids: number[] = []
+      for await (const row of tx.queryIterator<{ id: number }>(
+        'SELECT id FROM event WHERE id > 2495 ORDER BY id',
+        [],
+        { batchSize: 2 },
+      )) {
+        ids.push(row.id)
+      }
+      await tx.rollback()
+      return ids
+    })
+    expect(ids).toEqual([2496, 2497, 2498, 2499, 2500, 2501])
+  })
+
+  it('stops when its transaction has ended', async () => {
+    let iterator!: AsyncGenerator<{ id: number }>
+    await db.transaction(async (tx) => {
+      iterator = tx.queryIterator<{ id: number }>(
+        'SELECT id FROM event ORDER BY id',
+        [],
+        { batchSize: 2 },
+      )
+      expect((await iterator.next()).value).toEqual({ id: 1 })
+    })
+
+    // The rest of the fetched batch is still handed out
+    expect((await iterator.next()).value).toEqual({ id: 2 })
+    await expect(iterator.next()).rejects.toThrow('Transaction is closed')
+    expect((await db.query('SELECT 1 AS one')).rows).toEqual([{ one: 1 }])
+  })
+
+  it('runs other queries between batches inside a transaction', async () => {
+    const labels = await db.transaction(async (tx) => {
+      const labels: string[] = []
+      for await (const row of tx.queryIterator<{ id: number }>(
+        'SELECT id FROM event WHERE id <= 5 ORDER BY id',
+        [],
+        { batchSize: 2 },
+      )) {
+        const result = await tx.query<{ label: string }>(
+          'SELECT label FROM event WHERE id = $1',
+          [row.id],
+        )
+        labels.push(result.rows[0].label)
+      }
+      return labels
+    })
+    expect(labels).toEqual([
+      'event 1',
+      'event 2',
+      'event 3',
+      'event 4',
+      'event 5',
+    ])
+  })
+})
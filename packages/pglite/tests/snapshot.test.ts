@@ -1,6 +1,7 @@
 import { describe, it, expect, beforeAll, afterAll } from 'vitest'
 import { PGlite } from '../dist/index.js'
 import type { MemorySnapshot } from '../dist/index.js'
+import { serialize } from '@electric-sql/pg-protocol'
 import {
   SNAPSHOT_VERSION,
   serializeSnapshot,
@@ -175,6 +176,47 @@ describe('Memory Snapshots', () => {
       await restoredDb.close()
     })
 
+    it('returns the output of the first queries after restore', async () => {
+      // The source has run queries, so its output arena is in the snapshot
+      const restoredDb = await PGlite.create({
+        memorySnapshot: sourceSnapshot,
+      })
+
+      const { messages, data } = await restoredDb.execProtocol(
+        serialize.query('SELECT 42 AS answer'),
+      )
+      expect(messages.map((msg) => msg.name)).toEqual([
+        'rowDescription',
+        'dataRow',
+        'commandComplete',
+        'readyForQuery',
+      ])
+      expect(data.length).toBeGreaterThan(0)
+      // Array parsers come from a query run while restoring
+      const result = await restoredDb.query('SELECT ARRAY[1, 2] AS answer')
+      expect(result.rows).toEqual([{ answer: [1, 2] }])
+
+      await restoredDb.close()
+    })
+
+    it('caches statements after restore', async () => {
+      // The source's cache has prepared statements that are in the snapshot
+      await sourceDb.query('SELECT $1::int AS n', [1])
+      const snapshot = await sourceDb.captureSnapshot()
+      const restoredDb = await PGlite.create({ memorySnapshot: snapshot })
+
+      for (const n of [1, 2]) {
+        const result = await restoredDb.query('SELECT $1::int AS n', [n])
+        expect(result.rows).toEqual([{ n }])
+      }
+      expect(restoredDb.getStatementCacheStats()).toMatchObject({
+        hits: 1,
+        size: 2,
+      })
+
+      await restoredDb.close()
+    })
+
     it('rejects snapshots with incompatible version', async () => {
       const badSnapshot: MemorySnapshot = {
         ...sourceSnapshot,
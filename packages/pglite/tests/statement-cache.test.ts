@@ -0,0 +1,149 @@
+import { describe, it, expect, beforeEach, afterEach } from 'vitest'
+import { PGlite } from '../dist/index.js'
+
+async function preparedStatements(db: PGlite) {
+  const res = await db.exec(
+    `SELECT name FROM pg_prepared_statements ORDER BY name`,
+    { rowMode: 'array' },
+  )
+  return res[0].rows.map(([name]) => name)
+}
+
+describe('statement cache', () => {
+  let db: PGlite
+
+  beforeEach(async () => {
+    db = await PGlite.create({ statementCacheSize: 2 })
+    await db.exec(`
+      CREATE TABLE todo (id SERIAL PRIMARY KEY, task TEXT);
+      INSERT INTO todo (task) VALUES ('one'), ('two');
+    `)
+  })
+
+  afterEach(async () => {
+    await db.close()
+  })
+
+  it('reuses the statement for the same query text', async () => {
+    const query = 'SELECT task FROM todo WHERE id = $1'
+    const first = await db.query(query, [1])
+    const second = await db.query(query, [2])
+
+    expect(first.rows).toEqual([{ task: 'one' }])
+    expect(second.rows).toEqual([{ task: 'two' }])
+    expect(second.fields).toEqual(first.fields)
+    expect(db.getStatementCacheStats()).toMatchObject({ hits: 1, misses: 1 })
+    expect(await preparedStatements(db)).toHaveLength(1)
+  })
+
+  it('evicts the least recently used statement', async () => {
+    await db.query('SELECT 1')
+    await db.query('SELECT 2')
+    await db.query('SELECT 1')
+    await db.query('SELECT 3')
+    // Evicted statements are closed with the next query
+    await db.query('SELECT 1')
+
+    expect(db.getStatementCacheStats()).toEqual({
+      hits: 2,
+      misses: 3,
+      evictions: 1,
+      size: 2,
+      capacity: 2,
+    })
+    expect(await preparedStatements(db)).toHaveLength(2)
+  })
+
+  it('is cleared by schema changes', async () => {
+    const query = 'SELECT * FROM todo WHERE id = $1'
+    await db.query(query, [1])
+    await db.exec('ALTER TABLE todo ADD COLUMN done BOOLEAN DEFAULT false')
+
+    const res = await db.query(query, [1])
+    expect(res.rows).toEqual([{ id: 1, task: 'one', done: false }])
+    expect(db.getStatementCacheStats()).toMatchObject({ hits: 0, misses: 2 })
+  })
+
+  it('prepares a query again after a schema change it missed', async () => {
+    const query = 'SELECT * FROM todo WHERE id = $1'
+    await db.query(query, [1])
+    await db.exec(`
+      DO $$ BEGIN
+        ALTER TABLE todo ADD COLUMN done BOOLEAN DEFAULT false;
+      END $$
+    `)
+
+    const res = await db.query(query, [1])
+    expect(res.rows).toEqual([{ id: 1, task: 'one', done: false }])
+    expect(db.getStatementCacheStats()).toMatchObject({ hits: 1, misses: 2 })
+    expect(await preparedStatements(db)).toHaveLength(1)
+
+    // Inside a transaction the failure can't be undone, so it's thrown
+    await db.exec(`DO $$ BEGIN ALTER TABLE todo DROP COLUMN done; END $$`)
+    await expect(
+      db.transaction(async (tx) => {
+        await tx.query(query, [1])
+      }),
+    ).rejects.toThrow('cached plan must not change result type')
+    expect((await db.query(query, [1])).rows).toEqual([{ id: 1, task: 'one' }])
+  })
+
+  it('is cleared by DISCARD ALL', async () => {
+    await db.query('SELECT 1')
+    await db.exec('DISCARD ALL')
+    expect(db.getStatementCacheStats().size).toBe(0)
+    expect((await db.query('SELECT 1 AS one')).rows).toEqual([{ one: 1 }])
+    expect((await db.query('SELECT 1')).rows).toHaveLength(1)
+  })
+
+  it('is cleared by rolling back a transaction', async () => {
+    const query = 'SELECT * FROM todo WHERE id = 1'
+    await db.query(query)
+    await db
+      .transaction(async (tx) => {
+        await tx.exec('ALTER TABLE todo DROP COLUMN task')
+        expect((await tx.query(query)).rows).toEqual([{ id: 1 }])
+        throw new Error('undo')
+      })
+      .catch(() => {})
+
+    expect((await db.query(query)).rows).toEqual([{ id: 1, task: 'one' }])
+  })
+
+  it('keeps the statement after a query fails', async () => {
+    const query = 'INSERT INTO todo (id, task) VALUES ($1, $2)'
+    await db.query(query, [3, 'three'])
+    await expect(db.query(query, [3, 'again'])).rejects.toThrow(
+      'duplicate key',
+    )
+    await db.query(query, [4, 'four'])
+    expect(db.getStatementCacheStats()).toMatchObject({ hits: 2, misses: 1 })
+  })
+
+  it('caches a query separately for each set of paramTypes', async () => {
+    const query = 'SELECT $1 AS value'
+    const text = await db.query(query, ['1'])
+    const int = await db.query(query, [1], { paramTypes: [23] })
+    expect(text.fields[0].dataTypeID).toBe(25)
+    expect(int.fields[0].dataTypeID).toBe(23)
+    expect(db.getStatementCacheStats().misses).toBe(2)
+  })
+
+  it('can be cleared and disabled', async () => {
+    await db.query('SELECT 1')
+    db.clearStatementCache()
+    await db.query('SELECT 2')
+    expect(await preparedStatements(db)).toHaveLength(1)
+
+    const uncached = await PGlite.create({ statementCacheSize: 0 })
+    await uncached.query('SELECT 1')
+    await uncached.query('SELECT 1')
+    expect(uncached.getStatementCacheStats()).toMatchObject({
+      hits: 0,
+      misses: 0,
+      size: 0,
+    })
+    expect(await preparedStatements(uncached)).toEqual([])
+    await uncached.close()
+  })
+})
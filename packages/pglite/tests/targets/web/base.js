@@ -462,6 +462,58 @@ export function tests(env, dbFilename, target) {
       }
     })
 
+    it(`worker pipeline with a failing statement`, async () => {
+      const res = await evaluate(async () => {
+        const { PGliteWorker } = await import(PGLITE_WORKER_PATH)
+
+        const db = new PGliteWorker(
+          new Worker(WORKER_PATH, {
+            type: 'module',
+          }),
+          {
+            dataDir: window.dbFilename,
+          },
+        )
+
+        await db.waitReady
+
+        const pipeline = db.pipeline()
+        const queries = [
+          pipeline.query('SELECT 1 AS one'),
+          pipeline.query('SELECT 1 / $1 AS two', [0]),
+          pipeline.query('SELECT 3 AS three'),
+        ]
+        let runError
+        try {
+          await pipeline.run()
+        } catch (e) {
+          runError = { message: e.message, code: e.code }
+        }
+        const settled = await Promise.allSettled(queries)
+        const after = await db.query('SELECT 4 AS four')
+        return {
+          runError,
+          errors: settled.map((result) => ({
+            message: result.reason.message,
+            code: result.reason.code,
+          })),
+          after: after.rows,
+        }
+      })
+
+      expect(res.runError).toEqual({
+        message: 'division by zero',
+        code: '22012',
+      })
+      expect(res.errors[1]).toEqual(res.runError)
+      for (const i of [0, 2]) {
+        expect(res.errors[i].message).toBe(
+          'Pipeline aborted: statement 2 of 3 failed: division by zero',
+        )
+      }
+      expect(res.after).toEqual([{ four: 4 }])
+    })
+
     if (dbFilename.startsWith('idb://')) {
       it(`idb close and delete`, async () => {
         const res = await evaluate(async () => {
@@ -0,0 +1,36 @@
+#!/bin/bash
+#
+# Build the native comm suite, one binary per transport
+#
+# No Emscripten required: pglite-comm.h is compiled with PGLITE_COMM_NATIVE
+# and comm-suite.c plays the host side of each transport in C.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+cd "$SCRIPT_DIR"
+
+CC="${CC:-cc}"
+CFLAGS="${CFLAGS:--O2 -Wall -Wextra}"
+
+echo "Building native comm suite with ${CC}..."
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_TRAMPOLINE \
+    -o comm-suite-trampoline comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_TRAMPOLINE -DPGLITE_COMM_BATCHED \
+    -o comm-suite-trampoline-batched comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_TRAMPOLINE -DPGLITE_COMM_BATCHED \
+    -DPGLITE_COMM_COLUMN_INDEX -o comm-suite-trampoline-columns comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_IMPORTS \
+    -o comm-suite-imports comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_IMPORTS -DPGLITE_COMM_VECTORED \
+    -o comm-suite-imports-vectored comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_POLLING \
+    -o comm-suite-polling comm-suite.c
+${CC} ${CFLAGS} -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_POLLING -DPGLITE_POLLING_ASYNC \
+    -o comm-suite-polling-async comm-suite.c
+
+echo ""
+echo "To test every transport, run:"
+echo "  for t in comm-suite-*; do ./\$t; done"
+echo "To compare them:"
+echo "  for t in comm-suite-*; do ./\$t --bench --json --quick; done"
@@ -0,0 +1,994 @@
+/**
+ * comm-suite.c
+ *
+ * Native conformance tests and benchmarks for the transports behind
+ * pglite-comm.h. The same backend-side code runs against every transport;
+ * only the small "host" section below differs, standing in for the
+ * TypeScript side each transport pairs with.
+ *
+ * Conformance (default):
+ *   recv-order      input arrives intact and in order for any recv() size
+ *   recv-empty      recv() with no input pending returns 0
+ *   send-fragments  thousands of small sends, some large, arrive identical
+ *   send-large      a single 1MB send arrives intact
+ *   rfq-visible     output ending in ReadyForQuery reaches the host without
+ *                   an explicit pglite_transport_flush()
+ *   buffer-resize   (polling) the rings grow after a result that did not fit,
+ *                   shrink after a run of small queries and obey the limits;
+ *                   the flush high-water mark follows them unless set
+ *   layout          (polling) the layout descriptor matches the structs
+ *   send-batch      (trampoline, batched) a small-row response crosses into
+ *                   JS once, and every batch is whole messages matching its
+ *                   frame table
+ *   send-columns    (trampoline, column index) the column index locates
+ *                   every DataRow field, NULLs included, and stays within
+ *                   its row for any payload
+ *
+ * Benchmarks (--bench), each across message sizes from 16B to 1MB:
+ *   recv       recv() throughput with the host supplying input
+ *   send       DataRow sends followed by ReadyForQuery
+ *   roundtrip  host input -> recv -> send + ReadyForQuery -> host, with
+ *              per-message latency percentiles
+ *
+ * Transports with more than one mode (trampoline with and without the output
+ * arena, imports pulling input or reading a published input buffer) run
+ * every test and benchmark once per mode.
+ *
+ * Build and run (no Emscripten required):
+ *   ./build.sh
+ *   ./comm-suite-trampoline [--bench [--json] [--quick]]
+ *
+ * --json prints one JSON object per line (NDJSON), tagged with the transport
+ * and mode, so results for all transports can be compared side by side.
+ */
+
+#define PGLITE_COMM_NATIVE
+#include "pglite-comm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef PGLITE_POLLING_SHARED
+#error "comm-suite drives the transport single-threaded; build without PGLITE_POLLING_SHARED"
+#endif
+
+#define MAX_MESSAGE (1024 * 1024)
+#define HOST_OUT_CAPACITY (8 * 1024 * 1024)
+
+static const uint8_t g_rfq[6] = { 'Z', 0, 0, 0, 5, 'I' };
+
+static int g_json = 0;
+static int g_quick = 0;
+static int g_mode = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * Host state shared by every transport
+ *
+ * Input is a byte string the host hands out on request; output is copied
+ * into a sink, appended for conformance tests and overwritten in place for
+ * benchmarks.
+ * ============================================================================ */
+
+static const uint8_t *g_in = NULL;
+static size_t g_in_len = 0;
+static size_t g_in_pos = 0;
+
+static uint8_t *g_out = NULL;
+static size_t g_out_len = 0;
+static int g_out_keep = 1;
+
+static uint64_t g_host_calls = 0;
+
+static inline size_t host_take_input(void *dst, size_t max_len) {
+    size_t n = g_in_len - g_in_pos;
+    if (n > max_len) {
+        n = max_len;
+    }
+    memcpy(dst, g_in + g_in_pos, n);
+    g_in_pos += n;
+    return n;
+}
+
+static void host_put_output(const void *src, size_t len) {
+    // Benchmarks still copy every byte out, as the JS side would, but
+    // overwrite the same region instead of keeping it
+    size_t at = g_out_keep ? g_out_len : 0;
+    if (at + len > HOST_OUT_CAPACITY) {
+        fprintf(stderr, "host output sink overflow\n");
+        exit(1);
+    }
+    memcpy(g_out + at, src, len);
+    g_out_len += len;
+}
+
+/* ============================================================================
+ * Transport-specific host
+ *
+ * host_begin()    start a query with the given input
+ * host_pump()     give a push-based transport more input, called before
+ *                 every recv()
+ * host_visible()  output bytes the host can see right now
+ * host_finish()   _interactive_one returned: collect everything
+ * ============================================================================ */
+
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE
+
+static const char *g_mode_names[] = { "callbacks", "arena" };
+
+ssize_t pglite_read_trampoline(void *buffer, size_t max_length) {
+    g_host_calls++;
+    return (ssize_t)host_take_input(buffer, max_length);
+}
+
+#ifdef PGLITE_COMM_BATCHED
+static uint64_t g_batch_messages = 0;
+static uint64_t g_frame_errors = 0;
+
+/* The frame table must tile the batch with whole messages */
+static void host_check_frames(const uint8_t *bytes, size_t length,
+                              uint32_t messages, const pglite_frame_t *frames) {
+    size_t at = 0;
+    for (uint32_t i = 0; i < messages; i++) {
+        const uint8_t *m = bytes + frames[i].offset;
+        uint32_t len = ((uint32_t)m[1] << 24) | ((uint32_t)m[2] << 16) |
+                       ((uint32_t)m[3] << 8) | (uint32_t)m[4];
+        if (frames[i].offset != at || frames[i].type != m[0] ||
+            frames[i].length != 1 + len) {
+            g_frame_errors++;
+            return;
+        }
+        at += frames[i].length;
+    }
+    g_frame_errors += at != length;
+}
+
+#ifdef PGLITE_COMM_COLUMN_INDEX
+#define HOST_MAX_COLUMNS 4096
+static uint32_t g_columns[HOST_MAX_COLUMNS * 2];   // offsets into g_out
+static uint32_t g_columns_len = 0;
+static uint64_t g_column_errors = 0;
+
+/* One pair per DataRow field, each inside its row, NULL as 0xFFFFFFFF;
+ * none for a row too short for its field count */
+static void host_check_columns(const uint8_t *bytes, uint32_t messages,
+                               const pglite_frame_t *frames,
+                               const uint32_t *columns, uint32_t count) {
+    uint32_t at = 0;
+    for (uint32_t i = 0; i < messages; i++) {
+        if (frames[i].type != 'D' || frames[i].length < 7) {
+            continue;
+        }
+        const uint8_t *m = bytes + frames[i].offset;
+        uint32_t fields = ((uint32_t)m[5] << 8) | (uint32_t)m[6];
+        if (fields > (frames[i].length - 7) / 4) {
+            continue;
+        }
+        uint32_t start = frames[i].offset + 7;
+        uint32_t end = frames[i].offset + frames[i].length;
+        if (count - at < fields) {
+            g_column_errors++;  // ran out of pairs
+            return;
+        }
+        for (uint32_t f = 0; f < fields; f++, at++) {
+            uint32_t offset = columns[at * 2];
+            uint32_t len = columns[at * 2 + 1];
+            if (len != UINT32_MAX &&
+                (offset < start + 4 || offset > end || len > end - offset)) {
+                g_column_errors++;
+            }
+        }
+    }
+    g_column_errors += at != count;
+}
+#endif
+
+ssize_t pglite_write_batch_trampoline(const void *buffer, size_t length,
+                                      uint32_t messages, const void *frames,
+                                      const void *columns,
+                                      uint32_t column_count) {
+    g_host_calls++;
+    g_batch_messages += messages;
+    if (frames) {
+        host_check_frames(buffer, length, messages, frames);
+    }
+#ifdef PGLITE_COMM_COLUMN_INDEX
+    if (frames) {
+        host_check_columns(buffer, messages, frames, columns, column_count);
+    }
+    // Keep the pairs, rebased onto the collected output, for send-columns
+    uint32_t base = (uint32_t)(g_out_keep ? g_out_len : 0);
+    const uint32_t *pairs = columns;
+    for (uint32_t i = 0; i < column_count && g_columns_len < HOST_MAX_COLUMNS;
+         i++, g_columns_len++) {
+        g_columns[g_columns_len * 2] = pairs[i * 2] + base;
+        g_columns[g_columns_len * 2 + 1] = pairs[i * 2 + 1];
+    }
+#else
+    if (columns || column_count) {
+        g_frame_errors++;  // no index without PGLITE_COMM_COLUMN_INDEX
+    }
+#endif
+    host_put_output(buffer, length);
+    return (ssize_t)length;
+}
+#else
+ssize_t pglite_write_trampoline(const void *buffer, size_t length) {
+    g_host_calls++;
+    host_put_output(buffer, length);
+    return (ssize_t)length;
+}
+#endif
+
+int pglite_cache_callbacks(int batched) {
+    (void)batched;
+    return 1;
+}
+
+static void host_init(void) {
+}
+
+static int host_set_mode(int mode) {
+    // The arena cannot be switched off again, so "arena" runs last
+    if (mode == 1 && !pglite_alloc_output_arena(64 * 1024)) {
+        fprintf(stderr, "pglite_alloc_output_arena failed\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void host_begin(void) {
+    pglite_reset_output_arena();
+#ifdef PGLITE_COMM_BATCHED
+    g_batch_messages = 0;
+#endif
+#ifdef PGLITE_COMM_COLUMN_INDEX
+    g_columns_len = 0;
+#endif
+}
+
+static void host_pump(void) {
+}
+
+static size_t host_visible(void) {
+    // JS parses the arena in place once _interactive_one returns
+    return g_out_len + pglite_get_output_arena_used();
+}
+
+static void host_finish(void) {
+#ifdef PGLITE_COMM_BATCHED
+    // As JS does once _interactive_one returns
+    pglite_flush_output();
+#endif
+    host_put_output(pglite_output_arena, pglite_get_output_arena_used());
+    pglite_reset_output_arena();
+}
+
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_IMPORTS
+
+static const char *g_mode_names[] = { "pull", "input-buffer" };
+static uint8_t *g_input_buffer = NULL;
+
+ssize_t pglite_js_read(void *buffer, size_t max_length) {
+    return (ssize_t)host_take_input(buffer, max_length);
+}
+
+ssize_t pglite_js_write(void *buffer, size_t length) {
+    host_put_output(buffer, length);
+    return (ssize_t)length;
+}
+
+#ifdef PGLITE_COMM_VECTORED
+ssize_t pglite_js_readv(const pglite_iovec_t *iov, int iovcnt) {
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        size_t n = host_take_input(iov[i].base, iov[i].len);
+        total += n;
+        if (n < iov[i].len) {
+            break;
+        }
+    }
+    return (ssize_t)total;
+}
+
+ssize_t pglite_js_writev(const pglite_iovec_t *iov, int iovcnt) {
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        host_put_output(iov[i].base, iov[i].len);
+        total += iov[i].len;
+    }
+    return (ssize_t)total;
+}
+#endif
+
+static void host_init(void) {
+    g_input_buffer = pglite_alloc_input_buffer(MAX_MESSAGE * 8);
+    if (!g_input_buffer) {
+        fprintf(stderr, "pglite_alloc_input_buffer failed\n");
+        exit(1);
+    }
+}
+
+static int host_set_mode(int mode) {
+    (void)mode;
+    return 1;
+}
+
+static void host_begin(void) {
+    pglite_reset_boundary_crossings();
+    pglite_set_input_length(0);
+
+    // Publish the whole message up front, as pglite-imports.ts does
+    if (g_mode == 1 && g_in_len > 0) {
+        memcpy(g_input_buffer, g_in, g_in_len);
+        if (pglite_set_input_length(g_in_len) != 0) {
+            fprintf(stderr, "pglite_set_input_length(%zu) failed\n", g_in_len);
+            exit(1);
+        }
+        g_in_pos = g_in_len;
+    }
+}
+
+static void host_pump(void) {
+}
+
+static size_t host_visible(void) {
+    return g_out_len;
+}
+
+static void host_finish(void) {
+    g_host_calls += pglite_get_boundary_crossings();
+    pglite_set_input_length(0);
+}
+
+#else /* PGLITE_TRANSPORT_POLLING */
+
+static const char *g_mode_names[] = { "rings" };
+
+/* The yield hook: the host drains the output ring when it fills up */
+static int host_drain(void) {
+    uint8_t chunk[16 * 1024];
+    size_t n;
+    while ((n = pglite_ring_read(g_output_buffer, chunk, sizeof(chunk))) > 0) {
+        host_put_output(chunk, n);
+    }
+    return 1;
+}
+
+/* Refill the input ring with as much pending input as fits */
+static int host_feed(void) {
+    size_t left = g_in_len - g_in_pos;
+    size_t n = left > 0
+                   ? pglite_ring_write(g_input_buffer, g_in + g_in_pos, left)
+                   : 0;
+    g_in_pos += n;
+    return n > 0;
+}
+
+static void host_init(void) {
+    pglite_polling_set_yield_hook(host_drain);
+#ifdef PGLITE_POLLING_ASYNC
+    // recv() asks for input itself when the ring runs dry
+    pglite_polling_set_input_hook(host_feed);
+#endif
+}
+
+static int host_set_mode(int mode) {
+    (void)mode;
+    return 1;
+}
+
+static void host_begin(void) {
+    pglite_reset_buffers();
+}
+
+static void host_pump(void) {
+#ifndef PGLITE_POLLING_ASYNC
+    host_feed();
+#endif
+}
+
+static size_t host_visible(void) {
+    // Bytes drained on yields plus everything announced by a notification
+    return g_notified_written;
+}
+
+static void host_finish(void) {
+    g_host_calls += g_control.write_yields + g_control.notifications +
+                    g_control.input_waits;
+    host_drain();
+}
+
+#endif
+
+#define NUM_MODES ((int)(sizeof(g_mode_names) / sizeof(g_mode_names[0])))
+
+/* ============================================================================
+ * Backend side: the same code for every transport
+ * ============================================================================ */
+
+static void query_begin(const uint8_t *input, size_t len, int keep_output) {
+    g_in = input;
+    g_in_len = len;
+    g_in_pos = 0;
+    g_out_len = 0;
+    g_out_keep = keep_output;
+    host_begin();
+}
+
+/* Read exactly len bytes the way pqcomm does: recv() until satisfied */
+static size_t backend_read(uint8_t *dst, size_t len, size_t chunk) {
+    size_t got = 0;
+    while (got < len) {
+        size_t want = len - got < chunk ? len - got : chunk;
+        host_pump();
+        ssize_t n = pglite_transport_recv(dst + got, want);
+        if (n <= 0) {
+            break;
+        }
+        got += (size_t)n;
+    }
+    return got;
+}
+
+static int backend_send(const void *buf, size_t len) {
+    return pglite_transport_send(buf, len) == (ssize_t)len;
+}
+
+/* DataRow-shaped message: 'D', big-endian length, payload */
+static size_t make_message(uint8_t *dst, size_t size, uint32_t seed) {
+    if (size < 5) {
+        size = 5;
+    }
+    uint32_t len = (uint32_t)(size - 1);
+    dst[0] = 'D';
+    dst[1] = (uint8_t)(len >> 24);
+    dst[2] = (uint8_t)(len >> 16);
+    dst[3] = (uint8_t)(len >> 8);
+    dst[4] = (uint8_t)len;
+    for (size_t i = 5; i < size; i++) {
+        dst[i] = (uint8_t)(seed + i * 7);
+    }
+    return size;
+}
+
+static uint8_t g_src[MAX_MESSAGE * 2];
+static uint8_t g_dst[MAX_MESSAGE * 2];
+
+/* ============================================================================
+ * Conformance
+ * ============================================================================ */
+
+static int g_failures = 0;
+
+static void check(int ok, const char *test, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAIL %s/%s %s: %s\n", PGLITE_TRANSPORT_NAME,
+                g_mode_names[g_mode], test, what);
+        g_failures++;
+    }
+}
+
+static void test_recv_order(void) {
+    static const size_t chunks[] = { 1, 7, 512, 8192, 65536, MAX_MESSAGE };
+    size_t total = 200000;
+
+    for (size_t i = 0; i < total; i++) {
+        g_src[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        query_begin(g_src, total, 1);
+        memset(g_dst, 0, total);
+        size_t got = backend_read(g_dst, total, chunks[c]);
+        check(got == total, "recv-order", "short read");
+        check(memcmp(g_dst, g_src, total) == 0, "recv-order", "bytes differ");
+
+        host_pump();
+        uint8_t extra;
+        check(pglite_transport_recv(&extra, 1) == 0, "recv-order",
+              "recv() past the end of input did not return 0");
+        host_finish();
+    }
+}
+
+static void test_recv_empty(void) {
+    uint8_t buf[64];
+    query_begin(g_src, 0, 1);
+    host_pump();
+    check(pglite_transport_recv(buf, sizeof(buf)) == 0, "recv-empty",
+          "recv() without input did not return 0");
+    host_finish();
+}
+
+static void test_send_fragments(void) {
+    size_t expected = 0;
+    uint8_t *expect = g_src;
+
+    query_begin(NULL, 0, 1);
+    for (uint32_t i = 0; i < 5000; i++) {
+        // Mostly row-sized, with an occasional message bigger than any
+        // transport buffer
+        size_t size = i % 1000 == 999 ? 150000 : 5 + (i * 37) % 300;
+        size_t n = make_message(expect + expected, size, i);
+        check(backend_send(expect + expected, n), "send-fragments",
+              "short send");
+        expected += n;
+    }
+    memcpy(expect + expected, g_rfq, sizeof(g_rfq));
+    check(backend_send(g_rfq, sizeof(g_rfq)), "send-fragments", "short send");
+    expected += sizeof(g_rfq);
+    host_finish();
+
+    check(g_out_len == expected, "send-fragments", "byte count differs");
+    check(g_out_len == expected && memcmp(g_out, expect, expected) == 0,
+          "send-fragments", "bytes differ");
+}
+
+static void test_send_large(void) {
+    size_t n = make_message(g_src, MAX_MESSAGE, 42);
+    memcpy(g_src + n, g_rfq, sizeof(g_rfq));
+
+    query_begin(NULL, 0, 1);
+    check(backend_send(g_src, n), "send-large", "short send");
+    check(backend_send(g_rfq, sizeof(g_rfq)), "send-large", "short send");
+    host_finish();
+
+    check(g_out_len == n + sizeof(g_rfq), "send-large", "byte count differs");
+    check(memcmp(g_out, g_src, n + sizeof(g_rfq)) == 0, "send-large",
+          "bytes differ");
+}
+
+static void test_rfq_visible(void) {
+    size_t total = 0;
+
+    query_begin(NULL, 0, 1);
+    for (uint32_t i = 0; i < 3; i++) {
+        size_t n = make_message(g_src, 40, i);
+        backend_send(g_src, n);
+        total += n;
+    }
+    backend_send(g_rfq, sizeof(g_rfq));
+    total += sizeof(g_rfq);
+
+    check(host_visible() == total, "rfq-visible",
+          "output held back after ReadyForQuery");
+    host_finish();
+    check(g_out_len == total, "rfq-visible", "byte count differs");
+}
+
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_POLLING
+/* One query whose result is `size` bytes of DataRows plus ReadyForQuery */
+static int send_result(size_t size) {
+    size_t sent = 0;
+    uint32_t seed = 0;
+
+    query_begin(NULL, 0, 1);
+    while (sent < size) {
+        size_t n = make_message(g_src, size - sent < 8192 ? size - sent : 8192,
+                                seed++);
+        backend_send(g_src, n);
+        sent += n;
+    }
+    backend_send(g_rfq, sizeof(g_rfq));
+    host_finish();
+    return g_out_len == sent + sizeof(g_rfq);
+}
+
+static void test_buffer_resize(void) {
+    check(pglite_init_buffers(5000) == 8192, "buffer-resize",
+          "init size not rounded up to a power of two");
+    check(g_flush_high_water == 4096, "buffer-resize",
+          "high-water mark not half the ring");
+
+    // Too big for the ring: yields now, the next query gets a ring it fits
+    check(send_result(300000), "buffer-resize", "result lost");
+    check(g_control.write_yields > 0, "buffer-resize", "no yields");
+    host_begin();
+    check(pglite_get_buffer_size() == 512 * 1024, "buffer-resize", "no growth");
+    check(send_result(300000), "buffer-resize", "result lost after growth");
+    check(g_control.write_yields == 0, "buffer-resize",
+          "still yielding after growth");
+    // The high-water mark grew with the ring: one notification past it,
+    // one for ReadyForQuery
+    check(g_flush_high_water == 256 * 1024 && g_control.notifications <= 2,
+          "buffer-resize", "high-water mark did not follow the ring");
+
+    // A run of small queries shrinks it again; the window the big result
+    // fell into does not count
+    for (int i = 0; i < 2 * PGLITE_RESIZE_WINDOW; i++) {
+        send_result(2000);
+    }
+    host_begin();
+    check(pglite_get_buffer_size() == PGLITE_MIN_BUFFER_SIZE, "buffer-resize",
+          "no shrink");
+
+    // Limits apply at the next reset; min == max pins the size
+    pglite_set_buffer_limits(64 * 1024, 64 * 1024);
+    host_begin();
+    check(pglite_get_buffer_size() == 64 * 1024, "buffer-resize",
+          "limits ignored");
+    check(send_result(300000), "buffer-resize", "result lost when pinned");
+    host_begin();
+    check(pglite_get_buffer_size() == 64 * 1024, "buffer-resize",
+          "grew past the limit");
+
+    // A mark set explicitly stays put
+    pglite_set_flush_high_water(1000);
+    pglite_set_buffer_limits(PGLITE_MIN_BUFFER_SIZE, PGLITE_MAX_BUFFER_SIZE);
+    pglite_init_buffers(PGLITE_BUFFER_SIZE);
+    check(g_flush_high_water == 1000, "buffer-resize",
+          "explicit high-water mark overwritten");
+
+    g_flush_high_water_fixed = 0;
+    pglite_init_buffers(PGLITE_MIN_BUFFER_SIZE);
+    pglite_init_buffers(PGLITE_BUFFER_SIZE);
+}
+
+/* What JS reads from pglite_get_layout() must locate the real fields */
+static void test_layout(void) {
+    const PGliteLayout *layout = pglite_get_layout();
+    const uint8_t *control = pglite_get_control();
+    const uint8_t *input = pglite_get_input_buffer();
+
+    check(layout->magic == PGLITE_LAYOUT_MAGIC &&
+              layout->version == PGLITE_LAYOUT_VERSION &&
+              layout->size == sizeof(PGliteLayout),
+          "layout", "bad descriptor header");
+    check((uintptr_t)control % PGLITE_CACHE_LINE_SIZE == 0, "layout",
+          "control block not cache-line aligned");
+    check(control + layout->control_notifications ==
+              (const uint8_t *)&g_control.notifications &&
+              control + layout->control_total_written ==
+                  (const uint8_t *)&g_control.total_written,
+          "layout", "control offsets wrong");
+    check(layout->control_notifications / PGLITE_CACHE_LINE_SIZE !=
+              layout->control_total_written / PGLITE_CACHE_LINE_SIZE,
+          "layout", "notifications shares a line with the write counters");
+    check(input + layout->ring_data == g_input_buffer->data &&
+              input + layout->ring_tail ==
+                  (const uint8_t *)&g_input_buffer->tail,
+          "layout", "ring offsets wrong");
+}
+#endif
+
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE && defined(PGLITE_COMM_BATCHED)
+/* A small-row response crosses into JS once, as a table of whole messages */
+static void test_send_batch(void) {
+    static const size_t splits[] = { 1, 3, 5, 7, 64 };
+
+    if (g_mode != 0) {
+        return;  // the arena is handed over by JS, not flushed
+    }
+
+    for (size_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+        size_t total = 0;
+        for (uint32_t i = 0; i < 100; i++) {
+            total += make_message(g_src + total, 5 + i % 40, i);
+        }
+        memcpy(g_src + total, g_rfq, sizeof(g_rfq));
+        total += sizeof(g_rfq);
+
+        // Fragments that cut through headers and bodies alike
+        query_begin(NULL, 0, 1);
+        uint64_t calls = g_host_calls;
+        for (size_t at = 0; at < total; at += splits[s]) {
+            size_t n = total - at < splits[s] ? total - at : splits[s];
+            backend_send(g_src + at, n);
+        }
+        check(g_host_calls - calls == 1, "send-batch",
+              "more than one host call per response");
+        check(g_batch_messages == 101, "send-batch", "message count wrong");
+        host_finish();
+        check(g_out_len == total && memcmp(g_out, g_src, total) == 0,
+              "send-batch", "bytes differ");
+    }
+
+    // Includes the batches of the earlier tests, some with 150KB-1MB messages
+    check(g_frame_errors == 0, "send-batch", "frame table wrong");
+}
+#endif
+
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE && defined(PGLITE_COMM_COLUMN_INDEX)
+/* DataRow with fields i, NULL and a 3 * i byte run of 'x' */
+static size_t make_row(uint8_t *dst, uint32_t i) {
+    char text[16];
+    int text_len = snprintf(text, sizeof(text), "%u", i);
+    const uint32_t lens[3] = { (uint32_t)text_len, UINT32_MAX, 3 * i };
+    size_t at = 7;
+    for (int f = 0; f < 3; f++) {
+        dst[at++] = (uint8_t)(lens[f] >> 24);
+        dst[at++] = (uint8_t)(lens[f] >> 16);
+        dst[at++] = (uint8_t)(lens[f] >> 8);
+        dst[at++] = (uint8_t)lens[f];
+        if (f == 0) {
+            memcpy(dst + at, text, text_len);
+            at += text_len;
+        } else if (f == 2) {
+            memset(dst + at, 'x', 3 * i);
+            at += 3 * i;
+        }
+    }
+    uint32_t len = (uint32_t)(at - 1);
+    dst[0] = 'D';
+    dst[1] = (uint8_t)(len >> 24);
+    dst[2] = (uint8_t)(len >> 16);
+    dst[3] = (uint8_t)(len >> 8);
+    dst[4] = (uint8_t)len;
+    dst[5] = 0;
+    dst[6] = 3;
+    return at;
+}
+
+/* The index points at each field's bytes in the output JS receives */
+static void test_send_columns(void) {
+    static const size_t splits[] = { 1, 5, 64, 4096 };
+    enum { rows = 400 };
+    size_t ends[rows];
+
+    if (g_mode != 0) {
+        return;
+    }
+
+    for (size_t s = 0; s < sizeof(splits) / sizeof(splits[0]); s++) {
+        size_t total = 0;
+        for (uint32_t i = 0; i < rows; i++) {
+            total += make_row(g_src + total, i);
+            ends[i] = total;
+        }
+        memcpy(g_src + total, g_rfq, sizeof(g_rfq));
+        total += sizeof(g_rfq);
+
+        query_begin(NULL, 0, 1);
+        for (size_t at = 0; at < total; at += splits[s]) {
+            size_t n = total - at < splits[s] ? total - at : splits[s];
+            backend_send(g_src + at, n);
+        }
+        host_finish();
+
+        check(g_columns_len == rows * 3, "send-columns", "pair count wrong");
+        if (g_columns_len != rows * 3) {
+            continue;
+        }
+        for (uint32_t i = 0; i < rows; i++) {
+            const uint32_t *pair = g_columns + i * 6;
+            char text[16];
+            int text_len = snprintf(text, sizeof(text), "%u", i);
+            check(pair[1] == (uint32_t)text_len &&
+                      memcmp(g_out + pair[0], text, text_len) == 0,
+                  "send-columns", "text field misplaced");
+            check(pair[3] == UINT32_MAX, "send-columns", "NULL field wrong");
+            // The run is the last field, so it ends where the row does
+            check(pair[5] == 3 * i && pair[4] + 3 * i == ends[i] &&
+                      (i == 0 || g_out[pair[4]] == 'x'),
+                  "send-columns", "run field misplaced");
+        }
+    }
+
+    // Includes the earlier tests, whose DataRows carry arbitrary bytes
+    check(g_column_errors == 0, "send-columns", "pair outside its row");
+}
+#endif
+
+static int run_conformance(void) {
+    for (g_mode = 0; g_mode < NUM_MODES; g_mode++) {
+        if (!host_set_mode(g_mode)) {
+            return 1;
+        }
+        int before = g_failures;
+        test_recv_order();
+        test_recv_empty();
+        test_send_fragments();
+        test_send_large();
+        test_rfq_visible();
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_POLLING
+        test_buffer_resize();
+        test_layout();
+#endif
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE && defined(PGLITE_COMM_BATCHED)
+        test_send_batch();
+#endif
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE && defined(PGLITE_COMM_COLUMN_INDEX)
+        test_send_columns();
+#endif
+        printf("%s/%s: %s\n", PGLITE_TRANSPORT_NAME, g_mode_names[g_mode],
+               g_failures == before ? "ok" : "FAILED");
+    }
+
+    printf(g_failures ? "FAIL\n" : "PASS\n");
+    return g_failures ? 1 : 0;
+}
+
+/* ============================================================================
+ * Benchmarks
+ * ============================================================================ */
+
+static const size_t g_sizes[] = {
+    16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576,
+};
+#define NUM_SIZES (sizeof(g_sizes) / sizeof(g_sizes[0]))
+
+typedef struct {
+    const char *bench;
+    size_t msg_size;
+    uint64_t ops;
+    uint64_t bytes;
+    uint64_t elapsed_ns;
+    uint64_t host_calls;
+    // Latency percentiles, roundtrip only
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+} Result;
+
+static uint64_t target_bytes(void) {
+    return g_quick ? 8u << 20 : 64u << 20;
+}
+
+static void report(const Result *r) {
+    double seconds = r->elapsed_ns / 1e9;
+    double mb_per_s = seconds > 0 ? r->bytes / seconds / (1024.0 * 1024.0) : 0;
+    double ns_per_op = r->ops ? (double)r->elapsed_ns / r->ops : 0;
+
+    if (g_json) {
+        printf("{\"transport\":\"%s\",\"mode\":\"%s\",\"bench\":\"%s\","
+               "\"msg_size\":%zu,\"ops\":%llu,\"bytes\":%llu,"
+               "\"seconds\":%.6f,\"mb_per_s\":%.1f,\"ns_per_op\":%.1f,",
+               PGLITE_TRANSPORT_NAME, g_mode_names[g_mode], r->bench,
+               r->msg_size, (unsigned long long)r->ops,
+               (unsigned long long)r->bytes, seconds, mb_per_s, ns_per_op);
+        if (r->p50_ns) {
+            printf("\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,",
+                   (unsigned long long)r->p50_ns,
+                   (unsigned long long)r->p99_ns,
+                   (unsigned long long)r->max_ns);
+        }
+        printf("\"host_calls\":%llu}\n", (unsigned long long)r->host_calls);
+        return;
+    }
+
+    printf("%-12s %-9s %8zu %10.1f MB/s %11.1f ns/op", g_mode_names[g_mode],
+           r->bench, r->msg_size, mb_per_s, ns_per_op);
+    if (r->p50_ns) {
+        printf("  p50=%llu p99=%llu max=%llu ns",
+               (unsigned long long)r->p50_ns, (unsigned long long)r->p99_ns,
+               (unsigned long long)r->max_ns);
+    }
+    printf("  host_calls=%llu\n", (unsigned long long)r->host_calls);
+}
+
+static void bench_recv(size_t size) {
+    Result r = { .bench = "recv", .msg_size = size };
+    size_t per_query = MAX_MESSAGE * 2;
+
+    g_host_calls = 0;
+    uint64_t start = now_ns();
+    while (r.bytes < target_bytes()) {
+        query_begin(g_src, per_query, 0);
+        size_t got = backend_read(g_dst, per_query, size);
+        host_finish();
+        r.bytes += got;
+        r.ops += (got + size - 1) / size;
+    }
+    r.elapsed_ns = now_ns() - start;
+    r.host_calls = g_host_calls;
+    report(&r);
+}
+
+static void bench_send(size_t size) {
+    Result r = { .bench = "send", .msg_size = size };
+    size_t n = make_message(g_src, size, 1);
+    uint64_t per_query = (4u << 20) / n + 1;
+
+    g_host_calls = 0;
+    uint64_t start = now_ns();
+    while (r.bytes < target_bytes()) {
+        query_begin(NULL, 0, 0);
+        for (uint64_t i = 0; i < per_query; i++) {
+            backend_send(g_src, n);
+        }
+        backend_send(g_rfq, sizeof(g_rfq));
+        host_finish();
+        r.ops += per_query;
+        r.bytes += per_query * n;
+    }
+    r.elapsed_ns = now_ns() - start;
+    r.host_calls = g_host_calls;
+    report(&r);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_roundtrip(size_t size) {
+    Result r = { .bench = "roundtrip", .msg_size = size };
+    size_t n = make_message(g_src, size, 2);
+    uint64_t ops = target_bytes() / n / 4;
+    r.ops = ops < 32 ? 32 : ops > 20000 ? 20000 : ops;
+    r.bytes = r.ops * n;
+
+    uint64_t *samples = malloc(r.ops * sizeof(uint64_t));
+    if (!samples) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    g_host_calls = 0;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < r.ops; i++) {
+        uint64_t t0 = now_ns();
+        query_begin(g_src, n, 0);
+        backend_read(g_dst, n, 8192);  // pqcomm's PQ_RECV_BUFFER_SIZE
+        backend_send(g_dst, n);
+        backend_send(g_rfq, sizeof(g_rfq));
+        host_finish();
+        samples[i] = now_ns() - t0;
+    }
+    r.elapsed_ns = now_ns() - start;
+    r.host_calls = g_host_calls;
+
+    qsort(samples, r.ops, sizeof(uint64_t), compare_u64);
+    r.p50_ns = samples[r.ops / 2];
+    r.p99_ns = samples[(r.ops * 99) / 100];
+    r.max_ns = samples[r.ops - 1];
+    free(samples);
+    report(&r);
+}
+
+static int run_benchmarks(void) {
+    for (size_t i = 0; i < sizeof(g_src); i++) {
+        g_src[i] = (uint8_t)('a' + i % 26);
+    }
+
+    if (!g_json) {
+        printf("Transport %s%s\n", PGLITE_TRANSPORT_NAME,
+               g_quick ? " (quick)" : "");
+        printf("%-12s %-9s %8s\n", "mode", "bench", "size");
+    }
+
+    for (g_mode = 0; g_mode < NUM_MODES; g_mode++) {
+        if (!host_set_mode(g_mode)) {
+            return 1;
+        }
+        for (size_t i = 0; i < NUM_SIZES; i++) bench_recv(g_sizes[i]);
+        for (size_t i = 0; i < NUM_SIZES; i++) bench_send(g_sizes[i]);
+        for (size_t i = 0; i < NUM_SIZES; i++) bench_roundtrip(g_sizes[i]);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int bench = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            g_json = 1;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            g_quick = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--bench [--json] [--quick]]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    g_out = malloc(HOST_OUT_CAPACITY);
+    if (!g_out) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    host_init();
+
+    return bench ? run_benchmarks() : run_conformance();
+}
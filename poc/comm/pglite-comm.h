@@ -0,0 +1,216 @@
+/**
+ * pglite-comm.h
+ *
+ * One comm header for every PGlite transport, chosen at build time:
+ *
+ *   -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_TRAMPOLINE  EM_JS into
+ *       Module._pgliteCallbacks (spike-trampoline, the default)
+ *   -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_IMPORTS     WASM imports
+ *       pglite_js_read / pglite_js_write (poc/wasm-imports)
+ *   -DPGLITE_TRANSPORT=PGLITE_TRANSPORT_POLLING     SPSC rings in WASM
+ *       memory (spike-memory-polling)
+ *
+ * The transport's own options still apply: PGLITE_COMM_BATCHED and
+ * PGLITE_COMM_COLUMN_INDEX for the trampoline, PGLITE_COMM_VECTORED for
+ * imports, PGLITE_POLLING_SHARED, PGLITE_POLLING_ASYNC and PGLITE_BUFFER_SIZE
+ * for polling, and PGLITE_COMM_STATS for all three.
+ *
+ * recv() and send() call the selected transport's inline entry points
+ * directly, so the choice costs nothing at runtime. The query state globals
+ * and the socket stubs PostgreSQL expects are defined here once instead of
+ * in each transport header.
+ *
+ * Usage:
+ * 1. Copy poc/comm, poc/wasm-imports, spike-trampoline/pglite-comm-trampoline.h
+ *    and spike-memory-polling/pglite-comm-polling.h into postgres-pglite
+ *    keeping their relative layout, and include this file in place of
+ *    pglite/includes/pglite-comm.h
+ * 2. Rebuild postgres-pglite with the PGLITE_TRANSPORT of your choice
+ * 3. Use the matching TypeScript side (pglite-trampoline.ts,
+ *    pglite-imports.ts or pglite-polling.ts)
+ *
+ * PGLITE_COMM_NATIVE builds the transport layer without Emscripten for the
+ * conformance suite and benchmarks in comm-suite.c; the socket overrides are
+ * left out there so the host libc keeps its own recv/send.
+ */
+
+#if defined(__EMSCRIPTEN__) || defined(PGLITE_COMM_NATIVE)
+
+#ifndef PGLITE_COMM_UNIFIED_H
+#define PGLITE_COMM_UNIFIED_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define PGLITE_TRANSPORT_TRAMPOLINE 1
+#define PGLITE_TRANSPORT_IMPORTS 2
+#define PGLITE_TRANSPORT_POLLING 3
+
+#ifndef PGLITE_TRANSPORT
+#define PGLITE_TRANSPORT PGLITE_TRANSPORT_TRAMPOLINE
+#endif
+
+// The transport headers only provide their entry points; see below
+#define PGLITE_COMM_TRANSPORT_ONLY
+
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE
+#include "../../spike-trampoline/pglite-comm-trampoline.h"
+#if defined(PGLITE_COMM_COLUMN_INDEX)
+#define PGLITE_TRANSPORT_NAME "trampoline-columns"
+#elif defined(PGLITE_COMM_BATCHED)
+#define PGLITE_TRANSPORT_NAME "trampoline-batched"
+#else
+#define PGLITE_TRANSPORT_NAME "trampoline"
+#endif
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_IMPORTS
+#include "../wasm-imports/pglite-comm-imports.h"
+#ifdef PGLITE_COMM_VECTORED
+#define PGLITE_TRANSPORT_NAME "imports-vectored"
+#else
+#define PGLITE_TRANSPORT_NAME "imports"
+#endif
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_POLLING
+#ifdef PGLITE_USE_POLLING
+#error "PGLITE_USE_POLLING is for the standalone polling header; pglite-comm.h provides recv/send itself"
+#endif
+#include "../../spike-memory-polling/pglite-comm-polling.h"
+#if defined(PGLITE_POLLING_SHARED)
+#define PGLITE_TRANSPORT_NAME "polling-shared"
+#elif defined(PGLITE_POLLING_ASYNC)
+#define PGLITE_TRANSPORT_NAME "polling-async"
+#else
+#define PGLITE_TRANSPORT_NAME "polling"
+#endif
+#else
+#error "PGLITE_TRANSPORT must be PGLITE_TRANSPORT_TRAMPOLINE, _IMPORTS or _POLLING"
+#endif
+
+#ifndef PGLITE_EXPORT
+#ifdef __EMSCRIPTEN__
+#define PGLITE_EXPORT(name) __attribute__((export_name(#name)))
+#else
+#define PGLITE_EXPORT(name)
+#endif
+#endif
+
+/* ============================================================================
+ * TRANSPORT DISPATCH
+ *
+ * Resolved by the preprocessor, so recv()/send() inline straight into the
+ * selected transport.
+ * ============================================================================ */
+
+/**
+ * Read up to n bytes of query input.
+ * Returns the number of bytes read, 0 when no input is pending.
+ */
+static inline ssize_t pglite_transport_recv(void *buf, size_t n) {
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE
+    return pglite_trampoline_recv(buf, n);
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_IMPORTS
+    return pglite_imports_recv(buf, n);
+#else
+    return pglite_polling_read(buf, n);
+#endif
+}
+
+/**
+ * Hand n bytes of result data to the host.
+ * The transport may hold them back until a flush point (ReadyForQuery).
+ */
+static inline ssize_t pglite_transport_send(const void *buf, size_t n) {
+#if PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE
+    return pglite_trampoline_send(buf, n);
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_IMPORTS
+    return pglite_imports_send(buf, n);
+#else
+    return pglite_polling_send(buf, n);
+#endif
+}
+
+/**
+ * Make everything sent so far visible to the host.
+ * A no-op for transports that never hold output back.
+ */
+static inline void pglite_transport_flush(void) {
+#if (PGLITE_TRANSPORT == PGLITE_TRANSPORT_TRAMPOLINE && defined(PGLITE_COMM_BATCHED)) || \
+    (PGLITE_TRANSPORT == PGLITE_TRANSPORT_IMPORTS && defined(PGLITE_COMM_VECTORED))
+    pglite_flush_output();
+#elif PGLITE_TRANSPORT == PGLITE_TRANSPORT_POLLING
+    pglite_polling_flush();
+#endif
+}
+
+/**
+ * Name of the transport this module was built with, so the host can check
+ * it loaded the TypeScript side that matches.
+ */
+PGLITE_EXPORT(pglite_transport_name)
+const char *pglite_transport_name(void) {
+    return PGLITE_TRANSPORT_NAME;
+}
+
+#ifdef __EMSCRIPTEN__
+
+/* ============================================================================
+ * QUERY STATE AND SOCKET FUNCTION OVERRIDES
+ *
+ * Shared by every transport. PostgreSQL calls these for network I/O; recv and
+ * send go to the selected transport, the rest are the usual no-op stubs.
+ * ============================================================================ */
+
+volatile int querylen = 0;
+volatile FILE* queryfp = NULL;
+
+int EMSCRIPTEN_KEEPALIVE fcntl(int __fd, int __cmd, ...) {
+    return 0;
+}
+
+int EMSCRIPTEN_KEEPALIVE setsockopt(int __fd, int __level, int __optname,
+    const void *__optval, socklen_t __optlen) {
+    return 0;
+}
+
+int EMSCRIPTEN_KEEPALIVE getsockopt(int __fd, int __level, int __optname,
+    void *__restrict __optval,
+    socklen_t *__restrict __optlen) {
+    return 0;
+}
+
+int EMSCRIPTEN_KEEPALIVE getsockname(int __fd, struct sockaddr * __addr,
+    socklen_t *__restrict __len) {
+    return 0;
+}
+
+ssize_t EMSCRIPTEN_KEEPALIVE
+recv(int __fd, void *__buf, size_t __n, int __flags) {
+    return pglite_transport_recv(__buf, __n);
+}
+
+ssize_t EMSCRIPTEN_KEEPALIVE
+send(int __fd, const void *__buf, size_t __n, int __flags) {
+    return pglite_transport_send(__buf, __n);
+}
+
+int EMSCRIPTEN_KEEPALIVE
+connect(int socket, const struct sockaddr *address, socklen_t address_len) {
+    return 0;
+}
+
+struct pollfd {
+    int   fd;
+    short events;
+    short revents;
+};
+
+int EMSCRIPTEN_KEEPALIVE
+poll(struct pollfd fds[], ssize_t nfds, int timeout) {
+    return nfds;
+}
+
+#endif // __EMSCRIPTEN__
+
+#endif // PGLITE_COMM_UNIFIED_H
+
+#endif // __EMSCRIPTEN__ || PGLITE_COMM_NATIVE
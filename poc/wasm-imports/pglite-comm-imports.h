@@ -17,24 +17,62 @@
  *   3. Remove addFunction/removeFunction from EXPORTED_RUNTIME_METHODS
  *   4. Provide pglite_js_read and pglite_js_write in WebAssembly imports
  *   5. Remove calls to _set_read_write_cbs in JavaScript
+ *
+ * Optionally, large inputs can skip pglite_js_read entirely: JS serializes
+ * the message straight into a WASM-resident input buffer (see INPUT BUFFER
+ * below) and recv() serves it without calling out to JavaScript.
+ *
+ * Building with -DPGLITE_COMM_VECTORED switches to vectored imports
+ * (pglite_js_readv / pglite_js_writev): send() gathers pqcomm's fragments
+ * in WASM and a whole multi-message response crosses into JS once. Provide
+ * those two imports instead of pglite_js_read / pglite_js_write.
+ *
+ * Also usable as a transport behind poc/comm/pglite-comm.h: with
+ * PGLITE_COMM_TRANSPORT_ONLY defined only pglite_imports_recv/send are
+ * provided, and the socket overrides and stubs come from the unified header.
+ * PGLITE_COMM_NATIVE builds that mode without Emscripten; the imports are
+ * then ordinary C functions the host defines.
  */
 
-#if defined(__EMSCRIPTEN__)
+#if defined(__EMSCRIPTEN__) || defined(PGLITE_COMM_NATIVE)
 
 #ifndef PGLITE_COMM_IMPORTS_H
 #define PGLITE_COMM_IMPORTS_H
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#else
+#include <time.h>
+#endif
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 /* ============================================================================
  * QUERY STATE (shared with JavaScript)
  * ============================================================================ */
 
+#ifndef PGLITE_COMM_TRANSPORT_ONLY
 volatile int querylen = 0;
 volatile FILE* queryfp = NULL;
+#endif
+
+#ifndef PGLITE_EXPORT
+#ifdef __EMSCRIPTEN__
+#define PGLITE_EXPORT(name) __attribute__((export_name(#name)))
+#else
+#define PGLITE_EXPORT(name)
+#endif
+#endif
+
+#ifdef __EMSCRIPTEN__
+#define PGLITE_IMPORT(name) \
+    __attribute__((import_module("env"))) __attribute__((import_name(#name)))
+#else
+#define PGLITE_IMPORT(name)
+#endif
 
 /* ============================================================================
  * WASM IMPORT DECLARATIONS
@@ -42,7 +80,8 @@ volatile FILE* queryfp = NULL;
  * These functions are provided by JavaScript at WebAssembly instantiation time.
  * They replace the dynamically-registered function pointers from pglite-comm.h.
  *
- * The import_module and import_name attributes tell Emscripten to generate
+ * PGLITE_IMPORT expands to the import_module and import_name attributes,
+ * which tell Emscripten to generate
  * WASM import entries instead of expecting local function definitions.
  * ============================================================================ */
 
@@ -62,8 +101,7 @@ volatile FILE* queryfp = NULL;
  *   3. Track read position for subsequent calls
  *   4. Return actual bytes copied
  */
-__attribute__((import_module("env")))
-__attribute__((import_name("pglite_js_read")))
+PGLITE_IMPORT(pglite_js_read)
 extern ssize_t pglite_js_read(void *buffer, size_t max_length);
 
 /**
@@ -82,10 +120,396 @@ extern ssize_t pglite_js_read(void *buffer, size_t max_length);
  *   3. Accumulate results for the caller
  *   4. Return bytes processed (usually same as length)
  */
-__attribute__((import_module("env")))
-__attribute__((import_name("pglite_js_write")))
+PGLITE_IMPORT(pglite_js_write)
 extern ssize_t pglite_js_write(void *buffer, size_t length);
 
+/**
+ * One entry of a vectored read or write.
+ *
+ * Fixed at two 32-bit words on wasm32, so JavaScript reads entry i as
+ * HEAPU32[(iov >> 2) + 2 * i] (base) and HEAPU32[(iov >> 2) + 2 * i + 1]
+ * (length).
+ */
+typedef struct {
+    void *base;
+    size_t len;
+} pglite_iovec_t;
+
+#ifdef PGLITE_COMM_VECTORED
+
+/**
+ * Scatter data FROM JavaScript into several WASM memory regions.
+ *
+ * @param iov     Array of regions to fill, in order
+ * @param iovcnt  Number of entries in iov
+ * @return        Total bytes copied (0 if no data available)
+ *
+ * JavaScript should fill each region completely before moving on to the
+ * next, and stop at the first region it cannot fill.
+ */
+PGLITE_IMPORT(pglite_js_readv)
+extern ssize_t pglite_js_readv(const pglite_iovec_t *iov, int iovcnt);
+
+/**
+ * Gather data TO JavaScript from several WASM memory regions.
+ *
+ * @param iov     Array of regions to send, in order
+ * @param iovcnt  Number of entries in iov
+ * @return        Total bytes processed (usually the sum of all lengths)
+ *
+ * JavaScript should treat the regions as one contiguous byte stream; they
+ * may split protocol messages anywhere.
+ */
+PGLITE_IMPORT(pglite_js_writev)
+extern ssize_t pglite_js_writev(const pglite_iovec_t *iov, int iovcnt);
+
+#endif /* PGLITE_COMM_VECTORED */
+
+/* ============================================================================
+ * BOUNDARY CROSSING COUNTER
+ *
+ * Every call into one of the JavaScript imports above is counted, so the
+ * host can check how many WASM -> JS transitions a query really took. JS
+ * resets it before _interactive_one and reads it afterwards.
+ * ============================================================================ */
+
+static uint32_t pglite_boundary_crossings = 0;
+
+PGLITE_EXPORT(pglite_get_boundary_crossings)
+uint32_t pglite_get_boundary_crossings(void) {
+    return pglite_boundary_crossings;
+}
+
+PGLITE_EXPORT(pglite_reset_boundary_crossings)
+void pglite_reset_boundary_crossings(void) {
+    pglite_boundary_crossings = 0;
+}
+
+/* ============================================================================
+ * INPUT BUFFER - Zero-copy query input
+ *
+ * With pglite_js_read every recv() crosses into JS, which copies the next
+ * chunk of its own Uint8Array into the heap. For bulk loads (large COPY FROM
+ * payloads, big parameter blobs) that is one JS-side copy per chunk.
+ *
+ * Instead JS can allocate an input buffer here, have the serializer write
+ * the message into it through a HEAPU8 view, and publish its length with
+ * pglite_set_input_length(). recv() then serves the message by advancing a
+ * cursor; the only copy left is the memcpy into PostgreSQL's own receive
+ * buffer, which recv()'s contract requires and which never leaves WASM.
+ *
+ * While a message is published recv() never calls pglite_js_read, and
+ * reports 0 once the message is consumed. Publishing length 0 goes back to
+ * the import.
+ * ============================================================================ */
+
+static uint8_t *pglite_input_buffer = NULL;
+static size_t pglite_input_capacity = 0;
+static size_t pglite_input_length = 0;
+static size_t pglite_input_offset = 0;
+
+/**
+ * Allocate (or reuse) an input buffer of at least `capacity` bytes.
+ *
+ * Returns the buffer pointer, or 0 if the allocation failed. The buffer is
+ * only grown, never shrunk, so steady-state queries allocate nothing. Any
+ * published message is dropped. Growing may grow WASM memory: take the
+ * HEAPU8 view after this returns.
+ */
+PGLITE_EXPORT(pglite_alloc_input_buffer)
+void *pglite_alloc_input_buffer(size_t capacity) {
+    pglite_input_length = 0;
+    pglite_input_offset = 0;
+
+    if (pglite_input_buffer && capacity <= pglite_input_capacity) {
+        return pglite_input_buffer;
+    }
+
+    uint8_t *buffer = realloc(pglite_input_buffer, capacity);
+    if (!buffer) {
+        return NULL;
+    }
+    pglite_input_buffer = buffer;
+    pglite_input_capacity = capacity;
+    return buffer;
+}
+
+/**
+ * Publish the first `length` bytes of the input buffer as the next message
+ * and rewind the read cursor. Returns -1 if `length` exceeds the buffer.
+ */
+PGLITE_EXPORT(pglite_set_input_length)
+int pglite_set_input_length(size_t length) {
+    if (length > pglite_input_capacity) {
+        return -1;
+    }
+    pglite_input_length = length;
+    pglite_input_offset = 0;
+    return 0;
+}
+
+/**
+ * Bytes of the published message that recv() has consumed so far
+ */
+PGLITE_EXPORT(pglite_get_input_offset)
+size_t pglite_get_input_offset(void) {
+    return pglite_input_offset;
+}
+
+/* ============================================================================
+ * COMM STATS - compile with -DPGLITE_COMM_STATS
+ *
+ * Counts what crosses the socket layer so query latency can be split
+ * between the executor and the JS boundary. JS resets the block before
+ * each _interactive_one and reads it afterwards through
+ * pglite_get_comm_stats(); the layout is shared by all comm variants.
+ *
+ * Timing uses emscripten_get_now(), itself a host call, so host_time_ms
+ * slightly overstates the boundary cost. Builds without the flag pay
+ * nothing.
+ * ============================================================================ */
+
+#ifdef PGLITE_COMM_STATS
+
+#define PGLITE_STATS_BUCKETS 32
+
+/**
+ * 296 bytes, no padding: u32 counters at 0, doubles at 16, histograms at
+ * 40 (recv) and 168 (send). Histogram bucket i counts transfers of
+ * [2^i, 2^(i+1)) bytes; empty transfers land in bucket 0.
+ */
+typedef struct {
+    uint32_t recv_calls;
+    uint32_t send_calls;
+    uint32_t short_reads;   // recv() returned less than it was asked for
+    uint32_t host_calls;
+    double recv_bytes;
+    double send_bytes;
+    double host_time_ms;    // cumulative time inside host callbacks
+    uint32_t recv_size_log2[PGLITE_STATS_BUCKETS];
+    uint32_t send_size_log2[PGLITE_STATS_BUCKETS];
+} pglite_comm_stats_t;
+
+static pglite_comm_stats_t pglite_comm_stats;
+
+PGLITE_EXPORT(pglite_get_comm_stats)
+pglite_comm_stats_t *pglite_get_comm_stats(void) {
+    return &pglite_comm_stats;
+}
+
+PGLITE_EXPORT(pglite_reset_comm_stats)
+void pglite_reset_comm_stats(void) {
+    memset(&pglite_comm_stats, 0, sizeof(pglite_comm_stats));
+}
+
+static inline double pglite_stats_now(void) {
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+
+static inline uint32_t pglite_stats_bucket(size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t bucket = 63 - __builtin_clzll((unsigned long long)n);
+    return bucket < PGLITE_STATS_BUCKETS ? bucket : PGLITE_STATS_BUCKETS - 1;
+}
+
+static inline void pglite_stats_recv(size_t asked, ssize_t got) {
+    size_t n = got > 0 ? (size_t)got : 0;
+    pglite_comm_stats.recv_calls++;
+    pglite_comm_stats.recv_bytes += n;
+    pglite_comm_stats.short_reads += n < asked;
+    pglite_comm_stats.recv_size_log2[pglite_stats_bucket(n)]++;
+}
+
+static inline void pglite_stats_send(size_t n) {
+    pglite_comm_stats.send_calls++;
+    pglite_comm_stats.send_bytes += n;
+    pglite_comm_stats.send_size_log2[pglite_stats_bucket(n)]++;
+}
+
+#define PGLITE_STATS_RECV(asked, got) pglite_stats_recv((asked), (got))
+#define PGLITE_STATS_SEND(n) pglite_stats_send(n)
+#define PGLITE_STATS_HOST_BEGIN() \
+    double pglite_stats_start = pglite_stats_now(); \
+    pglite_comm_stats.host_calls++
+#define PGLITE_STATS_HOST_END() \
+    pglite_comm_stats.host_time_ms += pglite_stats_now() - pglite_stats_start
+
+#else
+
+#define PGLITE_STATS_RECV(asked, got) ((void)0)
+#define PGLITE_STATS_SEND(n) ((void)0)
+#define PGLITE_STATS_HOST_BEGIN() ((void)0)
+#define PGLITE_STATS_HOST_END() ((void)0)
+
+#endif /* PGLITE_COMM_STATS */
+
+#ifdef PGLITE_COMM_VECTORED
+/* ============================================================================
+ * OUTPUT GATHERING
+ *
+ * pqcomm flushes its 8KB send buffer with one send() per chunk, plus a
+ * send() per message once a message is larger than that buffer. Rather
+ * than crossing into JS for each, send() copies small fragments into a
+ * gather area and returns. Pending output goes to JS in one writev when:
+ *
+ *   - a fragment ends with ReadyForQuery (the response is complete),
+ *   - the gather area would overflow,
+ *   - recv() is about to ask JS for input (COPY FROM needs the host to
+ *     see CopyInResponse first), or
+ *   - JS calls pglite_flush_output().
+ *
+ * A fragment over half the gather area is not copied: it joins the
+ * same writev as an iovec pointing straight at pqcomm's buffer.
+ * ============================================================================ */
+
+#ifndef PGLITE_GATHER_SIZE
+#define PGLITE_GATHER_SIZE (64 * 1024)
+#endif
+
+static uint8_t pglite_gather_buf[PGLITE_GATHER_SIZE];
+static size_t pglite_gather_used = 0;
+
+/**
+ * Send everything gathered so far, plus an optional in-place fragment,
+ * in a single pglite_js_writev call.
+ */
+static ssize_t pglite_gather_flush(const void *extra, size_t extra_len) {
+    pglite_iovec_t iov[2];
+    int iovcnt = 0;
+
+    if (pglite_gather_used > 0) {
+        iov[iovcnt].base = pglite_gather_buf;
+        iov[iovcnt].len = pglite_gather_used;
+        iovcnt++;
+    }
+    if (extra_len > 0) {
+        iov[iovcnt].base = (void *)extra;
+        iov[iovcnt].len = extra_len;
+        iovcnt++;
+    }
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    pglite_gather_used = 0;
+    pglite_boundary_crossings++;
+
+    PGLITE_STATS_HOST_BEGIN();
+    ssize_t wrote = pglite_js_writev(iov, iovcnt);
+    PGLITE_STATS_HOST_END();
+    return wrote;
+}
+
+/* ReadyForQuery is always the last message of a response: 'Z' len=5 status */
+static int pglite_ends_with_ready_for_query(const uint8_t *buf, size_t n) {
+    if (n < 6) {
+        return 0;
+    }
+    const uint8_t *m = buf + n - 6;
+    return m[0] == 'Z' && m[1] == 0 && m[2] == 0 && m[3] == 0 && m[4] == 5;
+}
+
+/**
+ * Hand any gathered output to JavaScript now.
+ * Returns the byte count reported by pglite_js_writev, 0 if nothing was
+ * pending.
+ */
+PGLITE_EXPORT(pglite_flush_output)
+ssize_t pglite_flush_output(void) {
+    return pglite_gather_flush(NULL, 0);
+}
+#endif /* PGLITE_COMM_VECTORED */
+
+/* ============================================================================
+ * TRANSPORT ENTRY POINTS
+ *
+ * What recv() and send() do, callable on their own so the unified header
+ * can dispatch to them directly.
+ * ============================================================================ */
+
+/**
+ * Read query input: from the published input buffer if there is one,
+ * otherwise from our imported pglite_js_read function.
+ */
+static inline ssize_t pglite_imports_recv(void *buf, size_t n) {
+    ssize_t got;
+
+    if (pglite_input_length > 0) {
+        size_t available = pglite_input_length - pglite_input_offset;
+        size_t count = n < available ? n : available;
+        memcpy(buf, pglite_input_buffer + pglite_input_offset, count);
+        pglite_input_offset += count;
+        PGLITE_STATS_RECV(n, (ssize_t)count);
+        return (ssize_t)count;
+    }
+
+#ifdef PGLITE_COMM_VECTORED
+    /* The host may be waiting on output we are still holding */
+    pglite_gather_flush(NULL, 0);
+
+    pglite_iovec_t iov = { buf, n };
+    pglite_boundary_crossings++;
+    PGLITE_STATS_HOST_BEGIN();
+    got = pglite_js_readv(&iov, 1);
+    PGLITE_STATS_HOST_END();
+#else
+    /* Delegate to JavaScript import - no function pointer indirection */
+    pglite_boundary_crossings++;
+    PGLITE_STATS_HOST_BEGIN();
+    got = pglite_js_read(buf, n);
+    PGLITE_STATS_HOST_END();
+#endif
+
+    PGLITE_STATS_RECV(n, got);
+    return got;
+}
+
+/**
+ * Send result data: straight to pglite_js_write, or with
+ * PGLITE_COMM_VECTORED gathered for a later pglite_js_writev.
+ */
+static inline ssize_t pglite_imports_send(const void *buf, size_t n) {
+    PGLITE_STATS_SEND(n);
+
+#ifdef PGLITE_COMM_VECTORED
+    const uint8_t *bytes = (const uint8_t *)buf;
+
+    if (n > PGLITE_GATHER_SIZE / 2) {
+        /* Large fragment: send it in place behind whatever is pending */
+        pglite_gather_flush(bytes, n);
+        return (ssize_t)n;
+    }
+
+    if (n > PGLITE_GATHER_SIZE - pglite_gather_used) {
+        pglite_gather_flush(NULL, 0);
+    }
+    memcpy(pglite_gather_buf + pglite_gather_used, bytes, n);
+    pglite_gather_used += n;
+
+    if (pglite_ends_with_ready_for_query(bytes, n)) {
+        pglite_gather_flush(NULL, 0);
+    }
+    return (ssize_t)n;
+#else
+    /* Delegate to JavaScript import - no function pointer indirection */
+    pglite_boundary_crossings++;
+    PGLITE_STATS_HOST_BEGIN();
+    ssize_t wrote = pglite_js_write((void *)buf, n);
+    PGLITE_STATS_HOST_END();
+    return wrote;
+#endif
+}
+
+#ifndef PGLITE_COMM_TRANSPORT_ONLY
+
 /* ============================================================================
  * SOCKET FUNCTION OVERRIDES
  *
@@ -98,26 +522,24 @@ extern ssize_t pglite_js_write(void *buffer, size_t length);
  * Override recv() to read from JavaScript instead of a socket.
  *
  * PostgreSQL calls this when it wants to read query data.
- * We delegate directly to our imported pglite_js_read function.
+ * A message published in the input buffer is served from WASM memory;
+ * otherwise we delegate directly to our imported pglite_js_read function.
  */
 ssize_t EMSCRIPTEN_KEEPALIVE
 recv(int __fd, void *__buf, size_t __n, int __flags) {
-    /* Delegate to JavaScript import - no function pointer indirection */
-    ssize_t got = pglite_js_read(__buf, __n);
-    return got;
+    return pglite_imports_recv(__buf, __n);
 }
 
 /**
  * Override send() to write to JavaScript instead of a socket.
  *
  * PostgreSQL calls this when it wants to send result data.
- * We delegate directly to our imported pglite_js_write function.
+ * We delegate directly to our imported pglite_js_write function, or with
+ * PGLITE_COMM_VECTORED gather the data for a later pglite_js_writev.
  */
 ssize_t EMSCRIPTEN_KEEPALIVE
 send(int __fd, const void *__buf, size_t __n, int __flags) {
-    /* Delegate to JavaScript import - no function pointer indirection */
-    ssize_t wrote = pglite_js_write((void *)__buf, __n);
-    return wrote;
+    return pglite_imports_send(__buf, __n);
 }
 
 /* ============================================================================
@@ -206,6 +628,8 @@ poll(struct pollfd fds[], ssize_t nfds, int timeout) {
     return nfds; /* All fds ready */
 }
 
+#endif /* PGLITE_COMM_TRANSPORT_ONLY */
+
 #endif /* PGLITE_COMM_IMPORTS_H */
 
-#endif /* __EMSCRIPTEN__ */
+#endif /* __EMSCRIPTEN__ || PGLITE_COMM_NATIVE */
@@ -16,6 +16,10 @@
  *   4. Before queries: handler.setInput(queryBytes)
  *   5. After queries: handler.getOutput() returns result bytes
  *
+ * For large inputs, step 4 can be replaced by writing the message straight
+ * into WASM memory: handler.getInputBuffer(size) returns a heap view to
+ * serialize into, and handler.commitInput(length) publishes it to recv().
+ *
  * @module pglite-imports
  */
 
@@ -25,6 +29,11 @@
  * These match the C declarations in pglite-comm-imports.h:
  *   extern ssize_t pglite_js_read(void *buffer, size_t max_length);
  *   extern ssize_t pglite_js_write(void *buffer, size_t length);
+ *   extern ssize_t pglite_js_readv(const pglite_iovec_t *iov, int iovcnt);
+ *   extern ssize_t pglite_js_writev(const pglite_iovec_t *iov, int iovcnt);
+ *
+ * A build uses either the first pair or, with PGLITE_COMM_VECTORED, the
+ * vectored pair; providing all four is harmless.
  */
 export interface PGliteWasmImports {
   /**
@@ -44,6 +53,24 @@ export interface PGliteWasmImports {
    * @returns Number of bytes actually written
    */
   pglite_js_write: (bufferPtr: number, length: number) => number
+
+  /**
+   * Vectored read - fill several WASM memory regions in order
+   *
+   * @param iovPtr - Pointer to an array of { base, len } u32 pairs
+   * @param iovcnt - Number of entries in the array
+   * @returns Total bytes read
+   */
+  pglite_js_readv: (iovPtr: number, iovcnt: number) => number
+
+  /**
+   * Vectored write - receive several WASM memory regions as one stream
+   *
+   * @param iovPtr - Pointer to an array of { base, len } u32 pairs
+   * @param iovcnt - Number of entries in the array
+   * @returns Total bytes written
+   */
+  pglite_js_writev: (iovPtr: number, iovcnt: number) => number
 }
 
 /**
@@ -53,6 +80,10 @@ export interface PGliteWasmImports {
 export interface WasmMemory {
   /** WASM heap as Uint8Array view */
   HEAPU8: Uint8Array
+
+  /** Input buffer exports from pglite-comm-imports.h (zero-copy input) */
+  _pglite_alloc_input_buffer?: (capacity: number) => number
+  _pglite_set_input_length?: (length: number) => number
 }
 
 /**
@@ -99,6 +130,33 @@ export interface PGliteImportHandler {
    */
   setInput: (data: Uint8Array) => void
 
+  /**
+   * Get a view of a WASM-resident input buffer of at least `size` bytes
+   *
+   * Serialize the next message directly into the returned view, then call
+   * commitInput(). recv() serves it from WASM memory without calling
+   * pglite_js_read, so the bytes are never copied by JavaScript. The buffer
+   * is reused across calls and only grows.
+   *
+   * The view aliases WASM memory: do not keep it across calls into WASM,
+   * since memory growth detaches it.
+   *
+   * @param size - Minimum buffer size in bytes
+   * @returns View of the input buffer, exactly `size` bytes long
+   * @throws If the module was built without the input buffer exports
+   */
+  getInputBuffer: (size: number) => Uint8Array
+
+  /**
+   * Publish the first `length` bytes of the input buffer to recv()
+   *
+   * Call this BEFORE executing a query via _interactive_one, in place of
+   * setInput().
+   *
+   * @param length - Number of bytes written into the input buffer
+   */
+  commitInput: (length: number) => void
+
   /**
    * Get the output data from the last query
    *
@@ -112,7 +170,8 @@ export interface PGliteImportHandler {
   /**
    * Reset state for the next query
    *
-   * Clears input buffer, read position, and output chunks.
+   * Clears input buffer, read position, output chunks and the boundary
+   * crossing count.
    */
   reset: () => void
 
@@ -130,6 +189,12 @@ export interface PGliteImportHandler {
    * Get total bytes written (for debugging)
    */
   getTotalBytesWritten: () => number
+
+  /**
+   * Get the number of calls WASM made into the imports since the last
+   * reset(), i.e. WASM -> JS boundary crossings for the current query
+   */
+  getBoundaryCrossings: () => number
 }
 
 /**
@@ -187,6 +252,62 @@ export function createPGliteImportHandler(): PGliteImportHandler {
   /** Debug counters */
   let totalBytesRead = 0
   let totalBytesWritten = 0
+  let boundaryCrossings = 0
+
+  /**
+   * Copy up to maxLength bytes of pending input to WASM memory
+   */
+  const copyInput = (
+    mod: WasmMemory,
+    bufferPtr: number,
+    maxLength: number
+  ): number => {
+    // Check we have input data
+    if (!inputBuffer) {
+      return 0
+    }
+
+    // Calculate available bytes
+    const available = inputBuffer.length - inputOffset
+    if (available === 0) {
+      return 0
+    }
+
+    // Determine how much to read
+    const length = Math.min(available, maxLength)
+
+    // Copy data to WASM memory
+    mod.HEAPU8.set(
+      inputBuffer.subarray(inputOffset, inputOffset + length),
+      bufferPtr
+    )
+
+    // Update position
+    inputOffset += length
+    totalBytesRead += length
+
+    return length
+  }
+
+  /**
+   * Decode a pglite_iovec_t array (two little-endian u32 per entry)
+   */
+  const readIovecs = (
+    mod: WasmMemory,
+    iovPtr: number,
+    iovcnt: number
+  ): Array<[number, number]> => {
+    const view = new DataView(mod.HEAPU8.buffer, mod.HEAPU8.byteOffset)
+    const iovecs: Array<[number, number]> = []
+    for (let i = 0; i < iovcnt; i++) {
+      const entry = iovPtr + i * 8
+      iovecs.push([
+        view.getUint32(entry, true),
+        view.getUint32(entry + 4, true)
+      ])
+    }
+    return iovecs
+  }
 
   // ============================================================================
   // IMPORT FUNCTIONS
@@ -200,37 +321,15 @@ export function createPGliteImportHandler(): PGliteImportHandler {
      * Copies data from our inputBuffer into WASM memory.
      */
     pglite_js_read: (bufferPtr: number, maxLength: number): number => {
+      boundaryCrossings++
+
       // Check module is set
       if (!module) {
         console.warn('pglite_js_read called before module set')
         return 0
       }
 
-      // Check we have input data
-      if (!inputBuffer) {
-        return 0
-      }
-
-      // Calculate available bytes
-      const available = inputBuffer.length - inputOffset
-      if (available === 0) {
-        return 0
-      }
-
-      // Determine how much to read
-      const length = Math.min(available, maxLength)
-
-      // Copy data to WASM memory
-      module.HEAPU8.set(
-        inputBuffer.subarray(inputOffset, inputOffset + length),
-        bufferPtr
-      )
-
-      // Update position
-      inputOffset += length
-      totalBytesRead += length
-
-      return length
+      return copyInput(module, bufferPtr, maxLength)
     },
 
     /**
@@ -240,6 +339,8 @@ export function createPGliteImportHandler(): PGliteImportHandler {
      * Copies data from WASM memory into our outputChunks array.
      */
     pglite_js_write: (bufferPtr: number, length: number): number => {
+      boundaryCrossings++
+
       // Check module is set
       if (!module) {
         console.warn('pglite_js_write called before module set')
@@ -254,6 +355,58 @@ export function createPGliteImportHandler(): PGliteImportHandler {
       totalBytesWritten += length
 
       return length
+    },
+
+    /**
+     * Vectored read implementation
+     *
+     * Fills each region in turn, stopping at the first one the remaining
+     * input cannot fill.
+     */
+    pglite_js_readv: (iovPtr: number, iovcnt: number): number => {
+      boundaryCrossings++
+
+      if (!module) {
+        console.warn('pglite_js_readv called before module set')
+        return 0
+      }
+
+      let total = 0
+      for (const [base, len] of readIovecs(module, iovPtr, iovcnt)) {
+        const n = copyInput(module, base, len)
+        total += n
+        if (n < len) break
+      }
+      return total
+    },
+
+    /**
+     * Vectored write implementation
+     *
+     * Gathers all regions into a single output chunk, so a response that
+     * crossed the boundary once is also one chunk for the caller.
+     */
+    pglite_js_writev: (iovPtr: number, iovcnt: number): number => {
+      boundaryCrossings++
+
+      if (!module) {
+        console.warn('pglite_js_writev called before module set')
+        return 0
+      }
+
+      const iovecs = readIovecs(module, iovPtr, iovcnt)
+      const total = iovecs.reduce((sum, [, len]) => sum + len, 0)
+      const bytes = new Uint8Array(total)
+      let offset = 0
+      for (const [base, len] of iovecs) {
+        bytes.set(module.HEAPU8.subarray(base, base + len), offset)
+        offset += len
+      }
+      outputChunks.push(bytes)
+
+      totalBytesWritten += total
+
+      return total
     }
   }
 
@@ -273,17 +426,46 @@ export function createPGliteImportHandler(): PGliteImportHandler {
       inputOffset = 0
     },
 
+    getInputBuffer: (size: number) => {
+      if (!module?._pglite_alloc_input_buffer) {
+        throw new Error('WASM module has no zero-copy input buffer support')
+      }
+      // Drop any JS-side input so recv() cannot mix the two sources
+      inputBuffer = undefined
+      inputOffset = 0
+
+      const ptr = module._pglite_alloc_input_buffer(size)
+      if (!ptr) {
+        throw new Error(`Failed to allocate ${size} byte input buffer`)
+      }
+      // Read HEAPU8 only now: the allocation may have grown memory
+      return module.HEAPU8.subarray(ptr, ptr + size)
+    },
+
+    commitInput: (length: number) => {
+      if (!module?._pglite_set_input_length) {
+        throw new Error('WASM module has no zero-copy input buffer support')
+      }
+      if (module._pglite_set_input_length(length) !== 0) {
+        throw new Error(`Input length ${length} exceeds the input buffer`)
+      }
+    },
+
     getOutput: () => outputChunks,
 
     reset: () => {
       inputBuffer = undefined
       inputOffset = 0
       outputChunks = []
+      boundaryCrossings = 0
+      // Hand recv() back to pglite_js_read
+      module?._pglite_set_input_length?.(0)
     },
 
     getReadPosition: () => inputOffset,
     getTotalBytesRead: () => totalBytesRead,
-    getTotalBytesWritten: () => totalBytesWritten
+    getTotalBytesWritten: () => totalBytesWritten,
+    getBoundaryCrossings: () => boundaryCrossings
   }
 }
 
@@ -306,7 +488,9 @@ export function mergePGliteImports(
     env: {
       ...(emscriptenImports.env as Record<string, unknown>),
       pglite_js_read: pgliteImports.pglite_js_read,
-      pglite_js_write: pgliteImports.pglite_js_write
+      pglite_js_write: pgliteImports.pglite_js_write,
+      pglite_js_readv: pgliteImports.pglite_js_readv,
+      pglite_js_writev: pgliteImports.pglite_js_writev
     }
   }
 }
@@ -207,6 +207,168 @@ describe('PGlite WASM Imports POC', () => {
     })
   })
 
+  describe('vectored imports', () => {
+    /** Write a pglite_iovec_t array into the mock heap */
+    function writeIovecs(ptr: number, iovecs: Array<[number, number]>) {
+      const view = new DataView(mockModule.HEAPU8.buffer)
+      iovecs.forEach(([base, len], i) => {
+        view.setUint32(ptr + i * 8, base, true)
+        view.setUint32(ptr + i * 8 + 4, len, true)
+      })
+    }
+
+    it('should gather all regions into one output chunk', () => {
+      mockModule.HEAPU8.set(new Uint8Array([1, 2, 3]), 100)
+      mockModule.HEAPU8.set(new Uint8Array([4, 5]), 500)
+      writeIovecs(0, [
+        [100, 3],
+        [500, 2]
+      ])
+
+      const bytesWritten = handler.imports.pglite_js_writev(0, 2)
+
+      expect(bytesWritten).toBe(5)
+      expect(handler.getOutput()).toEqual([new Uint8Array([1, 2, 3, 4, 5])])
+      expect(handler.getTotalBytesWritten()).toBe(5)
+    })
+
+    it('should scatter input across regions in order', () => {
+      handler.setInput(new Uint8Array([1, 2, 3, 4, 5]))
+      writeIovecs(0, [
+        [100, 2],
+        [200, 10],
+        [300, 10]
+      ])
+
+      const bytesRead = handler.imports.pglite_js_readv(0, 3)
+
+      expect(bytesRead).toBe(5)
+      expect(mockModule.HEAPU8.slice(100, 102)).toEqual(new Uint8Array([1, 2]))
+      expect(mockModule.HEAPU8.slice(200, 203)).toEqual(
+        new Uint8Array([3, 4, 5])
+      )
+      expect(mockModule.HEAPU8[300]).toBe(0)
+    })
+
+    it('should count one boundary crossing per import call', () => {
+      mockModule.HEAPU8.set(new Uint8Array(64).fill(7), 100)
+      writeIovecs(0, [
+        [100, 32],
+        [132, 32]
+      ])
+
+      handler.imports.pglite_js_writev(0, 2)
+      handler.imports.pglite_js_read(1000, 10)
+      expect(handler.getBoundaryCrossings()).toBe(2)
+
+      handler.reset()
+      expect(handler.getBoundaryCrossings()).toBe(0)
+    })
+  })
+
+  describe('zero-copy input buffer', () => {
+    const INPUT_PTR = 4096
+
+    /**
+     * Mock of the input buffer exports and recv() in pglite-comm-imports.h
+     */
+    function createInputBufferModule() {
+      let capacity = 0
+      let length = 0
+      let offset = 0
+      let jsReads = 0
+
+      const mod = {
+        HEAPU8: new Uint8Array(1024 * 1024),
+        _pglite_alloc_input_buffer: (size: number) => {
+          capacity = Math.max(capacity, size)
+          length = 0
+          offset = 0
+          return INPUT_PTR
+        },
+        _pglite_set_input_length: (len: number) => {
+          if (len > capacity) return -1
+          length = len
+          offset = 0
+          return 0
+        }
+      }
+
+      const recv = (bufPtr: number, n: number): number => {
+        if (length > 0) {
+          const count = Math.min(n, length - offset)
+          mod.HEAPU8.copyWithin(
+            bufPtr,
+            INPUT_PTR + offset,
+            INPUT_PTR + offset + count
+          )
+          offset += count
+          return count
+        }
+        jsReads++
+        return handler.imports.pglite_js_read(bufPtr, n)
+      }
+
+      return { mod, recv, jsReads: () => jsReads }
+    }
+
+    it('should return a view into WASM memory', () => {
+      const { mod } = createInputBufferModule()
+      handler.setModule(mod)
+
+      const view = handler.getInputBuffer(100)
+
+      expect(view.length).toBe(100)
+      expect(view.buffer).toBe(mod.HEAPU8.buffer)
+      expect(view.byteOffset).toBe(INPUT_PTR)
+    })
+
+    it('should serve committed input without calling pglite_js_read', () => {
+      const { mod, recv, jsReads } = createInputBufferModule()
+      handler.setModule(mod)
+
+      const view = handler.getInputBuffer(10)
+      view.set([1, 2, 3, 4, 5, 6, 7, 8, 9, 10])
+      handler.commitInput(10)
+
+      expect(recv(0, 4)).toBe(4)
+      expect(recv(4, 100)).toBe(6)
+      expect(recv(10, 100)).toBe(0)
+      expect(mod.HEAPU8.slice(0, 10)).toEqual(
+        new Uint8Array([1, 2, 3, 4, 5, 6, 7, 8, 9, 10])
+      )
+      expect(jsReads()).toBe(0)
+    })
+
+    it('should fall back to pglite_js_read after reset', () => {
+      const { mod, recv, jsReads } = createInputBufferModule()
+      handler.setModule(mod)
+
+      handler.getInputBuffer(3).set([1, 2, 3])
+      handler.commitInput(3)
+      handler.reset()
+      handler.setInput(new Uint8Array([7, 8]))
+
+      expect(recv(0, 10)).toBe(2)
+      expect(mod.HEAPU8.slice(0, 2)).toEqual(new Uint8Array([7, 8]))
+      expect(jsReads()).toBe(1)
+    })
+
+    it('should reject a length larger than the buffer', () => {
+      const { mod } = createInputBufferModule()
+      handler.setModule(mod)
+
+      handler.getInputBuffer(8)
+
+      expect(() => handler.commitInput(9)).toThrow()
+    })
+
+    it('should throw when the module lacks the exports', () => {
+      expect(() => handler.getInputBuffer(8)).toThrow()
+      expect(() => handler.commitInput(0)).toThrow()
+    })
+  })
+
   describe('mergePGliteImports', () => {
     it('should merge imports into env namespace', () => {
       const emscriptenImports = {
@@ -228,6 +390,8 @@ describe('PGlite WASM Imports POC', () => {
       // PGlite imports added
       expect(typeof (merged.env as any).pglite_js_read).toBe('function')
       expect(typeof (merged.env as any).pglite_js_write).toBe('function')
+      expect(typeof (merged.env as any).pglite_js_readv).toBe('function')
+      expect(typeof (merged.env as any).pglite_js_writev).toBe('function')
     })
   })
 
@@ -0,0 +1,144 @@
+/**
+ * bench-async.ts
+ *
+ * Streaming COPY FROM benchmark for async input (PGLITE_POLLING_ASYNC).
+ *
+ * Feeds the same data from an async source into _process_copy two ways:
+ *  - streaming:    copyFrom(source); the backend's recv() suspends on an
+ *                  empty input ring and the host refills it from the source,
+ *                  so at most one chunk plus one ring is ever held
+ *  - prebuffered:  the pre-async shape: collect the whole input first, then
+ *                  hand it over in one piece
+ *
+ * Each chunk is produced on a new turn of the event loop, like a network or
+ * file read. The backend is the TypeScript mock unless --wasm points at a
+ * module built with `./build.sh async`, so the absolute numbers measure
+ * transport overhead, not PostgreSQL.
+ *
+ * Usage: npx tsx bench-async.ts [--mb N] [--chunk BYTES] [--wasm ./test-polling-async.mjs] [--json]
+ */
+
+import { PGlitePolling, type PollingWasmModule } from './pglite-polling.js';
+import { createMockWasmModule } from './mock-wasm.js';
+
+interface CopyResult {
+  mode: string;
+  bytes: number;
+  ms: number;
+  mbPerS: number;
+  inputWaits: number;
+  peakBufferedMb: number;
+}
+
+let peakArrayBuffers = 0;
+
+function sampleMemory(): void {
+  peakArrayBuffers = Math.max(peakArrayBuffers, process.memoryUsage().arrayBuffers);
+}
+
+async function* source(total: number, chunkSize: number): AsyncGenerator<Uint8Array> {
+  for (let sent = 0; sent < total; sent += chunkSize) {
+    const chunk = new Uint8Array(Math.min(chunkSize, total - sent));
+    for (let i = 0; i < chunk.length; i += 4096) {
+      chunk[i] = (sent + i) & 0xff;
+    }
+    await new Promise((resolve) => setImmediate(resolve));
+    sampleMemory();
+    yield chunk;
+  }
+}
+
+async function collect(input: AsyncIterable<Uint8Array>, total: number): Promise<Uint8Array> {
+  const whole = new Uint8Array(total);
+  let offset = 0;
+  for await (const chunk of input) {
+    whole.set(chunk, offset);
+    offset += chunk.length;
+  }
+  sampleMemory();
+  return whole;
+}
+
+async function run(
+  polling: PGlitePolling,
+  mode: string,
+  total: number,
+  chunkSize: number
+): Promise<{ result: CopyResult; tag: string }> {
+  (globalThis as { gc?: () => void }).gc?.();
+  const baseline = process.memoryUsage().arrayBuffers;
+  peakArrayBuffers = baseline;
+
+  const start = performance.now();
+  const out =
+    mode === 'streaming'
+      ? await polling.copyFrom(source(total, chunkSize))
+      : await polling.copyFrom([await collect(source(total, chunkSize), total)]);
+  const ms = performance.now() - start;
+
+  const tag = new TextDecoder().decode(out!.subarray(5, out!.length - 7));
+  return {
+    tag,
+    result: {
+      mode,
+      bytes: total,
+      ms: +ms.toFixed(1),
+      mbPerS: +(total / (1024 * 1024) / (ms / 1000)).toFixed(1),
+      inputWaits: polling.getStatus().inputWaits,
+      peakBufferedMb: +((peakArrayBuffers - baseline) / (1024 * 1024)).toFixed(2),
+    },
+  };
+}
+
+async function main(): Promise<void> {
+  const args = process.argv.slice(2);
+  const arg = (name: string) => {
+    const i = args.indexOf(name);
+    return i >= 0 ? args[i + 1] : undefined;
+  };
+  const total = Number(arg('--mb') ?? 64) * 1024 * 1024;
+  const chunkSize = Number(arg('--chunk') ?? 64 * 1024);
+  const wasm = arg('--wasm');
+  const json = args.includes('--json');
+
+  let mod: PollingWasmModule;
+  if (wasm) {
+    const TestModule = (await import(new URL(wasm, `file://${process.cwd()}/`).href)).default;
+    mod = await TestModule();
+  } else {
+    mod = createMockWasmModule();
+  }
+  const polling = new PGlitePolling(mod);
+  polling.init();
+
+  // Warm up both paths
+  await run(polling, 'streaming', 1024 * 1024, chunkSize);
+  await run(polling, 'prebuffered', 1024 * 1024, chunkSize);
+
+  const streaming = await run(polling, 'streaming', total, chunkSize);
+  const prebuffered = await run(polling, 'prebuffered', total, chunkSize);
+  if (streaming.tag !== prebuffered.tag) {
+    throw new Error(`Results differ: ${streaming.tag} vs ${prebuffered.tag}`);
+  }
+
+  const results = [streaming.result, prebuffered.result];
+  if (json) {
+    console.log(JSON.stringify({ backend: wasm ?? 'mock', chunk: chunkSize, results }));
+    return;
+  }
+
+  console.log(
+    `=== COPY FROM ${total / (1024 * 1024)}MB in ${chunkSize} byte chunks (${wasm ?? 'mock'} backend) ===`
+  );
+  console.table(results);
+  console.log(`Both runs: ${streaming.tag}`);
+  console.log('');
+  console.log('peakBufferedMb is the growth in ArrayBuffer memory while the copy ran,');
+  console.log('including chunks not yet collected. Streaming only ever references one');
+  console.log('chunk; pre-buffering holds the whole input before the backend sees any.');
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,326 @@
+/**
+ * bench-ring.c
+ *
+ * Native benchmark for the polling transport in test-wasm.c. Runs the same
+ * ring code as the WASM build, single-threaded with the yield-to-host hook
+ * as the "host", so transport regressions show up without Emscripten.
+ *
+ * Benchmarks, each across message sizes from 16B to 1MB:
+ *   write      internal_write() throughput, host drains on yield
+ *   send       internal_send() (coalescing + flush-point checks)
+ *   flush      internal_write() + internal_flush() + host ack per message
+ *   read       internal_read() throughput with the input ring kept full
+ *   roundtrip  host write -> backend read -> backend write -> host ack,
+ *              with per-message latency percentiles
+ *   rows       process_multi_row() for several row counts
+ *
+ * The ring size is a compile-time constant, so ./build.sh bench builds one
+ * binary per size (bench-ring-16k ... bench-ring-1m).
+ *
+ * Build and run (no Emscripten required):
+ *   ./build.sh bench
+ *   ./bench-ring-64k [--json] [--quick]
+ *
+ * --json prints one JSON object per line (NDJSON) for regression tracking.
+ */
+
+#define TEST_WASM_NO_MAIN
+#include "test-wasm.c"
+
+#ifdef SHARED_MEMORY
+#error "bench-ring drives the ring single-threaded; build without SHARED_MEMORY"
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+
+static const size_t g_sizes[] = {
+    16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576,
+};
+#define NUM_SIZES (sizeof(g_sizes) / sizeof(g_sizes[0]))
+#define MAX_SIZE (1024 * 1024)
+
+static int g_json = 0;
+static int g_quick = 0;
+static uint8_t g_src[MAX_SIZE];
+static uint8_t g_dst[MAX_SIZE];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Bytes to push through each throughput benchmark */
+static uint64_t target_bytes(void) {
+    return g_quick ? 8u << 20 : 128u << 20;
+}
+
+static uint64_t ops_for(size_t size, uint64_t min_ops) {
+    uint64_t ops = target_bytes() / size;
+    return ops < min_ops ? min_ops : ops;
+}
+
+/* ============================================================================
+ * Reporting
+ * ============================================================================ */
+
+typedef struct {
+    const char *bench;
+    size_t msg_size;     // 0 for row benchmarks
+    uint64_t ops;        // messages, reads or rows
+    uint64_t bytes;
+    uint64_t elapsed_ns;
+    // Latency percentiles, roundtrip only
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    // Transport counters at the end of the run
+    uint32_t yields;
+    uint32_t notifications;
+} Result;
+
+static void report(const Result *r) {
+    double seconds = r->elapsed_ns / 1e9;
+    double mb_per_s = seconds > 0 ? r->bytes / seconds / (1024.0 * 1024.0) : 0;
+    double ns_per_op = r->ops ? (double)r->elapsed_ns / r->ops : 0;
+
+    if (g_json) {
+        printf("{\"bench\":\"%s\",\"buffer_size\":%u,\"msg_size\":%zu,"
+               "\"ops\":%llu,\"bytes\":%llu,\"seconds\":%.6f,"
+               "\"mb_per_s\":%.1f,\"ns_per_op\":%.1f,",
+               r->bench, (unsigned)BUFFER_SIZE, r->msg_size,
+               (unsigned long long)r->ops, (unsigned long long)r->bytes,
+               seconds, mb_per_s, ns_per_op);
+        if (r->p50_ns) {
+            printf("\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,",
+                   (unsigned long long)r->p50_ns,
+                   (unsigned long long)r->p99_ns,
+                   (unsigned long long)r->max_ns);
+        }
+        printf("\"yields\":%u,\"notifications\":%u}\n", r->yields,
+               r->notifications);
+        return;
+    }
+
+    printf("%-9s %8zu %10llu %10.1f MB/s %11.1f ns/op", r->bench,
+           r->msg_size, (unsigned long long)r->ops, mb_per_s, ns_per_op);
+    if (r->p50_ns) {
+        printf("  p50=%llu p99=%llu max=%llu ns",
+               (unsigned long long)r->p50_ns, (unsigned long long)r->p99_ns,
+               (unsigned long long)r->max_ns);
+    }
+    printf("  yields=%u notifications=%u\n", r->yields, r->notifications);
+}
+
+static void finish(Result *r, uint64_t start) {
+    r->elapsed_ns = now_ns() - start;
+    r->yields = g_control.write_yields;
+    r->notifications = g_control.notifications;
+    report(r);
+}
+
+/* ============================================================================
+ * Host side: the yield hook drains (discards) everything written so far
+ * ============================================================================ */
+
+static int discard_output(void) {
+    ack_output();
+    return 1;
+}
+
+static void begin(void) {
+    reset_buffers();
+    set_flush_high_water(FLUSH_HIGH_WATER);
+    set_yield_hook(discard_output);
+}
+
+/* ============================================================================
+ * Output direction
+ * ============================================================================ */
+
+static void bench_write(size_t size) {
+    Result r = { .bench = "write", .msg_size = size };
+    r.ops = ops_for(size, 16);
+    r.bytes = r.ops * size;
+
+    begin();
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < r.ops; i++) {
+        internal_write(g_src, size);
+    }
+    finish(&r, start);
+}
+
+static void bench_send(size_t size) {
+    Result r = { .bench = "send", .msg_size = size };
+    r.ops = ops_for(size, 16);
+    r.bytes = r.ops * size;
+
+    begin();
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < r.ops; i++) {
+        internal_send(g_src, size);
+    }
+    internal_flush();
+    finish(&r, start);
+}
+
+static void bench_flush(size_t size) {
+    Result r = { .bench = "flush", .msg_size = size };
+    r.ops = ops_for(size, 16);
+    r.bytes = r.ops * size;
+
+    begin();
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < r.ops; i++) {
+        internal_write(g_src, size);
+        internal_flush();
+        ack_output();  // the host consumes on every notification
+    }
+    finish(&r, start);
+}
+
+/* ============================================================================
+ * Input direction
+ * ============================================================================ */
+
+static void bench_read(size_t size) {
+    Result r = { .bench = "read", .msg_size = size };
+    uint64_t target = target_bytes();
+    uint64_t elapsed = 0;
+
+    begin();
+    while (r.bytes < target) {
+        // Refill outside the timed section; only internal_read is measured
+        while (ring_write(&g_input, g_src, BUFFER_SIZE) > 0) {
+        }
+
+        uint64_t start = now_ns();
+        ssize_t n;
+        while ((n = internal_read(g_dst, size)) > 0) {
+            r.bytes += (uint64_t)n;
+            r.ops++;
+        }
+        elapsed += now_ns() - start;
+    }
+
+    r.elapsed_ns = elapsed;
+    r.yields = g_control.write_yields;
+    r.notifications = g_control.notifications;
+    report(&r);
+}
+
+/* ============================================================================
+ * Round trip
+ * ============================================================================ */
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Host writes a message, the backend reads it and echoes it back */
+static void round_trip(size_t size) {
+    size_t sent = 0;
+    size_t got = 0;
+
+    // Messages larger than the ring are interleaved host/backend
+    while (got < size) {
+        sent += ring_write(&g_input, g_src + sent, size - sent);
+        ssize_t n = internal_read(g_dst + got, size - got);
+        got += n > 0 ? (size_t)n : 0;
+    }
+    internal_write(g_dst, size);
+    internal_flush();
+    ack_output();
+}
+
+static void bench_roundtrip(size_t size) {
+    Result r = { .bench = "roundtrip", .msg_size = size };
+    uint64_t ops = ops_for(size, 32) / 4;
+    r.ops = ops < 20000 ? ops : 20000;
+    r.bytes = r.ops * size;
+
+    uint64_t *samples = malloc(r.ops * sizeof(uint64_t));
+    if (!samples) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    begin();
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < r.ops; i++) {
+        uint64_t t0 = now_ns();
+        round_trip(size);
+        samples[i] = now_ns() - t0;
+    }
+    r.elapsed_ns = now_ns() - start;
+
+    qsort(samples, r.ops, sizeof(uint64_t), compare_u64);
+    r.p50_ns = samples[r.ops / 2];
+    r.p99_ns = samples[(r.ops * 99) / 100];
+    r.max_ns = samples[r.ops - 1];
+    free(samples);
+
+    r.yields = g_control.write_yields;
+    r.notifications = g_control.notifications;
+    report(&r);
+}
+
+/* ============================================================================
+ * Result sets
+ * ============================================================================ */
+
+static void bench_rows(int rows) {
+    Result r = { .bench = "rows" };
+    r.ops = (uint64_t)rows;
+
+    begin();
+    uint64_t start = now_ns();
+    if (process_multi_row(rows) != 0) {
+        fprintf(stderr, "process_multi_row(%d) failed\n", rows);
+        exit(1);
+    }
+    r.bytes = g_control.total_written;
+    finish(&r, start);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            g_json = 1;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            g_quick = 1;
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (size_t i = 0; i < MAX_SIZE; i++) {
+        g_src[i] = (uint8_t)('a' + i % 26);
+    }
+
+    if (!g_json) {
+        printf("Polling transport, %u byte rings%s\n", (unsigned)BUFFER_SIZE,
+               g_quick ? " (quick)" : "");
+        printf("%-9s %8s %10s\n", "bench", "size", "ops");
+    }
+
+    for (size_t i = 0; i < NUM_SIZES; i++) bench_write(g_sizes[i]);
+    for (size_t i = 0; i < NUM_SIZES; i++) bench_send(g_sizes[i]);
+    for (size_t i = 0; i < NUM_SIZES; i++) bench_flush(g_sizes[i]);
+    for (size_t i = 0; i < NUM_SIZES; i++) bench_read(g_sizes[i]);
+    for (size_t i = 0; i < NUM_SIZES; i++) bench_roundtrip(g_sizes[i]);
+
+    static const int row_counts[] = { 1, 100, 10000, 1000000 };
+    for (size_t i = 0; i < sizeof(row_counts) / sizeof(row_counts[0]); i++) {
+        if (g_quick && row_counts[i] > 10000) {
+            break;
+        }
+        bench_rows(row_counts[i]);
+    }
+    return 0;
+}
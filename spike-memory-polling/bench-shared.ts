@@ -0,0 +1,178 @@
+/**
+ * bench-shared.ts
+ *
+ * Demo + latency benchmark for the SharedArrayBuffer transport.
+ *
+ * Compares one query round trip through:
+ *  - shared:     main thread -> shared ring -> backend worker -> shared ring
+ *                (Atomics.notify / Atomics.waitAsync, no postMessage)
+ *  - trampoline: the current EM_JS trampoline shape, on one thread: the host
+ *                calls into the backend, which calls Module._pgliteCallbacks
+ *                read once and write once per send(), each write copying out
+ *                of the heap as pglite.ts does
+ *
+ * Both backends are the TypeScript mock unless --wasm points at a module
+ * built with `./build.sh shared`, so the absolute numbers measure transport
+ * overhead, not PostgreSQL.
+ *
+ * Usage: npx tsx bench-shared.ts [--iterations N] [--wasm ./test-polling-shared.mjs] [--json]
+ */
+
+import { spawnSharedBackend } from './shared-backend-worker.js';
+
+interface LatencyStats {
+  mode: string;
+  iterations: number;
+  meanUs: number;
+  p50Us: number;
+  p99Us: number;
+}
+
+function summarize(mode: string, samples: number[]): LatencyStats {
+  const sorted = [...samples].sort((a, b) => a - b);
+  const pick = (q: number) => sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+  const mean = samples.reduce((a, b) => a + b, 0) / samples.length;
+  return {
+    mode,
+    iterations: samples.length,
+    meanUs: +(mean * 1000).toFixed(2),
+    p50Us: +(pick(0.5) * 1000).toFixed(2),
+    p99Us: +(pick(0.99) * 1000).toFixed(2),
+  };
+}
+
+/**
+ * Same-thread model of the EM_JS trampoline path (pglite-comm-trampoline.h)
+ */
+function createTrampolineBackend() {
+  const heap = new Uint8Array(256 * 1024);
+  const INPUT_PTR = 0;
+  const OUTPUT_PTR = 128 * 1024;
+  let input = new Uint8Array(0);
+  let output: Uint8Array[] = [];
+
+  const callbacks = {
+    read: (ptr: number, maxLength: number) => {
+      const n = Math.min(maxLength, input.length);
+      heap.set(input.subarray(0, n), ptr);
+      input = input.subarray(n);
+      return n;
+    },
+    write: (ptr: number, length: number) => {
+      output.push(heap.slice(ptr, ptr + length));
+      return length;
+    },
+  };
+
+  // Backend: recv() via the read trampoline, one write trampoline per send()
+  function interactiveOne(): void {
+    const n = callbacks.read(INPUT_PTR, 1023);
+    for (let i = 0; i < n; i++) {
+      const b = heap[INPUT_PTR + i];
+      heap[OUTPUT_PTR + 5 + i] = b >= 97 && b <= 122 ? b - 32 : b;
+    }
+    const len = n + 4;
+    heap[OUTPUT_PTR] = 82; // 'R'
+    heap[OUTPUT_PTR + 1] = (len >> 24) & 0xff;
+    heap[OUTPUT_PTR + 2] = (len >> 16) & 0xff;
+    heap[OUTPUT_PTR + 3] = (len >> 8) & 0xff;
+    heap[OUTPUT_PTR + 4] = len & 0xff;
+    callbacks.write(OUTPUT_PTR, 5);
+    callbacks.write(OUTPUT_PTR + 5, n);
+    heap.set([90, 0, 0, 0, 5, 73], OUTPUT_PTR + 5 + n);
+    callbacks.write(OUTPUT_PTR + 5 + n, 6);
+  }
+
+  return {
+    exec(message: Uint8Array): Uint8Array {
+      input = message;
+      output = [];
+      interactiveOne();
+      let total = 0;
+      for (const c of output) total += c.length;
+      const out = new Uint8Array(total);
+      let offset = 0;
+      for (const c of output) {
+        out.set(c, offset);
+        offset += c.length;
+      }
+      return out;
+    },
+  };
+}
+
+async function main(): Promise<void> {
+  const args = process.argv.slice(2);
+  const arg = (name: string) => {
+    const i = args.indexOf(name);
+    return i >= 0 ? args[i + 1] : undefined;
+  };
+  const iterations = Number(arg('--iterations') ?? 20000);
+  const warmup = Math.min(2000, iterations);
+  const wasm = arg('--wasm');
+  const json = args.includes('--json');
+
+  const encoder = new TextEncoder();
+  const decoder = new TextDecoder();
+  const query = encoder.encode('select id, name from users where id = $1;'.padEnd(64));
+
+  const { polling, worker } = await spawnSharedBackend(wasm);
+  const trampoline = createTrampolineBackend();
+
+  if (!json) {
+    console.log('=== SharedArrayBuffer transport demo ===');
+    for (const text of ['select 1', 'select now()']) {
+      const out = await polling.exec(encoder.encode(text));
+      console.log(`  ${text} -> ${decoder.decode(out.subarray(5, out.length - 6))}`);
+    }
+    console.log('');
+  }
+
+  // Warm up both paths
+  for (let i = 0; i < warmup; i++) {
+    await polling.exec(query);
+    trampoline.exec(query);
+  }
+
+  const sharedSamples: number[] = [];
+  for (let i = 0; i < iterations; i++) {
+    const start = performance.now();
+    await polling.exec(query);
+    sharedSamples.push(performance.now() - start);
+  }
+
+  const trampolineSamples: number[] = [];
+  for (let i = 0; i < iterations; i++) {
+    const start = performance.now();
+    trampoline.exec(query);
+    trampolineSamples.push(performance.now() - start);
+  }
+
+  const status = polling.getStatus();
+  await worker.terminate();
+
+  const results = [
+    summarize('shared', sharedSamples),
+    summarize('trampoline', trampolineSamples),
+  ];
+
+  if (json) {
+    console.log(JSON.stringify({ backend: wasm ?? 'mock', results }));
+    return;
+  }
+
+  console.log(`=== Round-trip latency (${iterations} iterations, ${wasm ?? 'mock'} backend) ===`);
+  console.table(results);
+  console.log(
+    `shared: ${status.notifications} notifications for ${status.sendCalls} send() calls`
+  );
+  console.log('');
+  console.log('The shared path pays for a cross-thread wakeup, but the main thread');
+  console.log('is never blocked while the backend works; the trampoline path runs');
+  console.log('the whole query on the calling thread.');
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
@@ -11,6 +11,35 @@ set -e
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 cd "$SCRIPT_DIR"
 
+# Native targets exercise the same C code without Emscripten
+if [ "$1" == "native" ]; then
+    CC="${CC:-cc}"
+    echo "Building native ring stress test with ${CC}..."
+    ${CC} -O2 -Wall -Wextra -pthread -o stress-ring stress-ring.c
+    ${CC} -O2 -Wall -Wextra -pthread -DSHARED_MEMORY -o stress-ring-shared stress-ring.c
+    echo ""
+    echo "To test, run:"
+    echo "  ./stress-ring [rows] [input-bytes]"
+    echo "  ./stress-ring-shared [rows] [input-bytes]"
+    exit 0
+fi
+
+# Native transport benchmark, one binary per ring size
+if [ "$1" == "bench" ]; then
+    CC="${CC:-cc}"
+    echo "Building native ring benchmarks with ${CC}..."
+    for size in 16k:16 64k:64 256k:256 1m:1024; do
+        ${CC} -O2 -Wall -Wextra -DBUFFER_SIZE="(${size#*:} * 1024)" \
+            -o "bench-ring-${size%%:*}" bench-ring.c
+    done
+    echo ""
+    echo "To run, e.g.:"
+    echo "  ./bench-ring-64k [--json] [--quick]"
+    exit 0
+fi
+
+EXPORTS="'_main','_get_input_buffer','_get_output_buffer','_get_control','_get_layout','_get_buffer_size','_reset_buffers','_signal_input_ready','_has_output','_get_output_length','_consume_output','_ack_output','_set_flush_high_water','_process_message','_process_query','_serve','_process_multi_row'"
+
 echo "Building memory polling test WASM module..."
 
 # Check if emcc is available
@@ -33,7 +62,7 @@ emcc --version | head -1
 emcc -O2 \
     -o test-polling.mjs \
     test-wasm.c \
-    -sEXPORTED_FUNCTIONS="['_main','_get_input_buffer','_get_output_buffer','_get_control','_get_buffer_size','_reset_buffers','_signal_input_ready','_has_output','_get_output_length','_ack_output','_process_message','_process_multi_row']" \
+    -sEXPORTED_FUNCTIONS="[${EXPORTS}]" \
     -sEXPORTED_RUNTIME_METHODS="['HEAPU8','HEAPU32','HEAP32']" \
     -sNO_EXIT_RUNTIME=1 \
     -sMODULARIZE=1 \
@@ -42,10 +71,50 @@ emcc -O2 \
     -sENVIRONMENT=node \
     -sALLOW_MEMORY_GROWTH=1
 
+# Worker build for the SharedArrayBuffer transport (bench-shared.ts --wasm)
+if [ "$1" == "shared" ]; then
+    emcc -O2 \
+        -o test-polling-shared.mjs \
+        test-wasm.c \
+        -DSHARED_MEMORY \
+        -sSHARED_MEMORY=1 \
+        -sEXPORTED_FUNCTIONS="[${EXPORTS}]" \
+        -sEXPORTED_RUNTIME_METHODS="['HEAPU8','HEAPU32','HEAP32']" \
+        -sNO_EXIT_RUNTIME=1 \
+        -sMODULARIZE=1 \
+        -sEXPORT_ES6=1 \
+        -sEXPORT_NAME=TestModule \
+        -sENVIRONMENT=node,worker \
+        -sINITIAL_MEMORY=16MB
+fi
+
+# Async input build (bench-async.ts --wasm): recv()
+# suspends on an empty input ring. JSPI by default, Asyncify with ASYNCIFY=1
+if [ "$1" == "async" ]; then
+    if [ "${ASYNCIFY:-0}" == "1" ]; then
+        SUSPEND_FLAGS="-sASYNCIFY=1"
+    else
+        SUSPEND_FLAGS="-sJSPI=1 -sJSPI_EXPORTS=['process_copy']"
+    fi
+    emcc -O2 \
+        -o test-polling-async.mjs \
+        test-wasm.c \
+        -DASYNC_INPUT \
+        ${SUSPEND_FLAGS} \
+        -sEXPORTED_FUNCTIONS="[${EXPORTS},'_process_copy']" \
+        -sEXPORTED_RUNTIME_METHODS="['HEAPU8','HEAPU32','HEAP32','ccall']" \
+        -sNO_EXIT_RUNTIME=1 \
+        -sMODULARIZE=1 \
+        -sEXPORT_ES6=1 \
+        -sEXPORT_NAME=TestModule \
+        -sENVIRONMENT=node \
+        -sALLOW_MEMORY_GROWTH=1
+fi
+
 echo ""
 echo "Build complete!"
 echo "Output files:"
-ls -la test-polling.mjs test-polling.wasm 2>/dev/null || true
+ls -la test-polling*.mjs test-polling*.wasm 2>/dev/null || true
 
 echo ""
 echo "To test, run:"
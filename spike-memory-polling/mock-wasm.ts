@@ -7,17 +7,36 @@
  * This simulates the exact behavior of test-wasm.c in TypeScript.
  */
 
-import type { PollingWasmModule } from './pglite-polling.js';
+import {
+  LAYOUT_FIELDS,
+  LAYOUT_MAGIC,
+  LAYOUT_VERSION,
+  type PollingWasmModule,
+} from './pglite-polling.js';
+
+// Field offsets, mirroring Ring and Control in test-wasm.c
+const Ring = { HEAD: 0, TAIL: 64, CAPACITY: 128, MASK: 132, DATA: 192 } as const;
+const Control = {
+  // Line 0: state the host watches
+  OPERATION: 0,
+  ERROR_CODE: 4,
+  NOTIFICATIONS: 8,
+  // Line 1: counters
+  READ_OFFSET: 64,
+  TOTAL_READ: 68,
+  TOTAL_WRITTEN: 72,
+  WRITE_YIELDS: 76,
+  SEND_CALLS: 80,
+  INPUT_WAITS: 84,
+  SIZE: 128,
+} as const;
 
-// Buffer size matching C code
+// Ring capacity matching C code
 const BUFFER_SIZE = 64 * 1024;
+const RING_SIZE = Ring.DATA + BUFFER_SIZE;
 
-// Buffer status enum
-const BufferStatus = {
-  EMPTY: 0,
-  READY: 1,
-  PROCESSING: 2,
-} as const;
+// Default coalescing high-water mark (FLUSH_HIGH_WATER in test-wasm.c)
+const FLUSH_HIGH_WATER = BUFFER_SIZE / 2;
 
 // Operation types enum
 const OperationType = {
@@ -28,85 +47,212 @@ const OperationType = {
   ERROR: 4,
 } as const;
 
+export interface MockWasmOptions {
+  /**
+   * Mirror the SHARED_MEMORY build: memory is a SharedArrayBuffer, reads
+   * block with Atomics.wait until input arrives and a full output ring
+   * sleeps on its tail instead of calling back into JS. Only usable off the
+   * main thread (see shared-backend-worker.ts).
+   */
+  shared?: boolean;
+}
+
 /**
  * Creates a mock WASM module that simulates the memory polling behavior.
  * The "memory" is implemented using ArrayBuffer/TypedArrays.
  */
-export function createMockWasmModule(): PollingWasmModule {
+export function createMockWasmModule(
+  options: MockWasmOptions = {}
+): PollingWasmModule {
+  const shared = options.shared ?? false;
+
   // Simulate WASM linear memory (1MB total)
-  const memory = new ArrayBuffer(1024 * 1024);
+  const memory = shared
+    ? new SharedArrayBuffer(1024 * 1024)
+    : new ArrayBuffer(1024 * 1024);
 
-  // Memory layout:
-  // 0x0000 - 0xFFFF: Input buffer (64KB + 8 byte header)
-  // 0x10000 - 0x1FFFF: Output buffer (64KB + 8 byte header)
-  // 0x20000 - 0x20014: Control block (20 bytes)
+  // Memory layout (cache-line aligned like the C statics):
+  // 0x00000 - 0x100BF: Input ring (192 byte header + 64KB data)
+  // 0x10100 - 0x201BF: Output ring
+  // 0x20200 - 0x2027F: Control block (two cache lines)
+  // 0x20280 - 0x202C7: Layout descriptor
 
   const INPUT_BUFFER_OFFSET = 0;
-  const OUTPUT_BUFFER_OFFSET = 0x10008;
-  const CONTROL_OFFSET = 0x20000;
+  const OUTPUT_BUFFER_OFFSET = (RING_SIZE + 63) & ~63;
+  const CONTROL_OFFSET = (OUTPUT_BUFFER_OFFSET + RING_SIZE + 63) & ~63;
+  const LAYOUT_OFFSET = CONTROL_OFFSET + Control.SIZE;
 
   // Create typed array views
   const HEAPU8 = new Uint8Array(memory);
   const HEAPU32 = new Uint32Array(memory);
   const HEAP32 = new Int32Array(memory);
 
-  // Helper to get buffer data pointer (after 8-byte header)
-  const inputDataOffset = INPUT_BUFFER_OFFSET + 8;
-  const outputDataOffset = OUTPUT_BUFFER_OFFSET + 8;
+  // u32 index of a control block field
+  const ctl = (field: number) => (CONTROL_OFFSET + field) >> 2;
+
+  // Layout descriptor, in PGliteLayout field order
+  HEAPU32.set(
+    [
+      LAYOUT_MAGIC,
+      LAYOUT_VERSION,
+      LAYOUT_FIELDS * 4,
+      Ring.HEAD,
+      Ring.TAIL,
+      Ring.CAPACITY,
+      Ring.MASK,
+      Ring.DATA,
+      Control.SIZE,
+      Control.OPERATION,
+      Control.ERROR_CODE,
+      Control.NOTIFICATIONS,
+      Control.READ_OFFSET,
+      Control.TOTAL_READ,
+      Control.TOTAL_WRITTEN,
+      Control.WRITE_YIELDS,
+      Control.SEND_CALLS,
+      Control.INPUT_WAITS,
+    ],
+    LAYOUT_OFFSET >> 2
+  );
+
+  // Coalescing state: total_written at the last notification
+  let notifiedWritten = 0;
+  let flushHighWater = FLUSH_HIGH_WATER;
+
+  // Ring helpers (mirror ring_read/ring_write in test-wasm.c). Cursors go
+  // through Atomics so the same code is correct on a SharedArrayBuffer.
+  const headIndex = (ring: number) => (ring + Ring.HEAD) / 4;
+  const tailIndex = (ring: number) => (ring + Ring.TAIL) / 4;
+  const head = (ring: number) => Atomics.load(HEAPU32, headIndex(ring));
+  const tail = (ring: number) => Atomics.load(HEAPU32, tailIndex(ring));
+  const used = (ring: number) => (head(ring) - tail(ring)) >>> 0;
+
+  function ringReset(ring: number): void {
+    HEAPU32[(ring + Ring.HEAD) / 4] = 0;
+    HEAPU32[(ring + Ring.TAIL) / 4] = 0;
+    HEAPU32[(ring + Ring.CAPACITY) / 4] = BUFFER_SIZE;
+    HEAPU32[(ring + Ring.MASK) / 4] = BUFFER_SIZE - 1;
+  }
+
+  function ringWrite(ring: number, data: Uint8Array): number {
+    const h = head(ring);
+    const n = Math.min(data.length, BUFFER_SIZE - used(ring));
+    const pos = h & (BUFFER_SIZE - 1);
+    const first = Math.min(n, BUFFER_SIZE - pos);
+    const base = ring + Ring.DATA;
+    HEAPU8.set(data.subarray(0, first), base + pos);
+    HEAPU8.set(data.subarray(first, n), base);
+    Atomics.store(HEAPU32, headIndex(ring), h + n);
+    return n;
+  }
 
-  // Control block field offsets (in bytes)
-  const controlU32Base = CONTROL_OFFSET / 4;
+  function ringRead(ring: number, maxLen: number): Uint8Array {
+    const t = tail(ring);
+    const n = Math.min(maxLen, used(ring));
+    const pos = t & (BUFFER_SIZE - 1);
+    const first = Math.min(n, BUFFER_SIZE - pos);
+    const base = ring + Ring.DATA;
+    const data = new Uint8Array(n);
+    data.set(HEAPU8.subarray(base + pos, base + pos + first));
+    data.set(HEAPU8.subarray(base, base + n - first), first);
+    Atomics.store(HEAPU32, tailIndex(ring), t + n);
+    return data;
+  }
 
   /**
-   * Internal: Read from input buffer
+   * Internal: Read from input ring
    */
   function internalRead(maxLen: number): { data: Uint8Array; bytesRead: number } {
-    const inputStatus = HEAPU32[INPUT_BUFFER_OFFSET / 4];
-    const inputLength = HEAPU32[INPUT_BUFFER_OFFSET / 4 + 1];
-    const readOffset = HEAPU32[controlU32Base + 2]; // read_offset
-
-    if (inputStatus !== BufferStatus.READY) {
-      return { data: new Uint8Array(0), bytesRead: 0 };
+    let data = ringRead(INPUT_BUFFER_OFFSET, maxLen);
+
+    if (shared) {
+      // Backend worker: sleep until the host publishes input
+      while (data.length === 0) {
+        const h = head(INPUT_BUFFER_OFFSET);
+        if (h === tail(INPUT_BUFFER_OFFSET)) {
+          HEAPU32[ctl(Control.OPERATION)] = OperationType.READ_REQUEST;
+          Atomics.wait(HEAP32, headIndex(INPUT_BUFFER_OFFSET), h | 0);
+        }
+        data = ringRead(INPUT_BUFFER_OFFSET, maxLen);
+      }
+      Atomics.notify(HEAP32, tailIndex(INPUT_BUFFER_OFFSET));
     }
 
-    const available = inputLength - readOffset;
-    if (available === 0) {
-      HEAPU32[INPUT_BUFFER_OFFSET / 4] = BufferStatus.EMPTY;
-      return { data: new Uint8Array(0), bytesRead: 0 };
+    if (data.length > 0) {
+      HEAPU32[ctl(Control.READ_OFFSET)] += data.length;
+      HEAPU32[ctl(Control.TOTAL_READ)] += data.length;
     }
 
-    const toRead = Math.min(maxLen, available);
-    const data = HEAPU8.slice(inputDataOffset + readOffset, inputDataOffset + readOffset + toRead);
+    return { data, bytesRead: data.length };
+  }
 
-    // Update read offset
-    HEAPU32[controlU32Base + 2] = readOffset + toRead;
-    // Update total_read
-    HEAPU32[controlU32Base + 3] += toRead;
+  /**
+   * Internal: Read from input ring, suspending on an empty ring until the
+   * host refills it (internal_read in an ASYNC_INPUT build)
+   */
+  async function internalReadAsync(maxLen: number): Promise<Uint8Array> {
+    let { data } = internalRead(maxLen);
+    while (data.length === 0) {
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.READ_REQUEST;
+      HEAPU32[ctl(Control.INPUT_WAITS)] += 1;
+      if (!(await mod._pglitePollingOnInputNeeded?.())) {
+        break;
+      }
+      ({ data } = internalRead(maxLen));
+    }
+    return data;
+  }
 
-    // Mark empty if all consumed
-    if (readOffset + toRead >= inputLength) {
-      HEAPU32[INPUT_BUFFER_OFFSET / 4] = BufferStatus.EMPTY;
+  /**
+   * Internal: Tell the host everything written so far is ready
+   */
+  function notifyHost(): void {
+    HEAPU32[ctl(Control.OPERATION)] = OperationType.WRITE_READY;
+    notifiedWritten = HEAPU32[ctl(Control.TOTAL_WRITTEN)];
+    Atomics.add(HEAPU32, ctl(Control.NOTIFICATIONS), 1);
+    if (shared) {
+      Atomics.notify(HEAP32, ctl(Control.NOTIFICATIONS));
+    }
+  }
+
+  /**
+   * Internal: Yield to the host so it can drain a full output ring
+   */
+  function waitOutputSpace(): boolean {
+    notifyHost();
+    HEAPU32[ctl(Control.WRITE_YIELDS)] += 1;
+
+    if (shared) {
+      // The host drains on its own thread and wakes us by bumping tail
+      for (;;) {
+        const t = tail(OUTPUT_BUFFER_OFFSET);
+        if (((head(OUTPUT_BUFFER_OFFSET) - t) >>> 0) < BUFFER_SIZE) {
+          return true;
+        }
+        Atomics.wait(HEAP32, tailIndex(OUTPUT_BUFFER_OFFSET), t | 0);
+      }
     }
 
-    return { data, bytesRead: toRead };
+    mod._pglitePollingOnWriteReady?.();
+    return used(OUTPUT_BUFFER_OFFSET) < BUFFER_SIZE;
   }
 
   /**
-   * Internal: Write to output buffer
+   * Internal: Write to output ring, yielding whenever it fills up
    */
   function internalWrite(data: Uint8Array): number {
-    const currentLength = HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1];
+    let offset = 0;
 
-    if (currentLength + data.length > BUFFER_SIZE) {
-      // Buffer full
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4] = BufferStatus.READY;
-      HEAPU32[controlU32Base] = OperationType.WRITE_READY;
-      return -1;
-    }
+    while (offset < data.length) {
+      const written = ringWrite(OUTPUT_BUFFER_OFFSET, data.subarray(offset));
+      HEAPU32[ctl(Control.TOTAL_WRITTEN)] += written;
+      offset += written;
 
-    HEAPU8.set(data, outputDataOffset + currentLength);
-    HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1] = currentLength + data.length;
-    HEAPU32[controlU32Base + 4] += data.length; // total_written
+      if (offset < data.length && !waitOutputSpace()) {
+        // Nobody drained the ring
+        return -1;
+      }
+    }
 
     return data.length;
   }
@@ -115,11 +261,72 @@ export function createMockWasmModule(): PollingWasmModule {
    * Internal: Flush output
    */
   function internalFlush(): void {
-    const currentLength = HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1];
-    if (currentLength > 0) {
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4] = BufferStatus.READY;
-      HEAPU32[controlU32Base] = OperationType.WRITE_READY;
+    if (HEAPU32[ctl(Control.TOTAL_WRITTEN)] !== notifiedWritten && used(OUTPUT_BUFFER_OFFSET) > 0) {
+      notifyHost();
+    }
+  }
+
+  /**
+   * Internal: Coalesced send - notify only at a ReadyForQuery flush point
+   * or once the high-water mark has been passed
+   */
+  function internalSend(data: Uint8Array): number {
+    HEAPU32[ctl(Control.SEND_CALLS)] += 1;
+    const result = internalWrite(data);
+
+    const n = data.length;
+    const readyForQuery =
+      n >= 6 &&
+      data[n - 6] === 90 && // 'Z'
+      data[n - 5] === 0 &&
+      data[n - 4] === 0 &&
+      data[n - 3] === 0 &&
+      data[n - 2] === 5;
+    const unflushed = (HEAPU32[ctl(Control.TOTAL_WRITTEN)] - notifiedWritten) >>> 0;
+    if (readyForQuery || unflushed >= flushHighWater) {
+      internalFlush();
+    }
+    return result;
+  }
+
+  /**
+   * Internal: Read one message and send it back uppercased as an 'R'
+   * message (shared by process_message and process_query)
+   */
+  function echoMessage(): number {
+    // Read all input
+    const { data, bytesRead } = internalRead(1024);
+
+    if (bytesRead <= 0) {
+      HEAP32[ctl(Control.ERROR_CODE)] = -1;
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.ERROR;
+      return -1;
+    }
+
+    // Transform: convert to uppercase (simulating query processing)
+    const transformed = new Uint8Array(bytesRead);
+    for (let i = 0; i < bytesRead; i++) {
+      const byte = data[i];
+      if (byte >= 97 && byte <= 122) {
+        // a-z -> A-Z
+        transformed[i] = byte - 32;
+      } else {
+        transformed[i] = byte;
+      }
     }
+
+    // Write response header (PostgreSQL-style message)
+    const header = new Uint8Array(5);
+    header[0] = 82; // 'R'
+    const len = bytesRead + 4;
+    header[1] = (len >> 24) & 0xff;
+    header[2] = (len >> 16) & 0xff;
+    header[3] = (len >> 8) & 0xff;
+    header[4] = len & 0xff;
+
+    internalSend(header);
+    internalSend(transformed);
+    return 0;
   }
 
   // Build the mock module object
@@ -131,78 +338,89 @@ export function createMockWasmModule(): PollingWasmModule {
     _get_input_buffer: () => INPUT_BUFFER_OFFSET,
     _get_output_buffer: () => OUTPUT_BUFFER_OFFSET,
     _get_control: () => CONTROL_OFFSET,
+    _get_layout: () => LAYOUT_OFFSET,
     _get_buffer_size: () => BUFFER_SIZE,
 
     _reset_buffers: () => {
-      // Input buffer
-      HEAPU32[INPUT_BUFFER_OFFSET / 4] = BufferStatus.EMPTY;
-      HEAPU32[INPUT_BUFFER_OFFSET / 4 + 1] = 0;
-      // Output buffer
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4] = BufferStatus.EMPTY;
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1] = 0;
+      ringReset(INPUT_BUFFER_OFFSET);
+      ringReset(OUTPUT_BUFFER_OFFSET);
       // Control block
-      HEAPU32[controlU32Base] = OperationType.NONE;
-      HEAP32[controlU32Base + 1] = 0; // error_code
-      HEAPU32[controlU32Base + 2] = 0; // read_offset
-      HEAPU32[controlU32Base + 3] = 0; // total_read
-      HEAPU32[controlU32Base + 4] = 0; // total_written
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.NONE;
+      HEAP32[ctl(Control.ERROR_CODE)] = 0;
+      HEAPU32[ctl(Control.READ_OFFSET)] = 0;
+      HEAPU32[ctl(Control.TOTAL_READ)] = 0;
+      HEAPU32[ctl(Control.TOTAL_WRITTEN)] = 0;
+      HEAPU32[ctl(Control.WRITE_YIELDS)] = 0;
+      HEAPU32[ctl(Control.NOTIFICATIONS)] = 0;
+      HEAPU32[ctl(Control.SEND_CALLS)] = 0;
+      HEAPU32[ctl(Control.INPUT_WAITS)] = 0;
+      notifiedWritten = 0;
+    },
+
+    _set_flush_high_water: (bytes: number) => {
+      flushHighWater = bytes;
     },
 
     _signal_input_ready: (length: number) => {
-      HEAPU32[INPUT_BUFFER_OFFSET / 4 + 1] = length;
-      HEAPU32[INPUT_BUFFER_OFFSET / 4] = BufferStatus.READY;
-      HEAPU32[controlU32Base + 2] = 0; // reset read_offset
+      HEAPU32[ctl(Control.READ_OFFSET)] = 0;
+      Atomics.store(
+        HEAPU32,
+        headIndex(INPUT_BUFFER_OFFSET),
+        head(INPUT_BUFFER_OFFSET) + length
+      );
     },
 
     _has_output: () => {
-      return HEAPU32[OUTPUT_BUFFER_OFFSET / 4] === BufferStatus.READY ? 1 : 0;
+      return used(OUTPUT_BUFFER_OFFSET) > 0 ? 1 : 0;
     },
 
     _get_output_length: () => {
-      return HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1];
+      return used(OUTPUT_BUFFER_OFFSET);
+    },
+
+    _consume_output: (length: number) => {
+      Atomics.store(
+        HEAPU32,
+        tailIndex(OUTPUT_BUFFER_OFFSET),
+        tail(OUTPUT_BUFFER_OFFSET) + length
+      );
     },
 
     _ack_output: () => {
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4] = BufferStatus.EMPTY;
-      HEAPU32[OUTPUT_BUFFER_OFFSET / 4 + 1] = 0;
+      Atomics.store(
+        HEAPU32,
+        tailIndex(OUTPUT_BUFFER_OFFSET),
+        head(OUTPUT_BUFFER_OFFSET)
+      );
     },
 
     _process_message: () => {
-      // Read all input
-      const { data, bytesRead } = internalRead(1024);
-
-      if (bytesRead <= 0) {
-        HEAP32[controlU32Base + 1] = -1; // error_code
-        HEAPU32[controlU32Base] = OperationType.ERROR;
+      if (echoMessage() < 0) {
         return -1;
       }
+      internalFlush();
 
-      // Transform: convert to uppercase (simulating query processing)
-      const transformed = new Uint8Array(bytesRead);
-      for (let i = 0; i < bytesRead; i++) {
-        const byte = data[i];
-        if (byte >= 97 && byte <= 122) {
-          // a-z -> A-Z
-          transformed[i] = byte - 32;
-        } else {
-          transformed[i] = byte;
-        }
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.COMPLETED;
+      return 0;
+    },
+
+    _process_query: () => {
+      if (echoMessage() < 0) {
+        return -1;
       }
 
-      // Write response header (PostgreSQL-style message)
-      const header = new Uint8Array(5);
-      header[0] = 82; // 'R'
-      const len = bytesRead + 4;
-      header[1] = (len >> 24) & 0xff;
-      header[2] = (len >> 16) & 0xff;
-      header[3] = (len >> 8) & 0xff;
-      header[4] = len & 0xff;
-
-      internalWrite(header);
-      internalWrite(transformed);
-      internalFlush();
+      // ReadyForQuery ('Z', idle) is a flush point for the coalesced send
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.COMPLETED;
+      internalSend(new Uint8Array([90, 0, 0, 0, 5, 73]));
+      return 0;
+    },
 
-      HEAPU32[controlU32Base] = OperationType.COMPLETED;
+    _serve: (maxQueries: number) => {
+      for (let i = 0; maxQueries === 0 || i < maxQueries; i++) {
+        if (mod._process_query!() < 0) {
+          return -1;
+        }
+      }
       return 0;
     },
 
@@ -222,21 +440,59 @@ export function createMockWasmModule(): PollingWasmModule {
         header[3] = (len >> 8) & 0xff;
         header[4] = len & 0xff;
 
-        if (internalWrite(header) < 0) {
-          HEAP32[controlU32Base + 1] = -2;
-          HEAPU32[controlU32Base] = OperationType.ERROR;
+        if (internalSend(header) < 0) {
+          HEAP32[ctl(Control.ERROR_CODE)] = -2;
+          HEAPU32[ctl(Control.OPERATION)] = OperationType.ERROR;
           return -1;
         }
 
-        if (internalWrite(rowData) < 0) {
-          HEAP32[controlU32Base + 1] = -3;
-          HEAPU32[controlU32Base] = OperationType.ERROR;
+        if (internalSend(rowData) < 0) {
+          HEAP32[ctl(Control.ERROR_CODE)] = -3;
+          HEAPU32[ctl(Control.OPERATION)] = OperationType.ERROR;
           return -1;
         }
       }
 
       internalFlush();
-      HEAPU32[controlU32Base] = OperationType.COMPLETED;
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.COMPLETED;
+      return 0;
+    },
+
+    // Returns a Promise, like a JSPI-wrapped export of an ASYNC_INPUT build
+    _process_copy: async () => {
+      let bytes = 0;
+      let hash = 2166136261;
+
+      for (;;) {
+        const chunk = await internalReadAsync(8192);
+        if (chunk.length === 0) {
+          break;
+        }
+        for (let i = 0; i < chunk.length; i++) {
+          hash = Math.imul(hash ^ chunk[i], 16777619) >>> 0;
+        }
+        bytes += chunk.length;
+      }
+
+      const text = new TextEncoder().encode(
+        `COPY ${bytes} ${hash.toString(16).padStart(8, '0')}`
+      );
+      const msg = new Uint8Array(5 + text.length + 1);
+      const len = text.length + 1 + 4; // text, NUL, length itself
+      msg[0] = 67; // 'C' for CommandComplete
+      msg[1] = (len >> 24) & 0xff;
+      msg[2] = (len >> 16) & 0xff;
+      msg[3] = (len >> 8) & 0xff;
+      msg[4] = len & 0xff;
+      msg.set(text, 5);
+
+      if (internalSend(msg) < 0) {
+        HEAP32[ctl(Control.ERROR_CODE)] = -2;
+        HEAPU32[ctl(Control.OPERATION)] = OperationType.ERROR;
+        return -1;
+      }
+      HEAPU32[ctl(Control.OPERATION)] = OperationType.COMPLETED;
+      internalSend(new Uint8Array([90, 0, 0, 0, 5, 73]));
       return 0;
     },
   };
@@ -6,6 +6,26 @@
  * bidirectional communication between JavaScript and WASM without
  * requiring runtime WASM code generation.
  *
+ * Input and output are lock-free single-producer/single-consumer rings, so
+ * the writer only stalls when the ring is actually full rather than after
+ * every buffer handoff.
+ *
+ * Build with -DPGLITE_POLLING_SHARED (and -pthread / -sSHARED_MEMORY under
+ * Emscripten) to run the backend in its own worker: the cursors and status
+ * fields become C11 atomics, JS waits with Atomics.waitAsync and the backend
+ * blocks on a futex instead of calling back into JS.
+ *
+ * Build with -DPGLITE_POLLING_ASYNC (and -sJSPI, or -sASYNCIFY) to let recv()
+ * suspend on an empty input ring until the host has more input, so a single
+ * query can stream input from an async source (see "Async Input").
+ *
+ * Build with -DPGLITE_COMM_STATS for a per-query stats block (call counts,
+ * bytes, size histograms, time handed over to the host).
+ *
+ * The rings are allocated on first use, or by pglite_init_buffers() with a
+ * size JS picks, and resized between queries to fit the responses actually
+ * seen (see "Adaptive Ring Sizing").
+ *
  * SPIKE 3: Shared memory polling instead of callbacks
  */
 
@@ -13,32 +33,113 @@
 #define PGLITE_COMM_POLLING_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#include <emscripten/em_js.h>
 #define EXPORT __attribute__((export_name(#name)))
 #define EXPORT_NAME(name) __attribute__((export_name(#name)))
 #define KEEPALIVE EMSCRIPTEN_KEEPALIVE
 #else
+#include <sched.h>
+#include <time.h>
 #define EXPORT_NAME(name)
 #define KEEPALIVE
 #endif
 
+#if defined(PGLITE_POLLING_ASYNC) && defined(PGLITE_POLLING_SHARED)
+#error "PGLITE_POLLING_ASYNC is for single-threaded builds; shared mode already blocks in recv()"
+#endif
+
+#ifdef PGLITE_POLLING_SHARED
+#include <limits.h>
+#include <stdatomic.h>
+#ifdef __EMSCRIPTEN__
+#include <math.h>
+#include <emscripten/threading.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
 /**
  * Buffer sizes and limits
+ * PGLITE_BUFFER_SIZE is the ring capacity used until JS or the adaptive
+ * sizing picks another; the live value is pglite_get_buffer_size().
+ * Adaptive sizing stays within [PGLITE_MIN_BUFFER_SIZE, PGLITE_MAX_BUFFER_SIZE]
+ * unless pglite_set_buffer_limits() narrows it.
  */
-#define PGLITE_BUFFER_SIZE (64 * 1024)  // 64KB per buffer
+#ifndef PGLITE_BUFFER_SIZE
+#define PGLITE_BUFFER_SIZE (64 * 1024)  // 64KB per ring (must be a power of two)
+#endif
+#ifndef PGLITE_MIN_BUFFER_SIZE
+#define PGLITE_MIN_BUFFER_SIZE (4 * 1024)
+#endif
+#ifndef PGLITE_MAX_BUFFER_SIZE
+#define PGLITE_MAX_BUFFER_SIZE (16 * 1024 * 1024)
+#endif
 #define PGLITE_MAX_MESSAGE_SIZE (1024 * 1024)  // 1MB max message
+#define PGLITE_CACHE_LINE_SIZE 64
+
+#if (PGLITE_BUFFER_SIZE & (PGLITE_BUFFER_SIZE - 1)) != 0
+#error "PGLITE_BUFFER_SIZE must be a power of two"
+#endif
+#if (PGLITE_MIN_BUFFER_SIZE & (PGLITE_MIN_BUFFER_SIZE - 1)) != 0 || \
+    (PGLITE_MAX_BUFFER_SIZE & (PGLITE_MAX_BUFFER_SIZE - 1)) != 0
+#error "PGLITE_MIN_BUFFER_SIZE and PGLITE_MAX_BUFFER_SIZE must be powers of two"
+#endif
 
 /**
- * Buffer status flags
+ * Adaptive sizing: queries per shrink decision. The rings shrink when every
+ * query in a window moved less than a quarter of the current capacity.
  */
-typedef enum {
-    BUFFER_EMPTY = 0,      // No data in buffer
-    BUFFER_READY = 1,      // Data ready to be consumed
-    BUFFER_PROCESSING = 2  // Currently being processed
-} BufferStatus;
+#ifndef PGLITE_RESIZE_WINDOW
+#define PGLITE_RESIZE_WINDOW 32
+#endif
+
+/**
+ * How many times a native writer yields while waiting for the consumer to
+ * free ring space before giving up. WASM builds are single-threaded and
+ * never wait here.
+ */
+#ifndef PGLITE_RING_SPIN_LIMIT
+#define PGLITE_RING_SPIN_LIMIT (1 << 20)
+#endif
+
+/**
+ * High-water mark for coalesced send(): once this many bytes have been sent
+ * without a host notification, notify even though PostgreSQL has not reached
+ * a flush point yet. Unless defined here or set at runtime with
+ * pglite_set_flush_high_water(), it is half the live ring size and follows
+ * the rings as they resize.
+ */
+
+/**
+ * Cursor access with acquire/release ordering.
+ * The producer publishes data by storing head with release semantics after
+ * the memcpy; the consumer frees space by storing tail the same way.
+ *
+ * In shared mode the fields JS waits on are real C11 atomics; otherwise JS
+ * and WASM take turns on one thread and volatile is enough.
+ */
+#ifdef PGLITE_POLLING_SHARED
+typedef _Atomic uint32_t pglite_u32_t;
+typedef _Atomic int32_t pglite_i32_t;
+#define PGLITE_LOAD_ACQUIRE(p) atomic_load_explicit((p), memory_order_acquire)
+#define PGLITE_STORE_RELEASE(p, v) \
+    atomic_store_explicit((p), (v), memory_order_release)
+#else
+typedef volatile uint32_t pglite_u32_t;
+typedef volatile int32_t pglite_i32_t;
+#define PGLITE_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PGLITE_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
 
 /**
  * Operation types for control block
@@ -52,55 +153,489 @@ typedef enum {
 } OperationType;
 
 /**
- * Shared buffer structure
- * Layout is designed for easy access from both JS and C:
- * - 4 bytes: status (u32)
- * - 4 bytes: length (u32)
- * - N bytes: data
+ * Single-producer/single-consumer ring buffer
+ *
+ * head and tail are free-running byte counters (they wrap at 2^32, which is
+ * fine because capacity is a power of two well below that). The number of
+ * readable bytes is always head - tail; the slot for a counter is
+ * counter & mask. Each cursor lives on its own cache line so the producer
+ * and consumer never write to the same line.
+ *
+ * Layout (byte offsets, published to JS through PGliteLayout):
+ * -   0: head (u32)      - written only by the producer
+ * -  64: tail (u32)      - written only by the consumer
+ * - 128: capacity (u32)  - constant after reset
+ * - 132: mask (u32)      - capacity - 1
+ * - 192: data[capacity]
+ *
+ * For the input ring JS is the producer and C the consumer; for the output
+ * ring it is the other way around.
+ *
+ * Rings are heap-allocated with their data inline, so a resize moves them:
+ * JS re-reads the ring pointers whenever pglite_get_buffer_size() changes.
  */
 typedef struct {
-    volatile uint32_t status;   // BufferStatus
-    volatile uint32_t length;   // Current data length
-    uint8_t data[PGLITE_BUFFER_SIZE];
-} __attribute__((packed)) PGliteBuffer;
+    pglite_u32_t head;
+    uint8_t _pad_head[PGLITE_CACHE_LINE_SIZE - sizeof(uint32_t)];
+    pglite_u32_t tail;
+    uint8_t _pad_tail[PGLITE_CACHE_LINE_SIZE - sizeof(uint32_t)];
+    uint32_t capacity;
+    uint32_t mask;
+    uint8_t _pad_meta[PGLITE_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+    uint8_t data[];
+} __attribute__((aligned(PGLITE_CACHE_LINE_SIZE))) PGliteRing;
 
 /**
  * Control block for synchronization
+ *
+ * Same layout in every mode: naturally aligned fields, so each one is a
+ * valid Atomics.wait() target, grouped by how often they change.
+ * - Line 0: the state the host polls or waits on, written once per
+ *   notification or state change.
+ * - Line 1: counters the backend bumps on every read and write. The host
+ *   reads them after a query, so keeping them off line 0 stops every
+ *   write from invalidating the line a waiting host is watching.
+ *
+ * JS reads the offsets from pglite_get_layout() rather than assuming them.
  */
 typedef struct {
-    volatile uint32_t operation;  // OperationType
-    volatile int32_t error_code;  // Error code if any
-    volatile uint32_t read_offset; // Current read position in input
-    volatile uint32_t total_read;  // Total bytes read so far
-    volatile uint32_t total_written; // Total bytes written so far
-} __attribute__((packed)) PGliteControl;
+    // Line 0: state
+    pglite_u32_t operation;     // OperationType
+    pglite_i32_t error_code;    // Error code if any
+    pglite_u32_t notifications; // Times the host was told output is ready
+    uint8_t _pad_state[PGLITE_CACHE_LINE_SIZE - 3 * sizeof(uint32_t)];
+    // Line 1: counters
+    pglite_u32_t read_offset;   // Bytes consumed from the current input message
+    pglite_u32_t total_read;    // Total bytes read so far
+    pglite_u32_t total_written; // Total bytes written so far
+    pglite_u32_t write_yields;  // Times the writer handed control to the host
+    pglite_u32_t send_calls;    // send() calls since reset
+    pglite_u32_t input_waits;   // Times recv() waited on the host for input
+    uint8_t _pad_counters[PGLITE_CACHE_LINE_SIZE - 6 * sizeof(uint32_t)];
+} __attribute__((aligned(PGLITE_CACHE_LINE_SIZE))) PGliteControl;
+
+/**
+ * Layout descriptor: the byte offsets JS needs, exported once through
+ * pglite_get_layout() so the TypeScript side never hard-codes them.
+ *
+ * All fields are u32. The first three identify the descriptor; new fields
+ * are only ever appended, and `size` says how many this build has, so an
+ * older host can read a newer descriptor. `version` changes only when an
+ * existing field changes meaning.
+ */
+#define PGLITE_LAYOUT_MAGIC 0x50474C43u  // "PGLC"
+#define PGLITE_LAYOUT_VERSION 2          // 1: the packed control block
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // sizeof(PGliteLayout)
+    // PGliteRing
+    uint32_t ring_head;
+    uint32_t ring_tail;
+    uint32_t ring_capacity;
+    uint32_t ring_mask;
+    uint32_t ring_data;
+    // PGliteControl
+    uint32_t control_size;
+    uint32_t control_operation;
+    uint32_t control_error_code;
+    uint32_t control_notifications;
+    uint32_t control_read_offset;
+    uint32_t control_total_read;
+    uint32_t control_total_written;
+    uint32_t control_write_yields;
+    uint32_t control_send_calls;
+    uint32_t control_input_waits;
+} PGliteLayout;
+
+static const PGliteLayout g_layout = {
+    .magic = PGLITE_LAYOUT_MAGIC,
+    .version = PGLITE_LAYOUT_VERSION,
+    .size = sizeof(PGliteLayout),
+    .ring_head = offsetof(PGliteRing, head),
+    .ring_tail = offsetof(PGliteRing, tail),
+    .ring_capacity = offsetof(PGliteRing, capacity),
+    .ring_mask = offsetof(PGliteRing, mask),
+    .ring_data = offsetof(PGliteRing, data),
+    .control_size = sizeof(PGliteControl),
+    .control_operation = offsetof(PGliteControl, operation),
+    .control_error_code = offsetof(PGliteControl, error_code),
+    .control_notifications = offsetof(PGliteControl, notifications),
+    .control_read_offset = offsetof(PGliteControl, read_offset),
+    .control_total_read = offsetof(PGliteControl, total_read),
+    .control_total_written = offsetof(PGliteControl, total_written),
+    .control_write_yields = offsetof(PGliteControl, write_yields),
+    .control_send_calls = offsetof(PGliteControl, send_calls),
+    .control_input_waits = offsetof(PGliteControl, input_waits),
+};
+
+_Static_assert(offsetof(PGliteControl, read_offset) == PGLITE_CACHE_LINE_SIZE,
+               "control counters must start on their own cache line");
+_Static_assert(sizeof(PGliteControl) == 2 * PGLITE_CACHE_LINE_SIZE,
+               "control block is two cache lines");
+_Static_assert(offsetof(PGliteRing, tail) % PGLITE_CACHE_LINE_SIZE == 0 &&
+                   offsetof(PGliteRing, data) % PGLITE_CACHE_LINE_SIZE == 0,
+               "ring cursors and data must start on their own cache lines");
 
 /**
  * Global shared memory regions
  * These are exported and accessible from JavaScript
  */
-static PGliteBuffer g_input_buffer;
-static PGliteBuffer g_output_buffer;
+static PGliteRing *g_input_buffer = NULL;
+static PGliteRing *g_output_buffer = NULL;
 static PGliteControl g_control;
 
+/**
+ * Live ring capacity (both rings share it) and the bounds adaptive sizing
+ * keeps it in. g_resize_window_* track the largest query since the last
+ * shrink check.
+ */
+static uint32_t g_buffer_size = PGLITE_BUFFER_SIZE;
+static uint32_t g_buffer_min = PGLITE_MIN_BUFFER_SIZE;
+static uint32_t g_buffer_max = PGLITE_MAX_BUFFER_SIZE;
+static uint32_t g_resize_window_peak = 0;
+static uint32_t g_resize_window_queries = 0;
+
+/**
+ * Coalescing state: total_written at the last host notification, and the
+ * threshold above which send() notifies without waiting for a flush point.
+ */
+static uint32_t g_notified_written = 0;
+#ifdef PGLITE_FLUSH_HIGH_WATER
+static uint32_t g_flush_high_water = PGLITE_FLUSH_HIGH_WATER;
+static int g_flush_high_water_fixed = 1;
+#else
+static uint32_t g_flush_high_water = PGLITE_BUFFER_SIZE / 2;
+static int g_flush_high_water_fixed = 0;
+#endif
+
+/* ============================================================================
+ * Comm Stats (compile with -DPGLITE_COMM_STATS)
+ * ============================================================================
+ *
+ * Counts what crosses the socket layer so query latency can be split
+ * between the executor and the host. pglite_reset_buffers() clears the
+ * block, so it covers one query; the layout is shared by all comm variants.
+ *
+ * Here the "host" time is time the backend spends handed over to or
+ * waiting on the host: yield-to-host calls and, in shared mode, futex
+ * waits for input or ring space. Builds without the flag pay nothing.
+ */
+
+#ifdef PGLITE_COMM_STATS
+
+#define PGLITE_STATS_BUCKETS 32
+
+/**
+ * 296 bytes, no padding: u32 counters at 0, doubles at 16, histograms at
+ * 40 (recv) and 168 (send). Histogram bucket i counts transfers of
+ * [2^i, 2^(i+1)) bytes; empty transfers land in bucket 0.
+ */
+typedef struct {
+    uint32_t recv_calls;
+    uint32_t send_calls;
+    uint32_t short_reads;   // recv() returned less than it was asked for
+    uint32_t host_calls;
+    double recv_bytes;
+    double send_bytes;
+    double host_time_ms;    // cumulative time inside host callbacks
+    uint32_t recv_size_log2[PGLITE_STATS_BUCKETS];
+    uint32_t send_size_log2[PGLITE_STATS_BUCKETS];
+} pglite_comm_stats_t;
+
+static pglite_comm_stats_t pglite_comm_stats;
+
+EXPORT_NAME(pglite_get_comm_stats)
+pglite_comm_stats_t* KEEPALIVE pglite_get_comm_stats(void) {
+    return &pglite_comm_stats;
+}
+
+EXPORT_NAME(pglite_reset_comm_stats)
+void KEEPALIVE pglite_reset_comm_stats(void) {
+    memset(&pglite_comm_stats, 0, sizeof(pglite_comm_stats));
+}
+
+static inline double pglite_stats_now(void) {
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+
+static inline uint32_t pglite_stats_bucket(size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t bucket = 63 - __builtin_clzll((unsigned long long)n);
+    return bucket < PGLITE_STATS_BUCKETS ? bucket : PGLITE_STATS_BUCKETS - 1;
+}
+
+static inline void pglite_stats_recv(size_t asked, ssize_t got) {
+    size_t n = got > 0 ? (size_t)got : 0;
+    pglite_comm_stats.recv_calls++;
+    pglite_comm_stats.recv_bytes += n;
+    pglite_comm_stats.short_reads += n < asked;
+    pglite_comm_stats.recv_size_log2[pglite_stats_bucket(n)]++;
+}
+
+static inline void pglite_stats_send(size_t n) {
+    pglite_comm_stats.send_calls++;
+    pglite_comm_stats.send_bytes += n;
+    pglite_comm_stats.send_size_log2[pglite_stats_bucket(n)]++;
+}
+
+#define PGLITE_STATS_RECV(asked, got) pglite_stats_recv((asked), (got))
+#define PGLITE_STATS_SEND(n) pglite_stats_send(n)
+#define PGLITE_STATS_HOST_BEGIN() \
+    double pglite_stats_start = pglite_stats_now(); \
+    pglite_comm_stats.host_calls++
+#define PGLITE_STATS_HOST_END() \
+    pglite_comm_stats.host_time_ms += pglite_stats_now() - pglite_stats_start
+
+#else
+
+#define PGLITE_STATS_RECV(asked, got) ((void)0)
+#define PGLITE_STATS_SEND(n) ((void)0)
+#define PGLITE_STATS_HOST_BEGIN() ((void)0)
+#define PGLITE_STATS_HOST_END() ((void)0)
+
+#endif /* PGLITE_COMM_STATS */
+
+/* ============================================================================
+ * Ring Primitives
+ * ============================================================================ */
+
+static inline void pglite_ring_reset(PGliteRing *ring) {
+    PGLITE_STORE_RELEASE(&ring->tail, 0);
+    PGLITE_STORE_RELEASE(&ring->head, 0);
+}
+
+/**
+ * Bytes currently readable. Safe to call from either side.
+ */
+static inline uint32_t pglite_ring_used(PGliteRing *ring) {
+    return PGLITE_LOAD_ACQUIRE(&ring->head) - PGLITE_LOAD_ACQUIRE(&ring->tail);
+}
+
+/**
+ * Producer side: copy up to len bytes in, return how many fit.
+ */
+static size_t pglite_ring_write(PGliteRing *ring, const void *src, size_t len) {
+    uint32_t head = ring->head;
+    uint32_t tail = PGLITE_LOAD_ACQUIRE(&ring->tail);
+    size_t space = ring->capacity - (head - tail);
+    size_t n = len < space ? len : space;
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t pos = head & ring->mask;
+    size_t first = ring->capacity - pos;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(ring->data + pos, src, first);
+    memcpy(ring->data, (const uint8_t *)src + first, n - first);
+
+    PGLITE_STORE_RELEASE(&ring->head, head + (uint32_t)n);
+    return n;
+}
+
+/**
+ * Consumer side: copy up to max_len bytes out, return how many were read.
+ */
+static size_t pglite_ring_read(PGliteRing *ring, void *dst, size_t max_len) {
+    uint32_t tail = ring->tail;
+    uint32_t head = PGLITE_LOAD_ACQUIRE(&ring->head);
+    size_t available = head - tail;
+    size_t n = max_len < available ? max_len : available;
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t pos = tail & ring->mask;
+    size_t first = ring->capacity - pos;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(dst, ring->data + pos, first);
+    memcpy((uint8_t *)dst + first, ring->data, n - first);
+
+    PGLITE_STORE_RELEASE(&ring->tail, tail + (uint32_t)n);
+    return n;
+}
+
+/* ============================================================================
+ * Adaptive Ring Sizing
+ * ============================================================================
+ *
+ * Both rings share one power-of-two capacity. Nothing is allocated until
+ * the first query or pglite_init_buffers(), so JS can pick the starting
+ * size and a module that only sees small queries never reserves 2 x 64KB.
+ *
+ * pglite_reset_buffers() looks at how many bytes the query that just
+ * finished moved in either direction, then:
+ * - if that was more than the capacity (the result needed handoffs), grows
+ *   straight to the next power of two that holds it, so the next result of
+ *   that shape streams without yielding;
+ * - once every query of a PGLITE_RESIZE_WINDOW-query window moved under a
+ *   quarter of the capacity, shrinks to fit the largest of them.
+ * Rings are only replaced there, while both are empty. Shared mode never
+ * resizes on its own: the host thread holds on to the ring pointers.
+ */
+
+/* Smallest power of two >= n within [lo, hi] (lo and hi powers of two) */
+static inline uint32_t pglite_clamp_pow2(uint64_t n, uint32_t lo, uint32_t hi) {
+    uint32_t size = lo;
+    while (size < n && size < hi) {
+        size <<= 1;
+    }
+    return size;
+}
+
+static PGliteRing *pglite_ring_alloc(uint32_t capacity) {
+    // capacity >= 4KB keeps the total a multiple of the alignment
+    PGliteRing *ring =
+        aligned_alloc(PGLITE_CACHE_LINE_SIZE, sizeof(PGliteRing) + capacity);
+    if (!ring) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(PGliteRing));
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    return ring;
+}
+
+/**
+ * Replace both rings with empty ones of `size` bytes.
+ * Returns 0, or -1 if allocation failed (the current rings are kept).
+ */
+static int pglite_resize_buffers(uint32_t size) {
+    g_resize_window_peak = 0;
+    g_resize_window_queries = 0;
+    if (g_output_buffer && size == g_buffer_size) {
+        return 0;
+    }
+
+    PGliteRing *input = pglite_ring_alloc(size);
+    PGliteRing *output = pglite_ring_alloc(size);
+    if (!input || !output) {
+        free(input);
+        free(output);
+        return -1;
+    }
+    free(g_input_buffer);
+    free(g_output_buffer);
+    g_input_buffer = input;
+    g_output_buffer = output;
+    g_buffer_size = size;
+    if (!g_flush_high_water_fixed) {
+        g_flush_high_water = size / 2;
+    }
+    return 0;
+}
+
+/* Allocate the rings at the current size if nothing has yet */
+static inline int pglite_ensure_buffers(void) {
+    return g_output_buffer ? 0 : pglite_resize_buffers(g_buffer_size);
+}
+
+/**
+ * Pick the ring size for the next query from the one that just finished.
+ * Must run before its counters are reset.
+ */
+static void pglite_adapt_buffers(void) {
+    uint32_t moved = g_control.total_read > g_control.total_written
+                         ? g_control.total_read
+                         : g_control.total_written;
+    uint32_t size = g_buffer_size;
+
+    if (moved > size) {
+        size = pglite_clamp_pow2(moved, g_buffer_min, g_buffer_max);
+    } else {
+        if (moved > g_resize_window_peak) {
+            g_resize_window_peak = moved;
+        }
+        if (++g_resize_window_queries >= PGLITE_RESIZE_WINDOW) {
+            if (g_resize_window_peak <= size / 4) {
+                size = pglite_clamp_pow2(g_resize_window_peak, g_buffer_min,
+                                         g_buffer_max);
+            }
+            g_resize_window_peak = 0;
+            g_resize_window_queries = 0;
+        }
+    }
+
+    // The limits may have moved since the rings were sized
+    if (size < g_buffer_min) {
+        size = g_buffer_min;
+    } else if (size > g_buffer_max) {
+        size = g_buffer_max;
+    }
+    if (size != g_buffer_size) {
+        pglite_resize_buffers(size);
+    }
+}
+
+/* ============================================================================
+ * Shared-memory Wait/Wake (PGLITE_POLLING_SHARED only)
+ * ============================================================================ */
+
+#ifdef PGLITE_POLLING_SHARED
+/**
+ * Block while *addr == expected. Spurious wakeups are fine; callers loop.
+ * The JS side wakes us with Atomics.notify() on the same u32.
+ */
+static inline void pglite_polling_wait(pglite_u32_t *addr, uint32_t expected) {
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wait((void *)addr, expected, INFINITY);
+#elif defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, NULL, NULL, 0);
+#else
+    (void)addr;
+    (void)expected;
+    sched_yield();
+#endif
+}
+
+/**
+ * Wake every waiter on addr (JS Atomics.waitAsync or a native thread)
+ */
+static inline void pglite_polling_wake(pglite_u32_t *addr) {
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wake((void *)addr, INT_MAX);
+#elif defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+#endif // PGLITE_POLLING_SHARED
+
 /* ============================================================================
  * Exported Functions for JavaScript Access
  * ============================================================================ */
 
 /**
- * Get pointer to input buffer (for JS to write query data)
+ * Get pointer to input ring (for JS to write query data)
  */
 EXPORT_NAME(pglite_get_input_buffer)
 void* KEEPALIVE pglite_get_input_buffer(void) {
-    return &g_input_buffer;
+    pglite_ensure_buffers();
+    return g_input_buffer;
 }
 
 /**
- * Get pointer to output buffer (for JS to read results)
+ * Get pointer to output ring (for JS to read results)
  */
 EXPORT_NAME(pglite_get_output_buffer)
 void* KEEPALIVE pglite_get_output_buffer(void) {
-    return &g_output_buffer;
+    pglite_ensure_buffers();
+    return g_output_buffer;
 }
 
 /**
@@ -112,22 +647,35 @@ void* KEEPALIVE pglite_get_control(void) {
 }
 
 /**
- * Get buffer size constant
+ * Get pointer to the layout descriptor (see PGliteLayout)
+ */
+EXPORT_NAME(pglite_get_layout)
+const void* KEEPALIVE pglite_get_layout(void) {
+    return &g_layout;
+}
+
+/**
+ * Get the live ring capacity
+ * Changes only inside pglite_init_buffers() and pglite_reset_buffers();
+ * when it does, the ring pointers above have moved too.
  */
 EXPORT_NAME(pglite_get_buffer_size)
 uint32_t KEEPALIVE pglite_get_buffer_size(void) {
-    return PGLITE_BUFFER_SIZE;
+    return g_buffer_size;
 }
 
 /**
- * Signal that input data is ready for WASM to read
- * Called by JavaScript after writing data to input buffer
+ * Publish input data for WASM to read
+ * Called by JavaScript after copying `length` bytes into the input ring at
+ * the current head position. JS may also advance head directly.
  */
 EXPORT_NAME(pglite_signal_input_ready)
 void KEEPALIVE pglite_signal_input_ready(uint32_t length) {
-    g_input_buffer.length = length;
-    g_input_buffer.status = BUFFER_READY;
+    if (pglite_ensure_buffers() != 0) {
+        return;
+    }
     g_control.read_offset = 0;
+    PGLITE_STORE_RELEASE(&g_input_buffer->head, g_input_buffer->head + length);
 }
 
 /**
@@ -136,15 +684,77 @@ void KEEPALIVE pglite_signal_input_ready(uint32_t length) {
  */
 EXPORT_NAME(pglite_reset_buffers)
 void KEEPALIVE pglite_reset_buffers(void) {
-    g_input_buffer.status = BUFFER_EMPTY;
-    g_input_buffer.length = 0;
-    g_output_buffer.status = BUFFER_EMPTY;
-    g_output_buffer.length = 0;
+#ifndef PGLITE_POLLING_SHARED
+    if (g_output_buffer) {
+        pglite_adapt_buffers();
+    }
+#endif
+    if (pglite_ensure_buffers() != 0) {
+        g_control.operation = OP_ERROR;
+        g_control.error_code = -1;
+        return;
+    }
+    pglite_ring_reset(g_input_buffer);
+    pglite_ring_reset(g_output_buffer);
     g_control.operation = OP_NONE;
     g_control.error_code = 0;
+#ifdef PGLITE_COMM_STATS
+    pglite_reset_comm_stats();
+#endif
     g_control.read_offset = 0;
     g_control.total_read = 0;
     g_control.total_written = 0;
+    g_control.write_yields = 0;
+    g_control.notifications = 0;
+    g_control.send_calls = 0;
+    g_control.input_waits = 0;
+    g_notified_written = 0;
+}
+
+/**
+ * Size both rings before the first query
+ * `size` is rounded up to a power of two within the buffer limits.
+ * Returns the live size, or 0 if the rings could not be allocated.
+ */
+EXPORT_NAME(pglite_init_buffers)
+uint32_t KEEPALIVE pglite_init_buffers(uint32_t size) {
+    if (pglite_resize_buffers(
+            pglite_clamp_pow2(size, g_buffer_min, g_buffer_max)) != 0) {
+        return 0;
+    }
+    // Start fresh rather than adapting to whatever ran before
+    g_control.total_read = 0;
+    g_control.total_written = 0;
+    pglite_reset_buffers();
+    return g_buffer_size;
+}
+
+/**
+ * Bound adaptive sizing
+ * Both limits are rounded up to powers of two within
+ * [PGLITE_MIN_BUFFER_SIZE, PGLITE_MAX_BUFFER_SIZE]; min == max pins the
+ * ring size. Applied at the next pglite_reset_buffers().
+ */
+EXPORT_NAME(pglite_set_buffer_limits)
+void KEEPALIVE pglite_set_buffer_limits(uint32_t min_size, uint32_t max_size) {
+    g_buffer_min = pglite_clamp_pow2(min_size, PGLITE_MIN_BUFFER_SIZE,
+                                     PGLITE_MAX_BUFFER_SIZE);
+    g_buffer_max = pglite_clamp_pow2(max_size, PGLITE_MIN_BUFFER_SIZE,
+                                     PGLITE_MAX_BUFFER_SIZE);
+    if (g_buffer_max < g_buffer_min) {
+        g_buffer_max = g_buffer_min;
+    }
+}
+
+/**
+ * Set the coalescing high-water mark in bytes
+ * 0 notifies on every send(), which is the old behaviour. The mark no
+ * longer follows the ring size once set.
+ */
+EXPORT_NAME(pglite_set_flush_high_water)
+void KEEPALIVE pglite_set_flush_high_water(uint32_t bytes) {
+    g_flush_high_water = bytes;
+    g_flush_high_water_fixed = 1;
 }
 
 /**
@@ -153,25 +763,47 @@ void KEEPALIVE pglite_reset_buffers(void) {
  */
 EXPORT_NAME(pglite_has_output)
 int KEEPALIVE pglite_has_output(void) {
-    return g_output_buffer.status == BUFFER_READY ? 1 : 0;
+    if (pglite_ensure_buffers() != 0) {
+        return 0;
+    }
+    return pglite_ring_used(g_output_buffer) > 0 ? 1 : 0;
 }
 
 /**
- * Get output length
+ * Get number of readable output bytes
  */
 EXPORT_NAME(pglite_get_output_length)
 uint32_t KEEPALIVE pglite_get_output_length(void) {
-    return g_output_buffer.length;
+    if (pglite_ensure_buffers() != 0) {
+        return 0;
+    }
+    return pglite_ring_used(g_output_buffer);
+}
+
+/**
+ * Release `length` bytes of output back to the writer
+ * Called by JavaScript after copying them out of the output ring.
+ */
+EXPORT_NAME(pglite_consume_output)
+void KEEPALIVE pglite_consume_output(uint32_t length) {
+    if (pglite_ensure_buffers() != 0) {
+        return;
+    }
+    PGLITE_STORE_RELEASE(&g_output_buffer->tail, g_output_buffer->tail + length);
 }
 
 /**
- * Acknowledge that output has been consumed
- * Called by JavaScript after reading output buffer
+ * Acknowledge that all currently readable output has been consumed
+ * Kept for the single-slot API; prefer pglite_consume_output() so bytes
+ * published after the read are not dropped.
  */
 EXPORT_NAME(pglite_ack_output)
 void KEEPALIVE pglite_ack_output(void) {
-    g_output_buffer.status = BUFFER_EMPTY;
-    g_output_buffer.length = 0;
+    if (pglite_ensure_buffers() != 0) {
+        return;
+    }
+    PGLITE_STORE_RELEASE(&g_output_buffer->tail,
+                         PGLITE_LOAD_ACQUIRE(&g_output_buffer->head));
 }
 
 /* ============================================================================
@@ -179,69 +811,272 @@ void KEEPALIVE pglite_ack_output(void) {
  * ============================================================================ */
 
 /**
- * Read data from input buffer (called by PostgreSQL's recv())
+ * Yield-to-host handshake
+ *
+ * When the output ring is full the writer sets OP_WRITE_READY and calls
+ * into the host once. The host drains the ring (advancing tail) before
+ * returning, so result sets of any size stream through a fixed 64KB ring
+ * instead of failing the send().
+ *
+ * WASM: an EM_JS trampoline calls Module._pglitePollingOnWriteReady, which
+ * pglite-polling.ts installs. No addFunction is involved.
+ * Native: a plain function pointer set with pglite_polling_set_yield_hook().
+ * Shared mode: no call at all, the host drains from another thread.
+ */
+#if defined(PGLITE_POLLING_SHARED)
+// The writer sleeps on the output tail instead (see wait_space)
+#elif defined(__EMSCRIPTEN__)
+EM_JS(int, pglite_polling_yield_to_host, (void), {
+    var onWriteReady = Module._pglitePollingOnWriteReady;
+    if (!onWriteReady) {
+        return 0;
+    }
+    try {
+        return onWriteReady() | 0;
+    } catch (e) {
+        console.error('pglite_polling_yield_to_host error:', e);
+        return 0;
+    }
+});
+#else
+typedef int (*pglite_yield_hook_t)(void);
+static pglite_yield_hook_t g_yield_hook = NULL;
+
+static inline void pglite_polling_set_yield_hook(pglite_yield_hook_t hook) {
+    g_yield_hook = hook;
+}
+
+static int pglite_polling_yield_to_host(void) {
+    return g_yield_hook ? g_yield_hook() : 0;
+}
+#endif
+
+/**
+ * Async input (PGLITE_POLLING_ASYNC)
+ *
+ * recv() on an empty input ring asks the host for more and suspends until
+ * it answers, instead of returning 0. The host refills the ring from
+ * wherever the input comes from (a fetch body, a file stream) and resolves
+ * with non-zero, or resolves with 0 at the end of the input, which recv()
+ * then reports as usual.
+ *
+ * WASM: an EM_ASYNC_JS import awaiting Module._pglitePollingOnInputNeeded,
+ * which pglite-polling.ts installs. Emscripten suspends the WASM stack with
+ * JSPI (-sJSPI) or, where that is unavailable, Asyncify (-sASYNCIFY); the
+ * C code is the same for both. Exports that can reach recv() then return
+ * Promises (call them through ccall with {async: true}).
+ * Native: a plain blocking function set with pglite_polling_set_input_hook().
+ */
+#ifdef PGLITE_POLLING_ASYNC
+#ifdef __EMSCRIPTEN__
+EM_ASYNC_JS(int, pglite_polling_wait_input, (void), {
+    var onInputNeeded = Module._pglitePollingOnInputNeeded;
+    if (!onInputNeeded) {
+        return 0;
+    }
+    try {
+        return (await onInputNeeded()) | 0;
+    } catch (e) {
+        console.error('pglite_polling_wait_input error:', e);
+        return 0;
+    }
+});
+#else
+typedef int (*pglite_input_hook_t)(void);
+static pglite_input_hook_t g_input_hook = NULL;
+
+static inline void pglite_polling_set_input_hook(pglite_input_hook_t hook) {
+    g_input_hook = hook;
+}
+
+static int pglite_polling_wait_input(void) {
+    return g_input_hook ? g_input_hook() : 0;
+}
+#endif
+#endif // PGLITE_POLLING_ASYNC
+
+/**
+ * Tell the host that everything written so far is ready to consume
+ */
+static inline void pglite_polling_notify(void) {
+    g_control.operation = OP_WRITE_READY;
+    g_notified_written = g_control.total_written;
+    g_control.notifications++;
+#ifdef PGLITE_POLLING_SHARED
+    // JS waits on the counter, so every bump is a distinct wakeup
+    pglite_polling_wake(&g_control.notifications);
+#endif
+}
+
+/**
+ * Wait for the output consumer to free ring space.
+ * Returns: 1 if space is available, 0 if the writer has to give up.
+ */
+static int pglite_polling_wait_space(void) {
+    // Ring full - signal to JS that it needs to consume, then hand over.
+    // total_written lags the bytes already in the ring here; the next
+    // flush point still notifies for them.
+    pglite_polling_notify();
+    g_control.write_yields++;
+
+#ifdef PGLITE_POLLING_SHARED
+    // The host drains on its own thread and wakes us by bumping tail
+    for (;;) {
+        uint32_t tail = PGLITE_LOAD_ACQUIRE(&g_output_buffer->tail);
+        if (g_output_buffer->head - tail < g_output_buffer->capacity) {
+            return 1;
+        }
+        pglite_polling_wait(&g_output_buffer->tail, tail);
+    }
+#else
+    pglite_polling_yield_to_host();
+
+    if (pglite_ring_used(g_output_buffer) < g_output_buffer->capacity) {
+        return 1;
+    }
+
+#ifndef __EMSCRIPTEN__
+    // No synchronous drain: a consumer thread may still be catching up
+    for (int i = 0; i < PGLITE_RING_SPIN_LIMIT; i++) {
+        if (pglite_ring_used(g_output_buffer) < g_output_buffer->capacity) {
+            return 1;
+        }
+        sched_yield();
+    }
+#endif
+    // Single-threaded and nobody drained: JS cannot run until we return
+    return 0;
+#endif
+}
+
+/**
+ * Read data from input ring (called by PostgreSQL's recv())
  * This replaces the pglite_read callback
  */
 static ssize_t pglite_polling_read(void *buf, size_t max_len) {
-    // Check if input data is available
-    if (g_input_buffer.status != BUFFER_READY) {
-        // No data available - in async mode, this would yield
-        // For now, return 0 (EOF-like)
-        return 0;
+    if (pglite_ensure_buffers() != 0) {
+        return -1;
     }
+    size_t to_read = pglite_ring_read(g_input_buffer, buf, max_len);
 
-    // Calculate available data
-    size_t available = g_input_buffer.length - g_control.read_offset;
-    if (available == 0) {
-        // All data consumed
-        g_input_buffer.status = BUFFER_EMPTY;
+#ifdef PGLITE_POLLING_SHARED
+    // Backend worker: sleep until the host publishes input
+    while (to_read == 0) {
+        uint32_t head = PGLITE_LOAD_ACQUIRE(&g_input_buffer->head);
+        if (head == g_input_buffer->tail) {
+            g_control.operation = OP_READ_REQUEST;
+            PGLITE_STATS_HOST_BEGIN();
+            pglite_polling_wait(&g_input_buffer->head, head);
+            PGLITE_STATS_HOST_END();
+        }
+        to_read = pglite_ring_read(g_input_buffer, buf, max_len);
+    }
+    // The host may be waiting for input space
+    pglite_polling_wake(&g_input_buffer->tail);
+#elif defined(PGLITE_POLLING_ASYNC)
+    // Suspend until the host has refilled the ring or runs out of input
+    while (to_read == 0) {
+        g_control.operation = OP_READ_REQUEST;
+        g_control.input_waits++;
+        PGLITE_STATS_HOST_BEGIN();
+        int more = pglite_polling_wait_input();
+        PGLITE_STATS_HOST_END();
+        if (!more) {
+            break;
+        }
+        to_read = pglite_ring_read(g_input_buffer, buf, max_len);
+    }
+#endif
+
+    PGLITE_STATS_RECV(max_len, (ssize_t)to_read);
+
+    if (to_read == 0) {
+        // No data available (or, in async mode, the end of the input):
+        // return 0 (EOF-like)
         return 0;
     }
 
-    // Copy data
-    size_t to_read = (max_len < available) ? max_len : available;
-    memcpy(buf, g_input_buffer.data + g_control.read_offset, to_read);
     g_control.read_offset += to_read;
     g_control.total_read += to_read;
 
-    // Mark as empty if all data consumed
-    if (g_control.read_offset >= g_input_buffer.length) {
-        g_input_buffer.status = BUFFER_EMPTY;
-    }
-
     return (ssize_t)to_read;
 }
 
 /**
- * Write data to output buffer (called by PostgreSQL's send())
+ * Write data to output ring (called by PostgreSQL's send())
  * This replaces the pglite_write callback
  */
 static ssize_t pglite_polling_write(const void *buf, size_t len) {
-    // Check if buffer has space
-    if (g_output_buffer.length + len > PGLITE_BUFFER_SIZE) {
-        // Buffer full - signal to JS that it needs to consume
-        g_output_buffer.status = BUFFER_READY;
-        g_control.operation = OP_WRITE_READY;
-        // Return error - buffer full
+    size_t written = 0;
+
+    if (pglite_ensure_buffers() != 0) {
         return -1;
     }
 
-    // Copy data to output buffer
-    memcpy(g_output_buffer.data + g_output_buffer.length, buf, len);
-    g_output_buffer.length += len;
-    g_control.total_written += len;
+    while (written < len) {
+        written += pglite_ring_write(g_output_buffer,
+                                     (const uint8_t *)buf + written,
+                                     len - written);
+        if (written == len) {
+            break;
+        }
 
-    return (ssize_t)len;
+        PGLITE_STATS_HOST_BEGIN();
+        int has_space = pglite_polling_wait_space();
+        PGLITE_STATS_HOST_END();
+        if (!has_space) {
+            break;
+        }
+    }
+
+    g_control.total_written += written;
+
+    // Only reached short when no host drain is installed. A short write is
+    // reported as such; nothing written at all is an error.
+    return written > 0 ? (ssize_t)written : -1;
 }
 
 /**
- * Flush output buffer - mark as ready for JS to consume
+ * Flush output ring - tell JS there is data to consume
+ * This is the explicit flush point: the backend calls it once a protocol
+ * round trip is complete (the equivalent of pq_flush() after
+ * ReadyForQuery). It is a no-op when nothing new has been sent.
  */
 static void pglite_polling_flush(void) {
-    if (g_output_buffer.length > 0) {
-        g_output_buffer.status = BUFFER_READY;
-        g_control.operation = OP_WRITE_READY;
+    if (g_control.total_written != g_notified_written &&
+        pglite_ring_used(g_output_buffer) > 0) {
+        pglite_polling_notify();
+    }
+}
+
+/**
+ * Does this send() end with ReadyForQuery ('Z', length 5, status byte)?
+ * pqcomm always hands over the whole message, so checking the tail of a
+ * single send is enough.
+ */
+static inline int pglite_polling_is_flush_point(const void *buf, size_t len) {
+    if (len < 6) {
+        return 0;
     }
+    const uint8_t *p = (const uint8_t *)buf + len - 6;
+    return p[0] == 'Z' && p[1] == 0 && p[2] == 0 && p[3] == 0 && p[4] == 5;
+}
+
+/**
+ * Coalesced send: write into the ring but only notify the host at a flush
+ * point or once the high-water mark has been passed, so a protocol round
+ * trip costs one notification rather than one per pqcomm fragment.
+ */
+static ssize_t pglite_polling_send(const void *buf, size_t len) {
+    g_control.send_calls++;
+    PGLITE_STATS_SEND(len);
+    ssize_t result = pglite_polling_write(buf, len);
+
+    if (pglite_polling_is_flush_point(buf, len) ||
+        g_control.total_written - g_notified_written >= g_flush_high_water) {
+        pglite_polling_flush();
+    }
+    return result;
 }
 
 /* ============================================================================
@@ -259,10 +1094,7 @@ ssize_t KEEPALIVE recv(int __fd, void *__buf, size_t __n, int __flags) {
 }
 
 ssize_t KEEPALIVE send(int __fd, const void *__buf, size_t __n, int __flags) {
-    ssize_t result = pglite_polling_write(__buf, __n);
-    // Flush after each send for simplicity
-    pglite_polling_flush();
-    return result;
+    return pglite_polling_send(__buf, __n);
 }
 
 #endif // PGLITE_USE_POLLING
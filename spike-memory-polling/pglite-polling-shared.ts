@@ -0,0 +1,195 @@
+/**
+ * pglite-polling-shared.ts
+ *
+ * Host side of the SharedArrayBuffer transport (PGLITE_POLLING_SHARED).
+ * The backend runs in its own worker and blocks on futexes; this class runs
+ * on the main thread, writes queries straight into the shared input ring and
+ * waits for results with Atomics.waitAsync, so nothing goes through
+ * postMessage after setup and the main thread never blocks.
+ *
+ * SPIKE 3: Shared memory polling instead of callbacks
+ */
+
+import type { CommLayout } from './pglite-polling.js';
+
+/**
+ * Where the backend's rings live, as posted by the worker once at startup
+ */
+export interface SharedLayout {
+  buffer: SharedArrayBuffer;
+  inputBuffer: number;
+  outputBuffer: number;
+  control: number;
+  bufferSize: number;
+  // Field offsets from the module's layout descriptor
+  fields: CommLayout;
+}
+
+/**
+ * Default completion check: the round trip ends with ReadyForQuery
+ */
+export function endsWithReadyForQuery(chunks: Uint8Array[]): boolean {
+  const tail: number[] = [];
+  for (let i = chunks.length - 1; i >= 0 && tail.length < 6; i--) {
+    const c = chunks[i];
+    for (let j = c.length - 1; j >= 0 && tail.length < 6; j--) {
+      tail.unshift(c[j]);
+    }
+  }
+  return (
+    tail.length === 6 &&
+    tail[0] === 0x5a && // 'Z'
+    tail[1] === 0 &&
+    tail[2] === 0 &&
+    tail[3] === 0 &&
+    tail[4] === 5
+  );
+}
+
+export class PGlitePollingShared {
+  private u8: Uint8Array;
+  private u32: Uint32Array;
+  private i32: Int32Array;
+  private layout: SharedLayout;
+  private lastNotification = 0;
+
+  constructor(layout: SharedLayout) {
+    this.layout = layout;
+    this.u8 = new Uint8Array(layout.buffer);
+    this.u32 = new Uint32Array(layout.buffer);
+    this.i32 = new Int32Array(layout.buffer);
+    this.lastNotification = this.u32[this.controlIndex('notifications')];
+  }
+
+  private controlIndex(field: keyof CommLayout['control']): number {
+    return (this.layout.control + this.layout.fields.control[field]) >> 2;
+  }
+
+  private cursorIndex(ringPtr: number, offset: number): number {
+    return (ringPtr + offset) >> 2;
+  }
+
+  /**
+   * Copy a query into the input ring and wake the backend. Waits
+   * (asynchronously) for space if the backend has not caught up yet.
+   */
+  async writeInput(data: Uint8Array): Promise<void> {
+    const ring = this.layout.inputBuffer;
+    const size = this.layout.bufferSize;
+    const headIdx = this.cursorIndex(ring, this.layout.fields.ring.head);
+    const tailIdx = this.cursorIndex(ring, this.layout.fields.ring.tail);
+    const dataPtr = ring + this.layout.fields.ring.data;
+    let offset = 0;
+
+    while (offset < data.length) {
+      const head = Atomics.load(this.u32, headIdx);
+      const tail = Atomics.load(this.u32, tailIdx);
+      const space = size - ((head - tail) >>> 0);
+      if (space === 0) {
+        const wait = Atomics.waitAsync(this.i32, tailIdx, tail | 0);
+        if (wait.async) await wait.value;
+        continue;
+      }
+
+      const n = Math.min(space, data.length - offset);
+      const pos = head & (size - 1);
+      const first = Math.min(n, size - pos);
+      this.u8.set(data.subarray(offset, offset + first), dataPtr + pos);
+      this.u8.set(data.subarray(offset + first, offset + n), dataPtr);
+
+      Atomics.store(this.u32, headIdx, head + n);
+      Atomics.notify(this.i32, headIdx);
+      offset += n;
+    }
+  }
+
+  /**
+   * Copy out and release whatever the backend has published so far
+   */
+  readOutput(): Uint8Array | null {
+    const ring = this.layout.outputBuffer;
+    const size = this.layout.bufferSize;
+    const headIdx = this.cursorIndex(ring, this.layout.fields.ring.head);
+    const tailIdx = this.cursorIndex(ring, this.layout.fields.ring.tail);
+    const head = Atomics.load(this.u32, headIdx);
+    const tail = Atomics.load(this.u32, tailIdx);
+    const length = (head - tail) >>> 0;
+    if (length === 0) {
+      return null;
+    }
+
+    const dataPtr = ring + this.layout.fields.ring.data;
+    const pos = tail & (size - 1);
+    const first = Math.min(length, size - pos);
+    const data = new Uint8Array(length);
+    data.set(this.u8.subarray(dataPtr + pos, dataPtr + pos + first));
+    data.set(this.u8.subarray(dataPtr, dataPtr + length - first), first);
+
+    // Free the space and wake the backend if it is parked on a full ring
+    Atomics.store(this.u32, tailIdx, tail + length);
+    Atomics.notify(this.i32, tailIdx);
+    return data;
+  }
+
+  /**
+   * Resolve once the backend has notified since the last call
+   */
+  async waitForNotification(): Promise<void> {
+    const idx = this.controlIndex('notifications');
+    const seen = Atomics.load(this.i32, idx);
+    if (seen === this.lastNotification) {
+      const wait = Atomics.waitAsync(this.i32, idx, seen);
+      if (wait.async) await wait.value;
+    }
+    this.lastNotification = Atomics.load(this.i32, idx);
+  }
+
+  /**
+   * Submit one round trip and collect its output
+   */
+  async exec(
+    message: Uint8Array,
+    isComplete: (chunks: Uint8Array[]) => boolean = endsWithReadyForQuery
+  ): Promise<Uint8Array> {
+    const chunks: Uint8Array[] = [];
+    await this.writeInput(message);
+
+    for (;;) {
+      const chunk = this.readOutput();
+      if (chunk) {
+        chunks.push(chunk);
+        if (isComplete(chunks)) break;
+      }
+      await this.waitForNotification();
+    }
+
+    if (chunks.length === 1) {
+      return chunks[0];
+    }
+    let total = 0;
+    for (const c of chunks) total += c.length;
+    const out = new Uint8Array(total);
+    let offset = 0;
+    for (const c of chunks) {
+      out.set(c, offset);
+      offset += c.length;
+    }
+    return out;
+  }
+
+  getStatus(): {
+    operation: number;
+    errorCode: number;
+    writeYields: number;
+    notifications: number;
+    sendCalls: number;
+  } {
+    return {
+      operation: Atomics.load(this.u32, this.controlIndex('operation')),
+      errorCode: Atomics.load(this.i32, this.controlIndex('errorCode')),
+      writeYields: Atomics.load(this.u32, this.controlIndex('writeYields')),
+      notifications: Atomics.load(this.u32, this.controlIndex('notifications')),
+      sendCalls: Atomics.load(this.u32, this.controlIndex('sendCalls')),
+    };
+  }
+}
@@ -7,13 +7,6 @@
  * SPIKE 3: Shared memory polling instead of callbacks
  */
 
-// Buffer status (must match C side)
-const BufferStatus = {
-  EMPTY: 0,
-  READY: 1,
-  PROCESSING: 2,
-} as const;
-
 // Operation types (must match C side)
 const OperationType = {
   NONE: 0,
@@ -23,8 +16,113 @@ const OperationType = {
   ERROR: 4,
 } as const;
 
-// Memory layout constants
-const BUFFER_HEADER_SIZE = 8; // 4 bytes status + 4 bytes length
+/**
+ * Byte offsets of the ring and control block fields, as described by the
+ * PGliteLayout that WASM exports through _get_layout()
+ * (pglite-comm-polling.h). head and tail are free-running u32 byte counters.
+ */
+export interface CommLayout {
+  version: number;
+  ring: {
+    head: number;
+    tail: number;
+    capacity: number;
+    mask: number;
+    data: number;
+  };
+  control: {
+    size: number;
+    operation: number;
+    errorCode: number;
+    notifications: number;
+    readOffset: number;
+    totalRead: number;
+    totalWritten: number;
+    writeYields: number;
+    sendCalls: number;
+    inputWaits: number;
+  };
+}
+
+export const LAYOUT_MAGIC = 0x50474c43; // "PGLC"
+export const LAYOUT_VERSION = 2;
+
+// Number of u32 fields in a version 2 descriptor. Newer builds may append
+// more; they are ignored here.
+export const LAYOUT_FIELDS = 18;
+
+/**
+ * Layout of modules built before the descriptor existed: a packed control
+ * block with every counter on the line the host polls
+ */
+export const LEGACY_LAYOUT: CommLayout = {
+  version: 1,
+  ring: { head: 0, tail: 64, capacity: 128, mask: 132, data: 192 },
+  control: {
+    size: 36,
+    operation: 0,
+    errorCode: 4,
+    readOffset: 8,
+    totalRead: 12,
+    totalWritten: 16,
+    writeYields: 20,
+    notifications: 24,
+    sendCalls: 28,
+    inputWaits: 32,
+  },
+};
+
+/**
+ * Decode the layout descriptor at ptr
+ */
+export function readLayout(heap: Uint32Array, ptr: number): CommLayout {
+  const base = ptr >>> 2;
+  if (heap[base] !== LAYOUT_MAGIC) {
+    throw new Error(`No comm layout descriptor at 0x${ptr.toString(16)}`);
+  }
+  const version = heap[base + 1];
+  if (version !== LAYOUT_VERSION) {
+    throw new Error(
+      `Unsupported comm layout version ${version} (expected ${LAYOUT_VERSION})`
+    );
+  }
+  if (heap[base + 2] < LAYOUT_FIELDS * 4) {
+    throw new Error(`Truncated comm layout descriptor: ${heap[base + 2]} bytes`);
+  }
+
+  const field = (i: number) => heap[base + i];
+  return {
+    version,
+    ring: {
+      head: field(3),
+      tail: field(4),
+      capacity: field(5),
+      mask: field(6),
+      data: field(7),
+    },
+    control: {
+      size: field(8),
+      operation: field(9),
+      errorCode: field(10),
+      notifications: field(11),
+      readOffset: field(12),
+      totalRead: field(13),
+      totalWritten: field(14),
+      writeYields: field(15),
+      sendCalls: field(16),
+      inputWaits: field(17),
+    },
+  };
+}
+
+/**
+ * The module's layout, or LEGACY_LAYOUT if it predates _get_layout()
+ */
+export function moduleLayout(mod: PollingWasmModule): CommLayout {
+  return mod._get_layout
+    ? readLayout(mod.HEAPU32, mod._get_layout())
+    : LEGACY_LAYOUT;
+}
 
 /**
  * Interface for the WASM module with polling support
@@ -39,18 +137,47 @@ export interface PollingWasmModule {
   _get_input_buffer(): number;
   _get_output_buffer(): number;
   _get_control(): number;
+  _get_layout?(): number;
   _get_buffer_size(): number;
 
   // Buffer management
+  _init_buffers?(size: number): number;
+  _set_buffer_limits?(min: number, max: number): void;
   _reset_buffers(): void;
   _signal_input_ready(length: number): void;
   _has_output(): number;
   _get_output_length(): number;
+  _consume_output(length: number): void;
   _ack_output(): void;
+  _set_flush_high_water?(bytes: number): void;
 
   // Processing
   _process_message(): number;
   _process_multi_row?(num_rows: number): number;
+  _process_query?(): number;
+  _serve?(max_queries: number): number;
+  // Async input builds: reads until the end of the input. Returns a Promise
+  // when called directly on a JSPI build.
+  _process_copy?(): number | Promise<number>;
+
+  // Emscripten's ccall; with {async: true} it drives exports that suspend,
+  // under both JSPI and Asyncify
+  ccall?(
+    name: string,
+    returnType: string,
+    argTypes: string[],
+    args: unknown[],
+    opts: { async: true },
+  ): Promise<number>;
+
+  // Installed by the host: called from WASM when the output ring is full.
+  // Return non-zero once space has been freed.
+  _pglitePollingOnWriteReady?: () => number;
+
+  // Installed by the host: awaited from WASM (async input builds) when
+  // recv() finds the input ring empty. Resolve non-zero once more input has
+  // been published, 0 at the end of the input.
+  _pglitePollingOnInputNeeded?: () => Promise<number>;
 }
 
 /**
@@ -64,7 +191,13 @@ export class PGlitePolling {
   private inputBufferPtr: number = 0;
   private outputBufferPtr: number = 0;
   private controlPtr: number = 0;
+  private layout: CommLayout = LEGACY_LAYOUT;
   private bufferSize: number = 0;
+  private outputHandler: ((chunk: Uint8Array) => void) | null = null;
+  private pendingOutput: Uint8Array[] = [];
+  private inputSource: AsyncIterator<Uint8Array> | Iterator<Uint8Array> | null =
+    null;
+  private pendingInput: Uint8Array | null = null;
 
   constructor(mod: PollingWasmModule) {
     this.mod = mod;
@@ -72,80 +205,315 @@ export class PGlitePolling {
 
   /**
    * Initialize - get buffer pointers from WASM
+   * @param bufferSize Starting ring size, for modules that size their rings
+   *   at runtime. They adapt it between queries from then on.
    */
-  init(): void {
-    this.inputBufferPtr = this.mod._get_input_buffer();
-    this.outputBufferPtr = this.mod._get_output_buffer();
+  init(bufferSize?: number): void {
+    if (bufferSize !== undefined && this.mod._init_buffers) {
+      if (this.mod._init_buffers(bufferSize) === 0) {
+        throw new Error(`Failed to allocate ${bufferSize} byte rings`);
+      }
+    }
+    this.layout = moduleLayout(this.mod);
     this.controlPtr = this.mod._get_control();
-    this.bufferSize = this.mod._get_buffer_size();
+    this.mod._reset_buffers();
+    this.refreshRings();
+    this.mod._pglitePollingOnWriteReady = () => this.onWriteReady();
+    this.mod._pglitePollingOnInputNeeded = () => this.onInputNeeded();
 
     console.log('PGlitePolling initialized:');
     console.log(`  Input buffer: 0x${this.inputBufferPtr.toString(16)}`);
     console.log(`  Output buffer: 0x${this.outputBufferPtr.toString(16)}`);
     console.log(`  Control block: 0x${this.controlPtr.toString(16)}`);
     console.log(`  Buffer size: ${this.bufferSize} bytes`);
+    console.log(`  Layout version: ${this.layout.version}`);
   }
 
   /**
-   * Write data to the input buffer for WASM to read
+   * Re-read the ring pointers if WASM resized the rings. Only
+   * _init_buffers() and _reset_buffers() can resize them.
+   */
+  private refreshRings(): void {
+    const size = this.mod._get_buffer_size();
+    if (size === this.bufferSize && this.inputBufferPtr !== 0) {
+      return;
+    }
+    this.bufferSize = size;
+    this.inputBufferPtr = this.mod._get_input_buffer();
+    this.outputBufferPtr = this.mod._get_output_buffer();
+  }
+
+  // Cursor accessors. Each side only ever stores its own cursor
+  // (JS: input head, output tail) and publishes it after the data copy.
+  private loadCursor(ringPtr: number, offset: number): number {
+    return this.mod.HEAPU32[(ringPtr + offset) >> 2];
+  }
+
+  private storeCursor(ringPtr: number, offset: number, value: number): void {
+    this.mod.HEAPU32[(ringPtr + offset) >> 2] = value >>> 0;
+  }
+
+  /**
+   * Bytes of free space in the input ring
+   */
+  inputSpace(): number {
+    const head = this.loadCursor(this.inputBufferPtr, this.layout.ring.head);
+    const tail = this.loadCursor(this.inputBufferPtr, this.layout.ring.tail);
+    return this.bufferSize - ((head - tail) >>> 0);
+  }
+
+  /**
+   * Write data to the input ring for WASM to read
    */
   writeInput(data: Uint8Array): void {
-    if (data.length > this.bufferSize) {
+    if (data.length > this.inputSpace()) {
       throw new Error(
-        `Input data too large: ${data.length} > ${this.bufferSize}`
+        `Input data too large: ${data.length} > ${this.inputSpace()}`
       );
     }
+    this.writeInputChunk(data);
+  }
 
-    // Write data to buffer (after 8-byte header)
-    const dataPtr = this.inputBufferPtr + BUFFER_HEADER_SIZE;
-    this.mod.HEAPU8.set(data, dataPtr);
+  /**
+   * Write as much of data as fits into the input ring.
+   * Returns the number of bytes written.
+   */
+  private writeInputChunk(data: Uint8Array): number {
+    const length = Math.min(data.length, this.inputSpace());
+    if (length === 0) {
+      return 0;
+    }
+
+    const head = this.loadCursor(this.inputBufferPtr, this.layout.ring.head);
+    const dataPtr = this.inputBufferPtr + this.layout.ring.data;
+    const pos = head & (this.bufferSize - 1);
+    const first = Math.min(length, this.bufferSize - pos);
 
-    // Signal that input is ready
-    this.mod._signal_input_ready(data.length);
+    // Copy in at most two pieces (before and after the wrap point)
+    this.mod.HEAPU8.set(data.subarray(0, first), dataPtr + pos);
+    if (first < length) {
+      this.mod.HEAPU8.set(data.subarray(first, length), dataPtr);
+    }
+
+    // Signal that input is ready (publishes the new head)
+    this.mod._signal_input_ready(length);
+    return length;
   }
 
   /**
-   * Read output data from WASM
+   * Async input callback: WASM's recv() found the input ring empty and is
+   * suspended until this resolves. Refill the ring from the input source.
+   */
+  private async onInputNeeded(): Promise<number> {
+    while (this.inputSource) {
+      if (this.pendingInput && this.pendingInput.length > 0) {
+        const n = this.writeInputChunk(this.pendingInput);
+        this.pendingInput = this.pendingInput.subarray(n);
+        return 1;
+      }
+
+      const { value, done } = await this.inputSource.next();
+      if (done) {
+        this.inputSource = null;
+      } else {
+        this.pendingInput = value;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * Run one COPY FROM STDIN style call (_process_copy), streaming its input
+   * from source as the backend asks for it, a ring's worth at a time, so
+   * the input never has to be buffered up front. Needs a module built with
+   * async input (PGLITE_POLLING_ASYNC / ./build.sh async).
+   */
+  async copyFrom(
+    source: AsyncIterable<Uint8Array> | Iterable<Uint8Array>
+  ): Promise<Uint8Array | null> {
+    if (!this.mod._process_copy) {
+      throw new Error('Module was not built with async input');
+    }
+
+    this.reset();
+    this.inputSource =
+      Symbol.asyncIterator in source
+        ? source[Symbol.asyncIterator]()
+        : source[Symbol.iterator]();
+    this.pendingInput = null;
+
+    let result: number;
+    try {
+      result = this.mod.ccall
+        ? await this.mod.ccall('process_copy', 'number', [], [], {
+            async: true,
+          })
+        : await this.mod._process_copy();
+    } finally {
+      this.inputSource = null;
+      this.pendingInput = null;
+    }
+
+    if (result !== 0) {
+      const status = this.getStatus();
+      throw new Error(`WASM processing failed: error=${status.errorCode}`);
+    }
+    return this.readOutput();
+  }
+
+  /**
+   * Stream output chunks to a handler as WASM yields them, instead of
+   * buffering them until readOutput(). Keeps memory bounded for results
+   * much larger than the ring.
+   */
+  setOutputHandler(handler: ((chunk: Uint8Array) => void) | null): void {
+    this.outputHandler = handler;
+  }
+
+  /**
+   * Yield-to-host callback: WASM filled the output ring mid-result.
+   * Drain it so the backend can carry on writing.
+   */
+  private onWriteReady(): number {
+    const chunk = this.drainOutput();
+    if (!chunk) {
+      return 0;
+    }
+    if (this.outputHandler) {
+      this.outputHandler(chunk);
+    } else {
+      this.pendingOutput.push(chunk);
+    }
+    return 1;
+  }
+
+  /**
+   * Read all currently available output from WASM, including anything
+   * drained while WASM was yielding to us
    */
   readOutput(): Uint8Array | null {
-    if (!this.mod._has_output()) {
-      return null;
+    const chunk = this.drainOutput();
+    if (this.pendingOutput.length === 0) {
+      return chunk;
+    }
+
+    if (chunk) {
+      this.pendingOutput.push(chunk);
+    }
+    const chunks = this.pendingOutput;
+    this.pendingOutput = [];
+    if (chunks.length === 1) {
+      return chunks[0];
     }
 
-    const length = this.mod._get_output_length();
+    let total = 0;
+    for (const c of chunks) total += c.length;
+    const data = new Uint8Array(total);
+    let offset = 0;
+    for (const c of chunks) {
+      data.set(c, offset);
+      offset += c.length;
+    }
+    return data;
+  }
+
+  /**
+   * Copy out and release whatever is in the output ring right now
+   */
+  private drainOutput(): Uint8Array | null {
+    const head = this.loadCursor(this.outputBufferPtr, this.layout.ring.head);
+    const tail = this.loadCursor(this.outputBufferPtr, this.layout.ring.tail);
+    const length = (head - tail) >>> 0;
     if (length === 0) {
       return null;
     }
 
-    // Read data from buffer (after 8-byte header)
-    const dataPtr = this.outputBufferPtr + BUFFER_HEADER_SIZE;
-    const data = this.mod.HEAPU8.slice(dataPtr, dataPtr + length);
+    const dataPtr = this.outputBufferPtr + this.layout.ring.data;
+    const pos = tail & (this.bufferSize - 1);
+    const first = Math.min(length, this.bufferSize - pos);
+    const data = new Uint8Array(length);
+
+    data.set(this.mod.HEAPU8.subarray(dataPtr + pos, dataPtr + pos + first));
+    if (first < length) {
+      data.set(
+        this.mod.HEAPU8.subarray(dataPtr, dataPtr + length - first),
+        first
+      );
+    }
 
-    // Acknowledge that we've consumed the output
-    this.mod._ack_output();
+    // Release exactly what we copied; bytes published since stay readable
+    this.storeCursor(
+      this.outputBufferPtr,
+      this.layout.ring.tail,
+      tail + length
+    );
 
     return data;
   }
 
+  /**
+   * Ring capacity reported by WASM as of the last reset()
+   */
+  getBufferSize(): number {
+    return this.bufferSize;
+  }
+
+  /**
+   * Field offsets in use, from the module's layout descriptor
+   */
+  getLayout(): CommLayout {
+    return this.layout;
+  }
+
   /**
    * Get current operation status
    */
-  getStatus(): { operation: number; errorCode: number } {
-    // Control block layout: operation (u32), error_code (i32), ...
-    const operationPtr = this.controlPtr / 4; // Convert to u32 index
-    const errorPtr = this.controlPtr / 4 + 1;
+  getStatus(): {
+    operation: number;
+    errorCode: number;
+    writeYields: number;
+    notifications: number;
+    sendCalls: number;
+    inputWaits: number;
+  } {
+    const control = this.layout.control;
+    const u32 = (offset: number) =>
+      this.mod.HEAPU32[(this.controlPtr + offset) >> 2];
 
     return {
-      operation: this.mod.HEAPU32[operationPtr],
-      errorCode: this.mod.HEAP32[errorPtr],
+      operation: u32(control.operation),
+      errorCode: this.mod.HEAP32[(this.controlPtr + control.errorCode) >> 2],
+      writeYields: u32(control.writeYields),
+      notifications: u32(control.notifications),
+      sendCalls: u32(control.sendCalls),
+      inputWaits: u32(control.inputWaits),
     };
   }
 
+  /**
+   * Set how many bytes send() may coalesce before notifying the host
+   * without waiting for a flush point. 0 notifies on every send().
+   */
+  setFlushHighWater(bytes: number): void {
+    this.mod._set_flush_high_water?.(bytes);
+  }
+
+  /**
+   * Bound the ring size WASM adapts within. min === max pins it.
+   * Applied at the next reset().
+   */
+  setBufferLimits(min: number, max: number): void {
+    this.mod._set_buffer_limits?.(min, max);
+  }
+
   /**
    * Reset all buffers for a new operation
+   * The rings may be resized here, based on the previous operation.
    */
   reset(): void {
+    this.pendingOutput = [];
     this.mod._reset_buffers();
+    this.refreshRings();
   }
 
   /**
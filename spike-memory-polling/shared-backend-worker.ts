@@ -0,0 +1,56 @@
+/**
+ * shared-backend-worker.ts
+ *
+ * Runs the backend for the SharedArrayBuffer transport on a worker_threads
+ * worker. The worker posts its ring layout once, then parks in _serve(),
+ * which only ever sleeps on futexes; every query after that goes through
+ * shared memory.
+ *
+ * Uses the TypeScript mock unless a module built with `./build.sh shared`
+ * is passed in.
+ */
+
+import { Worker, isMainThread, parentPort, workerData } from 'node:worker_threads';
+import { createMockWasmModule } from './mock-wasm.js';
+import { moduleLayout, type PollingWasmModule } from './pglite-polling.js';
+import { PGlitePollingShared, type SharedLayout } from './pglite-polling-shared.js';
+
+/**
+ * Start a backend worker and connect to it
+ * @param wasm Optional path/URL of test-polling-shared.mjs
+ */
+export async function spawnSharedBackend(
+  wasm?: string
+): Promise<{ polling: PGlitePollingShared; worker: Worker }> {
+  const worker = new Worker(new URL(import.meta.url), {
+    workerData: { sharedBackend: true, wasm },
+  });
+
+  const layout = await new Promise<SharedLayout>((resolve, reject) => {
+    worker.once('message', resolve);
+    worker.once('error', reject);
+  });
+
+  return { polling: new PGlitePollingShared(layout), worker };
+}
+
+if (!isMainThread && workerData?.sharedBackend) {
+  const mod: PollingWasmModule = workerData.wasm
+    ? await (await import(workerData.wasm)).default()
+    : createMockWasmModule({ shared: true });
+
+  mod._reset_buffers();
+
+  const layout: SharedLayout = {
+    buffer: mod.HEAPU8.buffer as SharedArrayBuffer,
+    inputBuffer: mod._get_input_buffer(),
+    outputBuffer: mod._get_output_buffer(),
+    control: mod._get_control(),
+    bufferSize: mod._get_buffer_size(),
+    fields: moduleLayout(mod),
+  };
+  parentPort!.postMessage(layout);
+
+  // Never returns: the host terminates the worker when it is done
+  mod._serve!(0);
+}
@@ -0,0 +1,257 @@
+/**
+ * stress-ring.c
+ *
+ * Native stress test for the SPSC rings in test-wasm.c.
+ * Runs the "backend" and the "host" on two threads so the ring cursors are
+ * exercised under real concurrency, which the single-threaded WASM build
+ * never does. A second, single-threaded pass checks the yield-to-host
+ * handshake that lets results larger than the ring stream through it.
+ *
+ * Built a second time with -DSHARED_MEMORY as stress-ring-shared, where the
+ * backend sleeps on futexes instead of spinning or yielding to the host.
+ *
+ * Build and run (no Emscripten required):
+ *   ./build.sh native
+ *   ./stress-ring [rows] [input-bytes]
+ *   ./stress-ring-shared [rows] [input-bytes]
+ */
+
+#define TEST_WASM_NO_MAIN
+#include "test-wasm.c"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+static volatile int g_producer_done = 0;
+
+/* ============================================================================
+ * Output direction: backend writes rows, host thread drains
+ * ============================================================================ */
+
+typedef struct {
+    int num_rows;
+    int rows_seen;
+    uint64_t bytes_seen;
+    int failed;
+    uint8_t msg[128];  // carry-over for a message split across reads
+    size_t have;
+} DrainState;
+
+/**
+ * Drain whatever is readable right now and validate every complete row.
+ * Returns the number of bytes taken out of the ring.
+ */
+static size_t drain_available(DrainState *state) {
+    Ring *ring = (Ring *)get_output_buffer();
+    size_t total = 0;
+
+    for (;;) {
+        size_t n = ring_read(ring, state->msg + state->have,
+                             sizeof(state->msg) - state->have);
+        if (n == 0 || state->failed) {
+            return total;
+        }
+        total += n;
+#ifdef SHARED_MEMORY
+        wake_u32(&ring->tail);  // the backend may be asleep on a full ring
+#endif
+        state->have += n;
+        state->bytes_seen += n;
+
+        // Consume every complete message in the local buffer
+        uint8_t *msg = state->msg;
+        size_t pos = 0;
+        while (state->have - pos >= 5) {
+            uint32_t len = ((uint32_t)msg[pos + 1] << 24) |
+                           ((uint32_t)msg[pos + 2] << 16) |
+                           ((uint32_t)msg[pos + 3] << 8) |
+                           (uint32_t)msg[pos + 4];
+            if (msg[pos] != 'D' || len < 4 || len > sizeof(state->msg) - 1) {
+                fprintf(stderr, "bad header at row %d\n", state->rows_seen);
+                state->failed = 1;
+                return total;
+            }
+            if (state->have - pos < 1 + len) {
+                break;
+            }
+
+            char expected[64];
+            int elen = snprintf(expected, sizeof(expected), "Row %d of %d\n",
+                                state->rows_seen + 1, state->num_rows);
+            if ((uint32_t)elen != len - 4 ||
+                memcmp(msg + pos + 5, expected, elen) != 0) {
+                fprintf(stderr, "row %d out of order or corrupt\n",
+                        state->rows_seen + 1);
+                state->failed = 1;
+                return total;
+            }
+            state->rows_seen++;
+            pos += 1 + len;
+        }
+        memmove(msg, msg + pos, state->have - pos);
+        state->have -= pos;
+    }
+}
+
+static int check_drained(const char *mode, int rc, DrainState *state) {
+    if (state->have != 0) {
+        fprintf(stderr, "%zu trailing bytes\n", state->have);
+        state->failed = 1;
+    }
+
+    printf("output (%s): rc=%d rows=%d/%d bytes=%llu written=%u yields=%u "
+           "sends=%u notifications=%u\n",
+           mode, rc, state->rows_seen, state->num_rows,
+           (unsigned long long)state->bytes_seen, g_control.total_written,
+           g_control.write_yields, g_control.send_calls,
+           g_control.notifications);
+
+    return rc == 0 && !state->failed && state->rows_seen == state->num_rows &&
+           state->bytes_seen == g_control.total_written;
+}
+
+/* Concurrent consumer: a second thread drains while the backend writes */
+static void *drain_output(void *arg) {
+    DrainState *state = (DrainState *)arg;
+    Ring *ring = (Ring *)get_output_buffer();
+
+    for (;;) {
+        int done = LOAD_ACQUIRE(&g_producer_done);
+        if (drain_available(state) == 0) {
+            if (state->failed || (done && ring_used(ring) == 0)) {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int stress_output(int num_rows) {
+    DrainState state = { .num_rows = num_rows };
+    pthread_t consumer;
+
+    reset_buffers();
+#ifndef SHARED_MEMORY
+    set_yield_hook(NULL);
+#endif
+    STORE_RELEASE(&g_producer_done, 0);
+    pthread_create(&consumer, NULL, drain_output, &state);
+
+    int rc = process_multi_row(num_rows);
+    STORE_RELEASE(&g_producer_done, 1);
+    pthread_join(consumer, NULL);
+
+    return check_drained("threaded", rc, &state);
+}
+
+/* Handshake consumer: single thread, the backend yields to us when full */
+#ifndef SHARED_MEMORY
+static DrainState *g_hook_state;
+
+static int drain_on_write_ready(void) {
+    return drain_available(g_hook_state) > 0;
+}
+
+static int stress_output_handshake(int num_rows) {
+    DrainState state = { .num_rows = num_rows };
+
+    reset_buffers();
+    g_hook_state = &state;
+    set_yield_hook(drain_on_write_ready);
+
+    int rc = process_multi_row(num_rows);
+    drain_available(&state);  // whatever was left after the final flush
+    set_yield_hook(NULL);
+
+    // Coalescing: one notification per high-water mark or yield, never
+    // one per send()
+    return check_drained("handshake", rc, &state) &&
+           (g_control.total_written <= BUFFER_SIZE || g_control.write_yields > 0) &&
+           g_control.notifications <=
+               g_control.total_written / FLUSH_HIGH_WATER + g_control.write_yields + 1;
+}
+#endif
+
+/* ============================================================================
+ * Input direction: host thread pushes a byte pattern, backend reads it
+ * ============================================================================ */
+
+static void *fill_input(void *arg) {
+    size_t total = *(size_t *)arg;
+    Ring *ring = (Ring *)get_input_buffer();
+    uint8_t chunk[4099];  // odd size so writes straddle the wrap point
+    size_t sent = 0;
+
+    while (sent < total) {
+        size_t len = total - sent < sizeof(chunk) ? total - sent : sizeof(chunk);
+        for (size_t i = 0; i < len; i++) {
+            chunk[i] = (uint8_t)((sent + i) * 31);
+        }
+        size_t off = 0;
+        while (off < len) {
+            size_t n = ring_write(ring, chunk + off, len - off);
+            if (n == 0) {
+                sched_yield();
+            }
+#ifdef SHARED_MEMORY
+            else {
+                wake_u32(&ring->head);  // the backend sleeps on an empty ring
+            }
+#endif
+            off += n;
+        }
+        sent += len;
+    }
+    return NULL;
+}
+
+static int stress_input(size_t total) {
+    pthread_t producer;
+    uint8_t buf[1500];
+    size_t got = 0;
+    int failed = 0;
+
+    reset_buffers();
+    pthread_create(&producer, NULL, fill_input, &total);
+
+    while (got < total) {
+        ssize_t n = internal_read(buf, sizeof(buf));
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (ssize_t i = 0; i < n && !failed; i++) {
+            if (buf[i] != (uint8_t)((got + i) * 31)) {
+                fprintf(stderr, "input mismatch at byte %zu\n", got + i);
+                failed = 1;
+            }
+        }
+        got += n;
+    }
+    pthread_join(producer, NULL);
+
+    printf("input: bytes=%zu/%zu total_read=%u\n", got, total,
+           g_control.total_read);
+    return !failed && got == total;
+}
+
+int main(int argc, char **argv) {
+    int num_rows = argc > 1 ? atoi(argv[1]) : 1000000;
+    size_t input_bytes = argc > 2 ? (size_t)atoll(argv[2]) : 64u * 1024 * 1024;
+
+    int ok_out = stress_output(num_rows);
+#ifdef SHARED_MEMORY
+    int ok_handshake = 1;  // no host callback in shared mode
+#else
+    int ok_handshake = stress_output_handshake(num_rows);
+#endif
+    int ok_in = stress_input(input_bytes);
+
+    if (ok_out && ok_handshake && ok_in) {
+        printf("PASS\n");
+        return 0;
+    }
+    printf("FAIL\n");
+    return 1;
+}
@@ -9,6 +9,7 @@
 
 import { PGlitePolling } from './pglite-polling.js';
 import MockWasmModule from './mock-wasm.js';
+import { spawnSharedBackend } from './shared-backend-worker.js';
 
 async function runTests(): Promise<void> {
   console.log('='.repeat(60));
@@ -256,6 +257,261 @@ async function runTests(): Promise<void> {
   }
   console.log('');
 
+  // Test 7: Ring wrap-around without resets
+  console.log('-'.repeat(40));
+  console.log('TEST 7: Ring Wrap-Around (no reset between messages)');
+  console.log('-'.repeat(40));
+
+  try {
+    polling.reset();
+    const iterations = 200;
+    const message = new Uint8Array(1000);
+    let mismatches = 0;
+
+    for (let i = 0; i < iterations; i++) {
+      for (let j = 0; j < message.length; j++) {
+        message[j] = 97 + ((i + j) % 26); // a-z pattern shifted per message
+      }
+      polling.writeInput(message);
+      mod._process_message();
+      const out = polling.readOutput();
+      const payload = out ? polling.parseMessage(out).payload : new Uint8Array(0);
+      const expected = message.map((b) => b - 32);
+      if (payload.length !== expected.length || payload.some((b, k) => b !== expected[k])) {
+        mismatches++;
+      }
+    }
+
+    const totalBytes = iterations * message.length;
+    console.log(`Round-trips: ${iterations}, bytes through input ring: ${totalBytes}`);
+
+    if (mismatches === 0 && totalBytes > polling.getBufferSize()) {
+      console.log('PASS: Data intact across ring wrap-around');
+      passed++;
+    } else {
+      console.log(`FAIL: ${mismatches} corrupted round-trips`);
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
+  // Test 8: Result far larger than the output ring
+  console.log('-'.repeat(40));
+  console.log('TEST 8: Streaming Past the Output Ring (yield to host)');
+  console.log('-'.repeat(40));
+
+  try {
+    polling.reset();
+    const numRows = 1_200_000;
+    let streamedBytes = 0;
+    let rowsSeen = 0;
+    let carry = new Uint8Array(0);
+
+    // Count DataRow messages as they stream out; nothing is retained
+    polling.setOutputHandler((chunk) => {
+      streamedBytes += chunk.length;
+      const buf = new Uint8Array(carry.length + chunk.length);
+      buf.set(carry);
+      buf.set(chunk, carry.length);
+      let pos = 0;
+      while (buf.length - pos >= 5) {
+        const len = (buf[pos + 1] << 24) | (buf[pos + 2] << 16) | (buf[pos + 3] << 8) | buf[pos + 4];
+        if (buf.length - pos < 1 + len) break;
+        rowsSeen++;
+        pos += 1 + len;
+      }
+      carry = buf.slice(pos);
+    });
+
+    const result = mod._process_multi_row!(numRows);
+    const tail = polling.readOutput();
+    polling.setOutputHandler(null);
+    if (tail) {
+      streamedBytes += tail.length;
+      const buf = new Uint8Array(carry.length + tail.length);
+      buf.set(carry);
+      buf.set(tail, carry.length);
+      for (let pos = 0; buf.length - pos >= 5; rowsSeen++) {
+        pos += 1 + ((buf[pos + 1] << 24) | (buf[pos + 2] << 16) | (buf[pos + 3] << 8) | buf[pos + 4]);
+      }
+    }
+
+    const status = polling.getStatus();
+    console.log(`Rows: ${rowsSeen}/${numRows}, bytes: ${streamedBytes}, yields: ${status.writeYields}`);
+
+    if (result === 0 && rowsSeen === numRows && status.writeYields > 0) {
+      console.log('PASS: Oversized result streamed through the ring');
+      passed++;
+    } else {
+      console.log(`FAIL: result=${result}`);
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
+  // Test 9: send() coalescing
+  console.log('-'.repeat(40));
+  console.log('TEST 9: Coalesced Host Notifications');
+  console.log('-'.repeat(40));
+
+  try {
+    const rows = 1000;
+
+    polling.reset();
+    mod._process_multi_row!(rows);
+    polling.readOutput();
+    const coalesced = polling.getStatus();
+
+    // High-water mark 0 restores the old notify-per-send behaviour
+    polling.setFlushHighWater(0);
+    polling.reset();
+    mod._process_multi_row!(rows);
+    polling.readOutput();
+    const perSend = polling.getStatus();
+    polling.setFlushHighWater(polling.getBufferSize() / 2);
+
+    console.log(`send() calls: ${coalesced.sendCalls}`);
+    console.log(`Notifications (coalesced): ${coalesced.notifications}`);
+    console.log(`Notifications (per send):  ${perSend.notifications}`);
+
+    if (coalesced.sendCalls === 2 * rows && coalesced.notifications === 1 && perSend.notifications === 2 * rows) {
+      console.log('PASS: One notification per round trip');
+      passed++;
+    } else {
+      console.log('FAIL: Notifications not coalesced');
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
+  // Test 10: SharedArrayBuffer transport with the backend in a worker
+  console.log('-'.repeat(40));
+  console.log('TEST 10: Shared Memory Worker Round Trips');
+  console.log('-'.repeat(40));
+
+  try {
+    const { polling: shared, worker } = await spawnSharedBackend();
+    const encoder = new TextEncoder();
+    const decoder = new TextDecoder();
+    const queries = 100;
+    let mismatches = 0;
+
+    try {
+      for (let i = 0; i < queries; i++) {
+        const text = `select ${i} from worker`;
+        const out = await shared.exec(encoder.encode(text));
+        const payload = decoder.decode(out.subarray(5, out.length - 6));
+        if (payload !== text.toUpperCase()) {
+          mismatches++;
+        }
+      }
+    } finally {
+      await worker.terminate();
+    }
+
+    const status = shared.getStatus();
+    console.log(`Round trips: ${queries}, notifications: ${status.notifications}`);
+
+    if (mismatches === 0 && status.notifications === queries) {
+      console.log('PASS: Queries answered across threads via Atomics');
+      passed++;
+    } else {
+      console.log(`FAIL: ${mismatches} mismatched responses`);
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
+  // Test 11: streaming input into a suspended backend call
+  console.log('-'.repeat(40));
+  console.log('TEST 11: Async Input Streaming (COPY FROM)');
+  console.log('-'.repeat(40));
+
+  try {
+    const total = 1024 * 1024 + 17;
+    const chunkSizes = [1, 777, 4096, 65536 + 3, 12345];
+    let expectedHash = 2166136261;
+
+    // Odd-sized chunks, one per turn of the event loop, like a network read
+    async function* source(): AsyncGenerator<Uint8Array> {
+      let sent = 0;
+      for (let i = 0; sent < total; i++) {
+        const size = Math.min(chunkSizes[i % chunkSizes.length], total - sent);
+        const chunk = new Uint8Array(size);
+        for (let j = 0; j < size; j++) {
+          chunk[j] = (sent + j) % 251;
+          expectedHash = Math.imul(expectedHash ^ chunk[j], 16777619) >>> 0;
+        }
+        sent += size;
+        await new Promise((resolve) => setImmediate(resolve));
+        yield chunk;
+      }
+    }
+
+    const out = await polling.copyFrom(source());
+    const text = new TextDecoder().decode(out!.subarray(5, out!.length - 7));
+    const expected = `COPY ${total} ${expectedHash.toString(16).padStart(8, '0')}`;
+    const status = polling.getStatus();
+
+    console.log(`Result: ${text}`);
+    console.log(`Input waits: ${status.inputWaits}`);
+
+    if (text === expected && status.inputWaits > total / polling.getBufferSize()) {
+      console.log('PASS: Input streamed through the ring without buffering');
+      passed++;
+    } else {
+      console.log(`FAIL: Expected ${expected}`);
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
+  // Test 12: Layout descriptor
+  console.log('-'.repeat(40));
+  console.log('TEST 12: Control Block Layout Descriptor');
+  console.log('-'.repeat(40));
+
+  try {
+    polling.reset();
+    const layout = polling.getLayout();
+    const { control } = layout;
+    const line = (offset: number) => offset >> 6;
+    console.log(`Version ${layout.version}, control block ${control.size} bytes`);
+
+    if (
+      layout.version === 2 &&
+      control.size % 64 === 0 &&
+      line(control.notifications) === line(control.operation) &&
+      line(control.notifications) !== line(control.totalWritten) &&
+      polling.getStatus().notifications === 0
+    ) {
+      console.log('PASS: Host-watched fields are off the counters line');
+      passed++;
+    } else {
+      console.log('FAIL: Unexpected layout');
+      failed++;
+    }
+  } catch (e) {
+    console.log(`FAIL: Exception - ${e}`);
+    failed++;
+  }
+  console.log('');
+
   // Summary
   console.log('='.repeat(60));
   console.log('TEST SUMMARY');
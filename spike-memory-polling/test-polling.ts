@@ -210,6 +210,119 @@ async function runTests(): Promise<void> {
   }
   console.log('');
 
+  // Test 6: Ring wrap-around without resets
+  console.log('-'.repeat(40));
+  console.log('TEST 6: Ring Wrap-Around (no reset between messages)');
+  console.log('-'.repeat(40));
+
+  polling.reset();
+  const iterations = 200;
+  const message = new Uint8Array(1000);
+  let mismatches = 0;
+
+  for (let i = 0; i < iterations; i++) {
+    for (let j = 0; j < message.length; j++) {
+      message[j] = 97 + ((i + j) % 26); // a-z pattern shifted per message
+    }
+    polling.writeInput(message);
+    mod._process_message();
+    const out = polling.readOutput();
+    const payload = out ? polling.parseMessage(out).payload : new Uint8Array(0);
+    const expected = message.map((b) => b - 32);
+    if (payload.length !== expected.length || payload.some((b, k) => b !== expected[k])) {
+      mismatches++;
+    }
+  }
+
+  console.log(`Round-trips: ${iterations}, bytes through input ring: ${iterations * message.length}`);
+  if (mismatches === 0) {
+    console.log('PASS: Data intact across ring wrap-around');
+  } else {
+    console.log(`FAIL: ${mismatches} corrupted round-trips`);
+  }
+  console.log('');
+
+  // Test 7: Result far larger than the output ring
+  console.log('-'.repeat(40));
+  console.log('TEST 7: Streaming Past the Output Ring (yield to host)');
+  console.log('-'.repeat(40));
+
+  polling.reset();
+  const numRows = 1_200_000;
+  let streamedBytes = 0;
+  let rowsSeen = 0;
+  let carry = new Uint8Array(0);
+
+  // Count DataRow messages as they stream out; nothing is retained
+  polling.setOutputHandler((chunk) => {
+    streamedBytes += chunk.length;
+    const buf = new Uint8Array(carry.length + chunk.length);
+    buf.set(carry);
+    buf.set(chunk, carry.length);
+    let pos = 0;
+    while (buf.length - pos >= 5) {
+      const len = (buf[pos + 1] << 24) | (buf[pos + 2] << 16) | (buf[pos + 3] << 8) | buf[pos + 4];
+      if (buf.length - pos < 1 + len) break;
+      rowsSeen++;
+      pos += 1 + len;
+    }
+    carry = buf.slice(pos);
+  });
+
+  const result = mod._process_multi_row!(numRows);
+  const tail = polling.readOutput();
+  polling.setOutputHandler(null);
+  if (tail) {
+    streamedBytes += tail.length;
+    const buf = new Uint8Array(carry.length + tail.length);
+    buf.set(carry);
+    buf.set(tail, carry.length);
+    for (let pos = 0; buf.length - pos >= 5; rowsSeen++) {
+      pos += 1 + ((buf[pos + 1] << 24) | (buf[pos + 2] << 16) | (buf[pos + 3] << 8) | buf[pos + 4]);
+    }
+  }
+
+  const status = polling.getStatus();
+  console.log(`Rows: ${rowsSeen}/${numRows}, bytes: ${streamedBytes}, yields: ${status.writeYields}`);
+
+  if (result === 0 && rowsSeen === numRows && status.writeYields > 0) {
+    console.log('PASS: Oversized result streamed through the ring');
+  } else {
+    console.log(`FAIL: result=${result}`);
+  }
+  console.log('');
+
+  // Test 8: send() coalescing
+  console.log('-'.repeat(40));
+  console.log('TEST 8: Coalesced Host Notifications');
+  console.log('-'.repeat(40));
+
+  const rows = 1000;
+
+  polling.reset();
+  mod._process_multi_row!(rows);
+  polling.readOutput();
+  const coalesced = polling.getStatus();
+
+  // High-water mark 0 restores the old notify-per-send behaviour
+  polling.setFlushHighWater(0);
+  polling.reset();
+  mod._process_multi_row!(rows);
+  polling.readOutput();
+  const perSend = polling.getStatus();
+  polling.setFlushHighWater(polling.getBufferSize() / 2);
+
+  console.log(`send() calls: ${coalesced.sendCalls}`);
+  console.log(`Notifications (coalesced): ${coalesced.notifications}`);
+  console.log(`Notifications (per send):  ${perSend.notifications}`);
+
+  if (coalesced.sendCalls === 2 * rows && coalesced.notifications === 1 && perSend.notifications === 2 * rows) {
+    console.log('PASS: One notification per round trip');
+  } else {
+    console.log('FAIL: Notifications not coalesced');
+  }
+  console.log('');
+
   // Summary
   console.log('='.repeat(60));
   console.log('TEST SUMMARY');
@@ -9,32 +9,79 @@
  *     -sEXPORTED_RUNTIME_METHODS=HEAPU8,HEAPU32,HEAP32 \
  *     -sNO_EXIT_RUNTIME=1 -sMODULARIZE=1 -sEXPORT_ES6=1 \
  *     -sEXPORT_NAME=TestModule
+ *
+ * Add -DSHARED_MEMORY -sSHARED_MEMORY=1 for the worker build that mirrors
+ * PGLITE_POLLING_SHARED (see ./build.sh shared), or -DASYNC_INPUT -sJSPI
+ * (or -sASYNCIFY) for the suspending recv() of PGLITE_POLLING_ASYNC
+ * (see ./build.sh async).
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#include <emscripten/em_js.h>
 #define EXPORT_NAME(name) __attribute__((export_name(#name)))
 #define KEEPALIVE EMSCRIPTEN_KEEPALIVE
 #else
+#include <sched.h>
 #define EXPORT_NAME(name)
 #define KEEPALIVE
 #endif
 
+#if defined(ASYNC_INPUT) && defined(SHARED_MEMORY)
+#error "ASYNC_INPUT and SHARED_MEMORY are mutually exclusive"
+#endif
+
+#ifdef SHARED_MEMORY
+#include <limits.h>
+#include <stdatomic.h>
+#ifdef __EMSCRIPTEN__
+#include <math.h>
+#include <emscripten/threading.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
 /* ============================================================================
  * Shared Memory Structures (matching pglite-comm-polling.h)
  * ============================================================================ */
 
-#define BUFFER_SIZE (64 * 1024)
+#ifndef BUFFER_SIZE
+#define BUFFER_SIZE (64 * 1024)  // per ring, must be a power of two
+#endif
+#define CACHE_LINE_SIZE 64
 
-typedef enum {
-    BUFFER_EMPTY = 0,
-    BUFFER_READY = 1,
-    BUFFER_PROCESSING = 2
-} BufferStatus;
+#if (BUFFER_SIZE & (BUFFER_SIZE - 1)) != 0
+#error "BUFFER_SIZE must be a power of two"
+#endif
+
+#ifndef RING_SPIN_LIMIT
+#define RING_SPIN_LIMIT (1 << 20)
+#endif
+
+#ifndef FLUSH_HIGH_WATER
+#define FLUSH_HIGH_WATER (BUFFER_SIZE / 2)
+#endif
+
+#ifdef SHARED_MEMORY
+typedef _Atomic uint32_t u32_t;
+typedef _Atomic int32_t i32_t;
+#define LOAD_ACQUIRE(p) atomic_load_explicit((p), memory_order_acquire)
+#define STORE_RELEASE(p, v) atomic_store_explicit((p), (v), memory_order_release)
+#else
+typedef volatile uint32_t u32_t;
+typedef volatile int32_t i32_t;
+#define LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
 
 typedef enum {
     OP_NONE = 0,
@@ -44,25 +91,143 @@ typedef enum {
     OP_ERROR = 4
 } OperationType;
 
+/* SPSC ring: head @0, tail @64, capacity @128, mask @132, data @192 */
 typedef struct {
-    volatile uint32_t status;
-    volatile uint32_t length;
+    u32_t head;
+    uint8_t _pad_head[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    u32_t tail;
+    uint8_t _pad_tail[CACHE_LINE_SIZE - sizeof(uint32_t)];
+    uint32_t capacity;
+    uint32_t mask;
+    uint8_t _pad_meta[CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
     uint8_t data[BUFFER_SIZE];
-} __attribute__((packed)) Buffer;
+} __attribute__((aligned(CACHE_LINE_SIZE))) Ring;
+
+/* Control block: host-watched state on line 0, backend counters on line 1 */
+typedef struct {
+    u32_t operation;
+    i32_t error_code;
+    u32_t notifications;
+    uint8_t _pad_state[CACHE_LINE_SIZE - 3 * sizeof(uint32_t)];
+    u32_t read_offset;
+    u32_t total_read;
+    u32_t total_written;
+    u32_t write_yields;
+    u32_t send_calls;
+    u32_t input_waits;
+    uint8_t _pad_counters[CACHE_LINE_SIZE - 6 * sizeof(uint32_t)];
+} __attribute__((aligned(CACHE_LINE_SIZE))) Control;
+
+/* Layout descriptor, field for field the same as PGliteLayout */
+#define LAYOUT_MAGIC 0x50474C43u
+#define LAYOUT_VERSION 2
 
 typedef struct {
-    volatile uint32_t operation;
-    volatile int32_t error_code;
-    volatile uint32_t read_offset;
-    volatile uint32_t total_read;
-    volatile uint32_t total_written;
-} __attribute__((packed)) Control;
+    uint32_t magic, version, size;
+    uint32_t ring_head, ring_tail, ring_capacity, ring_mask, ring_data;
+    uint32_t control_size, control_operation, control_error_code,
+        control_notifications, control_read_offset, control_total_read,
+        control_total_written, control_write_yields, control_send_calls,
+        control_input_waits;
+} Layout;
+
+static const Layout g_layout = {
+    LAYOUT_MAGIC, LAYOUT_VERSION, sizeof(Layout),
+    offsetof(Ring, head), offsetof(Ring, tail), offsetof(Ring, capacity),
+    offsetof(Ring, mask), offsetof(Ring, data),
+    sizeof(Control), offsetof(Control, operation),
+    offsetof(Control, error_code), offsetof(Control, notifications),
+    offsetof(Control, read_offset), offsetof(Control, total_read),
+    offsetof(Control, total_written), offsetof(Control, write_yields),
+    offsetof(Control, send_calls), offsetof(Control, input_waits),
+};
 
 /* Global shared memory */
-static Buffer g_input;
-static Buffer g_output;
+static Ring g_input;
+static Ring g_output;
 static Control g_control;
 
+/* Coalescing state (see pglite-comm-polling.h) */
+static uint32_t g_notified_written = 0;
+static uint32_t g_flush_high_water = FLUSH_HIGH_WATER;
+
+/* ============================================================================
+ * Ring Primitives
+ * ============================================================================ */
+
+static void ring_reset(Ring *ring) {
+    ring->capacity = BUFFER_SIZE;
+    ring->mask = BUFFER_SIZE - 1;
+    STORE_RELEASE(&ring->tail, 0);
+    STORE_RELEASE(&ring->head, 0);
+}
+
+static uint32_t ring_used(Ring *ring) {
+    return LOAD_ACQUIRE(&ring->head) - LOAD_ACQUIRE(&ring->tail);
+}
+
+static size_t ring_write(Ring *ring, const void *src, size_t len) {
+    uint32_t head = ring->head;
+    size_t space = BUFFER_SIZE - (head - LOAD_ACQUIRE(&ring->tail));
+    size_t n = len < space ? len : space;
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t pos = head & (BUFFER_SIZE - 1);
+    size_t first = BUFFER_SIZE - pos < n ? BUFFER_SIZE - pos : n;
+    memcpy(ring->data + pos, src, first);
+    memcpy(ring->data, (const uint8_t *)src + first, n - first);
+
+    STORE_RELEASE(&ring->head, head + (uint32_t)n);
+    return n;
+}
+
+static size_t ring_read(Ring *ring, void *dst, size_t max_len) {
+    uint32_t tail = ring->tail;
+    size_t available = LOAD_ACQUIRE(&ring->head) - tail;
+    size_t n = max_len < available ? max_len : available;
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t pos = tail & (BUFFER_SIZE - 1);
+    size_t first = BUFFER_SIZE - pos < n ? BUFFER_SIZE - pos : n;
+    memcpy(dst, ring->data + pos, first);
+    memcpy((uint8_t *)dst + first, ring->data, n - first);
+
+    STORE_RELEASE(&ring->tail, tail + (uint32_t)n);
+    return n;
+}
+
+/* ============================================================================
+ * Shared-memory Wait/Wake (SHARED_MEMORY only)
+ * ============================================================================ */
+
+#ifdef SHARED_MEMORY
+static void wait_u32(u32_t *addr, uint32_t expected) {
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wait((void *)addr, expected, INFINITY);
+#elif defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, NULL, NULL, 0);
+#else
+    (void)addr;
+    (void)expected;
+    sched_yield();
+#endif
+}
+
+static void wake_u32(u32_t *addr) {
+#ifdef __EMSCRIPTEN__
+    emscripten_futex_wake((void *)addr, INT_MAX);
+#elif defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+#endif
+
 /* ============================================================================
  * Exported Accessors
  * ============================================================================ */
@@ -76,6 +241,9 @@ void* KEEPALIVE get_output_buffer(void) { return &g_output; }
 EXPORT_NAME(get_control)
 void* KEEPALIVE get_control(void) { return &g_control; }
 
+EXPORT_NAME(get_layout)
+const void* KEEPALIVE get_layout(void) { return &g_layout; }
+
 EXPORT_NAME(get_buffer_size)
 uint32_t KEEPALIVE get_buffer_size(void) { return BUFFER_SIZE; }
 
@@ -85,86 +253,207 @@ uint32_t KEEPALIVE get_buffer_size(void) { return BUFFER_SIZE; }
 
 EXPORT_NAME(reset_buffers)
 void KEEPALIVE reset_buffers(void) {
-    g_input.status = BUFFER_EMPTY;
-    g_input.length = 0;
-    g_output.status = BUFFER_EMPTY;
-    g_output.length = 0;
+    ring_reset(&g_input);
+    ring_reset(&g_output);
     g_control.operation = OP_NONE;
     g_control.error_code = 0;
     g_control.read_offset = 0;
     g_control.total_read = 0;
     g_control.total_written = 0;
+    g_control.write_yields = 0;
+    g_control.notifications = 0;
+    g_control.send_calls = 0;
+    g_control.input_waits = 0;
+    g_notified_written = 0;
+}
+
+EXPORT_NAME(set_flush_high_water)
+void KEEPALIVE set_flush_high_water(uint32_t bytes) {
+    g_flush_high_water = bytes;
 }
 
 EXPORT_NAME(signal_input_ready)
 void KEEPALIVE signal_input_ready(uint32_t length) {
-    g_input.length = length;
-    g_input.status = BUFFER_READY;
     g_control.read_offset = 0;
+    STORE_RELEASE(&g_input.head, g_input.head + length);
 }
 
 EXPORT_NAME(has_output)
 int KEEPALIVE has_output(void) {
-    return g_output.status == BUFFER_READY ? 1 : 0;
+    return ring_used(&g_output) > 0 ? 1 : 0;
 }
 
 EXPORT_NAME(get_output_length)
 uint32_t KEEPALIVE get_output_length(void) {
-    return g_output.length;
+    return ring_used(&g_output);
+}
+
+EXPORT_NAME(consume_output)
+void KEEPALIVE consume_output(uint32_t length) {
+    STORE_RELEASE(&g_output.tail, g_output.tail + length);
 }
 
 EXPORT_NAME(ack_output)
 void KEEPALIVE ack_output(void) {
-    g_output.status = BUFFER_EMPTY;
-    g_output.length = 0;
+    STORE_RELEASE(&g_output.tail, LOAD_ACQUIRE(&g_output.head));
 }
 
 /* ============================================================================
  * Internal Read/Write (simulating PostgreSQL's recv/send)
  * ============================================================================ */
 
+/* Yield-to-host handshake (see pglite-comm-polling.h) */
+#if defined(SHARED_MEMORY)
+// The writer sleeps on the output tail instead
+#elif defined(__EMSCRIPTEN__)
+EM_JS(int, yield_to_host, (void), {
+    var onWriteReady = Module._pglitePollingOnWriteReady;
+    return onWriteReady ? (onWriteReady() | 0) : 0;
+});
+#else
+typedef int (*yield_hook_t)(void);
+static yield_hook_t g_yield_hook = NULL;
+
+static inline void set_yield_hook(yield_hook_t hook) { g_yield_hook = hook; }
+
+static int yield_to_host(void) { return g_yield_hook ? g_yield_hook() : 0; }
+#endif
+
+/* Async input (see pglite-comm-polling.h) */
+#ifdef ASYNC_INPUT
+#ifdef __EMSCRIPTEN__
+EM_ASYNC_JS(int, wait_input, (void), {
+    var onInputNeeded = Module._pglitePollingOnInputNeeded;
+    return onInputNeeded ? ((await onInputNeeded()) | 0) : 0;
+});
+#else
+typedef int (*input_hook_t)(void);
+static input_hook_t g_input_hook = NULL;
+
+static inline void set_input_hook(input_hook_t hook) { g_input_hook = hook; }
+
+static int wait_input(void) { return g_input_hook ? g_input_hook() : 0; }
+#endif
+#endif
+
+static void notify_host(void) {
+    g_control.operation = OP_WRITE_READY;
+    g_notified_written = g_control.total_written;
+    g_control.notifications++;
+#ifdef SHARED_MEMORY
+    wake_u32(&g_control.notifications);
+#endif
+}
+
+static int wait_output_space(void) {
+    notify_host();
+    g_control.write_yields++;
+
+#ifdef SHARED_MEMORY
+    for (;;) {
+        uint32_t tail = LOAD_ACQUIRE(&g_output.tail);
+        if (g_output.head - tail < BUFFER_SIZE) {
+            return 1;
+        }
+        wait_u32(&g_output.tail, tail);
+    }
+#else
+    yield_to_host();
+
+    if (ring_used(&g_output) < BUFFER_SIZE) {
+        return 1;
+    }
+#ifndef __EMSCRIPTEN__
+    for (int i = 0; i < RING_SPIN_LIMIT; i++) {
+        if (ring_used(&g_output) < BUFFER_SIZE) {
+            return 1;
+        }
+        sched_yield();
+    }
+#endif
+    return 0;
+#endif
+}
+
 static ssize_t internal_read(void *buf, size_t max_len) {
-    if (g_input.status != BUFFER_READY) {
-        return 0;
+    size_t to_read = ring_read(&g_input, buf, max_len);
+
+#ifdef SHARED_MEMORY
+    while (to_read == 0) {
+        uint32_t head = LOAD_ACQUIRE(&g_input.head);
+        if (head == g_input.tail) {
+            g_control.operation = OP_READ_REQUEST;
+            wait_u32(&g_input.head, head);
+        }
+        to_read = ring_read(&g_input, buf, max_len);
     }
+    wake_u32(&g_input.tail);
+#elif defined(ASYNC_INPUT)
+    while (to_read == 0) {
+        g_control.operation = OP_READ_REQUEST;
+        g_control.input_waits++;
+        if (!wait_input()) {
+            break;
+        }
+        to_read = ring_read(&g_input, buf, max_len);
+    }
+#endif
 
-    size_t available = g_input.length - g_control.read_offset;
-    if (available == 0) {
-        g_input.status = BUFFER_EMPTY;
+    if (to_read == 0) {
         return 0;
     }
 
-    size_t to_read = (max_len < available) ? max_len : available;
-    memcpy(buf, g_input.data + g_control.read_offset, to_read);
     g_control.read_offset += to_read;
     g_control.total_read += to_read;
 
-    if (g_control.read_offset >= g_input.length) {
-        g_input.status = BUFFER_EMPTY;
-    }
-
     return (ssize_t)to_read;
 }
 
 static ssize_t internal_write(const void *buf, size_t len) {
-    if (g_output.length + len > BUFFER_SIZE) {
-        g_output.status = BUFFER_READY;
-        g_control.operation = OP_WRITE_READY;
-        return -1;
+    size_t written = 0;
+
+    while (written < len) {
+        written += ring_write(&g_output, (const uint8_t *)buf + written,
+                              len - written);
+        if (written == len) {
+            break;
+        }
+        if (!wait_output_space()) {
+            break;
+        }
     }
 
-    memcpy(g_output.data + g_output.length, buf, len);
-    g_output.length += len;
-    g_control.total_written += len;
+    g_control.total_written += written;
 
-    return (ssize_t)len;
+    // Partial messages would corrupt the stream for these tests
+    return written == len ? (ssize_t)len : -1;
 }
 
 static void internal_flush(void) {
-    if (g_output.length > 0) {
-        g_output.status = BUFFER_READY;
-        g_control.operation = OP_WRITE_READY;
+    if (g_control.total_written != g_notified_written &&
+        ring_used(&g_output) > 0) {
+        notify_host();
+    }
+}
+
+static int is_flush_point(const void *buf, size_t len) {
+    if (len < 6) {
+        return 0;
+    }
+    const uint8_t *p = (const uint8_t *)buf + len - 6;
+    return p[0] == 'Z' && p[1] == 0 && p[2] == 0 && p[3] == 0 && p[4] == 5;
+}
+
+/* Coalesced send(): notify only at flush points or past the high-water mark */
+static ssize_t internal_send(const void *buf, size_t len) {
+    g_control.send_calls++;
+    ssize_t result = internal_write(buf, len);
+
+    if (is_flush_point(buf, len) ||
+        g_control.total_written - g_notified_written >= g_flush_high_water) {
+        internal_flush();
     }
+    return result;
 }
 
 /* ============================================================================
@@ -175,8 +464,7 @@ static void internal_flush(void) {
  * 3. Write output (result)
  * ============================================================================ */
 
-EXPORT_NAME(process_message)
-int KEEPALIVE process_message(void) {
+static int echo_message(void) {
     uint8_t local_buffer[1024];
     ssize_t bytes_read;
 
@@ -207,8 +495,16 @@ int KEEPALIVE process_message(void) {
     header[3] = (len >> 8) & 0xFF;
     header[4] = len & 0xFF;
 
-    internal_write(header, 5);
-    internal_write(local_buffer, bytes_read);
+    internal_send(header, 5);
+    internal_send(local_buffer, bytes_read);
+    return 0;
+}
+
+EXPORT_NAME(process_message)
+int KEEPALIVE process_message(void) {
+    if (echo_message() < 0) {
+        return -1;
+    }
 
     // Flush output
     internal_flush();
@@ -217,6 +513,40 @@ int KEEPALIVE process_message(void) {
     return 0;
 }
 
+/* ============================================================================
+ * Test Function: Full round trip
+ * Like process_message, but ends with a real ReadyForQuery so the flush
+ * happens at the protocol boundary, as it would in PostgreSQL.
+ * ============================================================================ */
+
+EXPORT_NAME(process_query)
+int KEEPALIVE process_query(void) {
+    static const uint8_t ready_for_query[6] = { 'Z', 0, 0, 0, 5, 'I' };
+
+    if (echo_message() < 0) {
+        return -1;
+    }
+
+    g_control.operation = OP_COMPLETED;
+    internal_send(ready_for_query, sizeof(ready_for_query));
+    return 0;
+}
+
+/**
+ * Backend loop for the worker build: answer max_queries queries (0 = until
+ * the worker is terminated). Only useful with SHARED_MEMORY, where
+ * internal_read() sleeps until the host publishes input.
+ */
+EXPORT_NAME(serve)
+int KEEPALIVE serve(int max_queries) {
+    for (int i = 0; max_queries == 0 || i < max_queries; i++) {
+        if (process_query() < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /* ============================================================================
  * Test Function: Multiple write chunks
  * Simulates PostgreSQL sending multiple result rows
@@ -237,13 +567,13 @@ int KEEPALIVE process_multi_row(int num_rows) {
         header[3] = (msg_len >> 8) & 0xFF;
         header[4] = msg_len & 0xFF;
 
-        if (internal_write(header, 5) < 0) {
+        if (internal_send(header, 5) < 0) {
             g_control.error_code = -2;
             g_control.operation = OP_ERROR;
             return -1;
         }
 
-        if (internal_write(row_data, len) < 0) {
+        if (internal_send(row_data, len) < 0) {
             g_control.error_code = -3;
             g_control.operation = OP_ERROR;
             return -1;
@@ -257,10 +587,55 @@ int KEEPALIVE process_multi_row(int num_rows) {
     return 0;
 }
 
+/* ============================================================================
+ * Test Function: COPY FROM STDIN
+ * Reads until the end of the input and answers with CommandComplete
+ * "COPY <bytes> <fnv1a>" and ReadyForQuery, so the host can check every
+ * byte arrived. Only streams more than one ring's worth with ASYNC_INPUT,
+ * where internal_read() suspends until the host refills the ring.
+ * ============================================================================ */
+
+EXPORT_NAME(process_copy)
+int KEEPALIVE process_copy(void) {
+    static const uint8_t ready_for_query[6] = { 'Z', 0, 0, 0, 5, 'I' };
+    uint8_t chunk[8192];  // pqcomm's PQ_RECV_BUFFER_SIZE
+    uint64_t bytes = 0;
+    uint32_t hash = 2166136261u;
+    ssize_t n;
+
+    while ((n = internal_read(chunk, sizeof(chunk))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            hash = (hash ^ chunk[i]) * 16777619u;
+        }
+        bytes += (uint64_t)n;
+    }
+
+    uint8_t msg[64];
+    int len = snprintf((char *)msg + 5, sizeof(msg) - 5, "COPY %llu %08x",
+                       (unsigned long long)bytes, hash);
+    uint32_t msg_len = (uint32_t)len + 1 + 4;  // text, NUL, length itself
+    msg[0] = 'C';
+    msg[1] = (msg_len >> 24) & 0xFF;
+    msg[2] = (msg_len >> 16) & 0xFF;
+    msg[3] = (msg_len >> 8) & 0xFF;
+    msg[4] = msg_len & 0xFF;
+
+    if (internal_send(msg, 1 + msg_len) < 0) {
+        g_control.error_code = -2;
+        g_control.operation = OP_ERROR;
+        return -1;
+    }
+    g_control.operation = OP_COMPLETED;
+    internal_send(ready_for_query, sizeof(ready_for_query));
+    return 0;
+}
+
 /* ============================================================================
  * Main (required for Emscripten)
+ * Native harnesses that #include this file define TEST_WASM_NO_MAIN.
  * ============================================================================ */
 
+#ifndef TEST_WASM_NO_MAIN
 int main(void) {
     reset_buffers();
     printf("Test WASM module initialized\n");
@@ -269,3 +644,4 @@ int main(void) {
     printf("Control block at: %p\n", &g_control);
     return 0;
 }
+#endif
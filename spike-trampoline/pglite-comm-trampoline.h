@@ -11,23 +11,56 @@
  * 1. Remove pglite_read/pglite_write function pointers
  * 2. Remove set_read_write_cbs function
  * 3. Use EM_JS trampolines that call Module._pgliteCallbacks directly
+ * 4. Optional output arena: send() appends into a JS-registered region of
+ *    WASM memory that JS parses in place after _interactive_one returns
+ * 5. Optional per-query comm stats (-DPGLITE_COMM_STATS)
+ * 6. Optional batched output (-DPGLITE_COMM_BATCHED): send() stages bytes in
+ *    WASM memory and JS gets one writeBatch call per flush, carrying whole
+ *    messages and a frame table
+ * 7. Optional DataRow column index (-DPGLITE_COMM_COLUMN_INDEX, needs
+ *    PGLITE_COMM_BATCHED): each batch also locates every DataRow field, so
+ *    JS can decode columns on demand without walking the row
  *
  * Usage:
  * 1. Copy this file to postgres-pglite/pglite/includes/pglite-comm.h
  * 2. Rebuild postgres-pglite
  * 3. Use pglite-trampoline.ts instead of addFunction in pglite.ts
+ *
+ * Also usable as a transport behind poc/comm/pglite-comm.h: with
+ * PGLITE_COMM_TRANSPORT_ONLY defined only pglite_trampoline_recv/send are
+ * provided, and the socket overrides and stubs come from the unified header.
+ * PGLITE_COMM_NATIVE builds that mode without Emscripten; the host then
+ * defines pglite_read_trampoline / pglite_write_trampoline in C.
  */
 
-#if defined(__EMSCRIPTEN__)
+#if defined(__EMSCRIPTEN__) || defined(PGLITE_COMM_NATIVE)
 
-#ifndef PGLITE_COMM_H
-#define PGLITE_COMM_H
+#ifndef PGLITE_COMM_TRAMPOLINE_H
+#define PGLITE_COMM_TRAMPOLINE_H
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
 #include <emscripten/em_js.h>
+#else
+#include <time.h>
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifndef PGLITE_EXPORT
+#ifdef __EMSCRIPTEN__
+#define PGLITE_EXPORT(name) __attribute__((export_name(#name)))
+#else
+#define PGLITE_EXPORT(name)
+#endif
+#endif
 
+#ifndef PGLITE_COMM_TRANSPORT_ONLY
 volatile int querylen = 0;
 volatile FILE* queryfp = NULL;
+#endif
 
 /*
  * ============================================================================
@@ -37,7 +70,8 @@ volatile FILE* queryfp = NULL;
  * Instead of using function pointers (which require addFunction for JS callbacks),
  * we use EM_JS to directly invoke JavaScript functions stored in Module._pgliteCallbacks.
  *
- * The JavaScript side sets up callbacks like this:
+ * The JavaScript side sets up callbacks like this, then calls
+ * _pglite_init_callbacks():
  *
  *   Module._pgliteCallbacks = {
  *     read: (ptr, maxLength) => {
@@ -47,76 +81,738 @@ volatile FILE* queryfp = NULL;
  *     write: (ptr, length) => {
  *       // Read data from WASM memory at ptr
  *       // Return number of bytes processed
+ *     },
+ *     // PGLITE_COMM_BATCHED builds call this instead of write
+ *     writeBatch: (ptr, length, messages, frames, columns, columnCount) => {
+ *       // `messages` whole protocol messages; frames points at that many
+ *       // u32 (type, offset, length) triples locating them. With
+ *       // PGLITE_COMM_COLUMN_INDEX columns points at columnCount u32
+ *       // (offset, length) pairs, one per DataRow field; otherwise both are 0
+ *       // Return number of bytes processed
  *     }
  *   };
  *
+ * pglite_init_callbacks() looks the callbacks up once and keeps them on
+ * Module, so the trampolines call them without checking _pgliteCallbacks
+ * first. Call it again after replacing a callback.
+ *
  * This completely avoids runtime WASM compilation.
  */
 
+#if defined(PGLITE_COMM_COLUMN_INDEX) && !defined(PGLITE_COMM_BATCHED)
+#error "PGLITE_COMM_COLUMN_INDEX needs PGLITE_COMM_BATCHED"
+#endif
+
+#ifdef PGLITE_COMM_BATCHED
+#define PGLITE_COMM_BATCHED_FLAG 1
+#else
+#define PGLITE_COMM_BATCHED_FLAG 0
+#endif
+
+#ifdef __EMSCRIPTEN__
+
 /**
  * EM_JS trampoline for reading data from JavaScript.
  * Called by recv() when PostgreSQL needs input data.
  */
 EM_JS(ssize_t, pglite_read_trampoline, (void* buffer, size_t max_length), {
-    // Check if callbacks are set up
-    if (!Module._pgliteCallbacks || !Module._pgliteCallbacks.read) {
-        // No callback registered - this shouldn't happen in normal operation
-        console.error('pglite_read_trampoline: no read callback registered');
-        return 0;  // Return 0 bytes read (EOF-like behavior)
-    }
-
-    // Call the JavaScript read callback
     try {
-        return Module._pgliteCallbacks.read(buffer, max_length);
+        return Module._pgliteRead(buffer, max_length);
     } catch (e) {
         console.error('pglite_read_trampoline error:', e);
         return -1;  // Return error
     }
 });
 
+#ifdef PGLITE_COMM_BATCHED
+
 /**
- * EM_JS trampoline for writing data to JavaScript.
- * Called by send() when PostgreSQL has output data.
+ * EM_JS trampoline for handing a batch of output to JavaScript.
+ * Called once per flush of the staging buffer.
  */
-EM_JS(ssize_t, pglite_write_trampoline, (const void* buffer, size_t length), {
-    if (!Module._pgliteCallbacks || !Module._pgliteCallbacks.write) {
-        console.error('pglite_write_trampoline: no write callback registered');
+EM_JS(ssize_t, pglite_write_batch_trampoline,
+      (const void* buffer, size_t length, uint32_t messages, const void* frames,
+       const void* columns, uint32_t column_count), {
+    try {
+        return Module._pgliteWriteBatch(buffer, length, messages, frames,
+                                        columns, column_count);
+    } catch (e) {
+        console.error('pglite_write_batch_trampoline error:', e);
         return -1;
     }
+});
 
+#else
+
+/**
+ * EM_JS trampoline for writing data to JavaScript.
+ * Called by send() when PostgreSQL has output data.
+ */
+EM_JS(ssize_t, pglite_write_trampoline, (const void* buffer, size_t length), {
     try {
-        return Module._pgliteCallbacks.write(buffer, length);
+        return Module._pgliteWrite(buffer, length);
     } catch (e) {
         console.error('pglite_write_trampoline error:', e);
         return -1;
     }
 });
 
+#endif // PGLITE_COMM_BATCHED
+
 /**
- * Initialize the callback storage.
- * Called once during module initialization.
+ * Copy the registered callbacks onto Module for the trampolines, creating
+ * the callback storage if JS has not. A missing callback is replaced by
+ * one that reports it, so the trampolines never need to check.
+ * Returns 1 if every callback this build uses is registered.
  */
-EM_JS(void, pglite_init_callbacks, (void), {
-    if (!Module._pgliteCallbacks) {
-        Module._pgliteCallbacks = {
+EM_JS(int, pglite_cache_callbacks, (int batched), {
+    var callbacks = Module._pgliteCallbacks;
+    if (!callbacks) {
+        callbacks = Module._pgliteCallbacks = {
             read: null,
-            write: null
+            write: null,
+            writeBatch: null
+        };
+    }
+
+    function missing(name, result) {
+        return function() {
+            console.error('pglite trampoline: no ' + name + ' callback registered');
+            return result;
         };
-        // console.log('PGlite callback storage initialized');
     }
+
+    // No read callback reads as EOF, as before
+    Module._pgliteRead = callbacks.read || missing('read', 0);
+    Module._pgliteWrite = callbacks.write || missing('write', -1);
+    Module._pgliteWriteBatch = callbacks.writeBatch || missing('writeBatch', -1);
+    return callbacks.read && (batched ? callbacks.writeBatch : callbacks.write)
+        ? 1 : 0;
 });
 
+#else
+
+/* Native builds: the host side is plain C */
+ssize_t pglite_read_trampoline(void *buffer, size_t max_length);
+#ifdef PGLITE_COMM_BATCHED
+ssize_t pglite_write_batch_trampoline(const void *buffer, size_t length,
+                                      uint32_t messages, const void *frames,
+                                      const void *columns,
+                                      uint32_t column_count);
+#else
+ssize_t pglite_write_trampoline(const void *buffer, size_t length);
+#endif
+int pglite_cache_callbacks(int batched);
+
+#endif // __EMSCRIPTEN__
+
+static int pglite_callbacks_cached = 0;
+static int pglite_callbacks_registered = 0;
+
+/**
+ * Look up and cache the JS callbacks.
+ * JS calls this once after filling in Module._pgliteCallbacks; a host that
+ * never calls it gets its callbacks cached on the first recv() or send().
+ * Returns 1 if every callback this build uses is registered.
+ */
+PGLITE_EXPORT(pglite_init_callbacks)
+int pglite_init_callbacks(void) {
+    pglite_callbacks_registered =
+        pglite_cache_callbacks(PGLITE_COMM_BATCHED_FLAG);
+    pglite_callbacks_cached = 1;
+    return pglite_callbacks_registered;
+}
+
 /**
  * Export function for JavaScript to check if callbacks are set.
- * Useful for debugging.
+ * Reflects the last pglite_init_callbacks(). Useful for debugging.
  */
-__attribute__((export_name("pglite_callbacks_ready")))
+PGLITE_EXPORT(pglite_callbacks_ready)
 int pglite_callbacks_ready(void) {
-    // This will be called from JS, so we use EM_JS to check
-    // For now, just return 1 (assume ready after init)
-    return 1;
+    return pglite_callbacks_registered;
 }
 
+/*
+ * ============================================================================
+ * COMM STATS - compile with -DPGLITE_COMM_STATS
+ * ============================================================================
+ *
+ * Counts what crosses the socket layer so query latency can be split
+ * between the executor and the JS boundary. JS resets the block before
+ * each _interactive_one and reads it afterwards through
+ * pglite_get_comm_stats(); the layout is shared by all comm variants.
+ *
+ * Timing uses emscripten_get_now(), itself a host call, so host_time_ms
+ * slightly overstates the boundary cost. Builds without the flag pay
+ * nothing.
+ */
+
+#ifdef PGLITE_COMM_STATS
+
+#define PGLITE_STATS_BUCKETS 32
+
+/**
+ * 296 bytes, no padding: u32 counters at 0, doubles at 16, histograms at
+ * 40 (recv) and 168 (send). Histogram bucket i counts transfers of
+ * [2^i, 2^(i+1)) bytes; empty transfers land in bucket 0.
+ */
+typedef struct {
+    uint32_t recv_calls;
+    uint32_t send_calls;
+    uint32_t short_reads;   // recv() returned less than it was asked for
+    uint32_t host_calls;
+    double recv_bytes;
+    double send_bytes;
+    double host_time_ms;    // cumulative time inside host callbacks
+    uint32_t recv_size_log2[PGLITE_STATS_BUCKETS];
+    uint32_t send_size_log2[PGLITE_STATS_BUCKETS];
+} pglite_comm_stats_t;
+
+static pglite_comm_stats_t pglite_comm_stats;
+
+PGLITE_EXPORT(pglite_get_comm_stats)
+pglite_comm_stats_t *pglite_get_comm_stats(void) {
+    return &pglite_comm_stats;
+}
+
+PGLITE_EXPORT(pglite_reset_comm_stats)
+void pglite_reset_comm_stats(void) {
+    memset(&pglite_comm_stats, 0, sizeof(pglite_comm_stats));
+}
+
+static inline double pglite_stats_now(void) {
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#endif
+}
+
+static inline uint32_t pglite_stats_bucket(size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t bucket = 63 - __builtin_clzll((unsigned long long)n);
+    return bucket < PGLITE_STATS_BUCKETS ? bucket : PGLITE_STATS_BUCKETS - 1;
+}
+
+static inline void pglite_stats_recv(size_t asked, ssize_t got) {
+    size_t n = got > 0 ? (size_t)got : 0;
+    pglite_comm_stats.recv_calls++;
+    pglite_comm_stats.recv_bytes += n;
+    pglite_comm_stats.short_reads += n < asked;
+    pglite_comm_stats.recv_size_log2[pglite_stats_bucket(n)]++;
+}
+
+static inline void pglite_stats_send(size_t n) {
+    pglite_comm_stats.send_calls++;
+    pglite_comm_stats.send_bytes += n;
+    pglite_comm_stats.send_size_log2[pglite_stats_bucket(n)]++;
+}
+
+#define PGLITE_STATS_RECV(asked, got) pglite_stats_recv((asked), (got))
+#define PGLITE_STATS_SEND(n) pglite_stats_send(n)
+#define PGLITE_STATS_HOST_BEGIN() \
+    double pglite_stats_start = pglite_stats_now(); \
+    pglite_comm_stats.host_calls++
+#define PGLITE_STATS_HOST_END() \
+    pglite_comm_stats.host_time_ms += pglite_stats_now() - pglite_stats_start
+
+#else
+
+#define PGLITE_STATS_RECV(asked, got) ((void)0)
+#define PGLITE_STATS_SEND(n) ((void)0)
+#define PGLITE_STATS_HOST_BEGIN() ((void)0)
+#define PGLITE_STATS_HOST_END() ((void)0)
+
+#endif /* PGLITE_COMM_STATS */
+
+/**
+ * Host calls go through these so stats builds can time them
+ */
+static ssize_t pglite_host_read(void *buffer, size_t max_length) {
+    if (!pglite_callbacks_cached) {
+        pglite_init_callbacks();
+    }
+    PGLITE_STATS_HOST_BEGIN();
+    ssize_t got = pglite_read_trampoline(buffer, max_length);
+    PGLITE_STATS_HOST_END();
+    return got;
+}
+
+#ifdef PGLITE_COMM_BATCHED
+
+static ssize_t pglite_host_write_batch(const void *buffer, size_t length,
+                                       uint32_t messages, const void *frames,
+                                       const void *columns,
+                                       uint32_t column_count) {
+    if (!pglite_callbacks_cached) {
+        pglite_init_callbacks();
+    }
+    PGLITE_STATS_HOST_BEGIN();
+    ssize_t wrote = pglite_write_batch_trampoline(buffer, length, messages,
+                                                 frames, columns, column_count);
+    PGLITE_STATS_HOST_END();
+    return wrote;
+}
+
+/* Arena spills are not framed; JS parses the arena bytes itself */
+static inline ssize_t pglite_host_write(const void *buffer, size_t length) {
+    return pglite_host_write_batch(buffer, length, 0, NULL, NULL, 0);
+}
+
+#else
+
+static ssize_t pglite_host_write(const void *buffer, size_t length) {
+    if (!pglite_callbacks_cached) {
+        pglite_init_callbacks();
+    }
+    PGLITE_STATS_HOST_BEGIN();
+    ssize_t wrote = pglite_write_trampoline(buffer, length);
+    PGLITE_STATS_HOST_END();
+    return wrote;
+}
+
+#endif // PGLITE_COMM_BATCHED
+
+/*
+ * ============================================================================
+ * OUTPUT ARENA - Zero-copy result handoff
+ * ============================================================================
+ *
+ * Without an arena every send() crosses into JS, which views the bytes with
+ * HEAPU8.subarray and then copies them into its own growing buffer. With an
+ * arena registered, send() only appends to a fixed region of WASM memory;
+ * after _interactive_one returns JS parses that region in place and copies
+ * out just the bytes the caller keeps.
+ *
+ * A result larger than the arena spills: the full arena is handed to the
+ * write callback exactly like a regular send() and then reused, so JS sees
+ * the same byte stream either way.
+ */
+
+static uint8_t *pglite_output_arena = NULL;
+static size_t pglite_output_arena_capacity = 0;
+static size_t pglite_output_arena_used = 0;
+
+/**
+ * Allocate (or reuse) the output arena and turn arena mode on.
+ * Returns the arena pointer, or 0 if the allocation failed.
+ * Calling it again with a size that fits the current arena is a no-op, so
+ * it is safe after a memory snapshot restore.
+ */
+PGLITE_EXPORT(pglite_alloc_output_arena)
+void *pglite_alloc_output_arena(size_t capacity) {
+    if (pglite_output_arena && capacity <= pglite_output_arena_capacity) {
+        return pglite_output_arena;
+    }
+
+    uint8_t *arena = realloc(pglite_output_arena, capacity);
+    if (!arena) {
+        return NULL;
+    }
+    pglite_output_arena = arena;
+    pglite_output_arena_capacity = capacity;
+    pglite_output_arena_used = 0;
+    return arena;
+}
+
+/**
+ * Bytes written to the arena since the last reset
+ */
+PGLITE_EXPORT(pglite_get_output_arena_used)
+size_t pglite_get_output_arena_used(void) {
+    return pglite_output_arena_used;
+}
+
+/**
+ * Mark the arena empty. JS calls this before each _interactive_one.
+ */
+PGLITE_EXPORT(pglite_reset_output_arena)
+void pglite_reset_output_arena(void) {
+    pglite_output_arena_used = 0;
+}
+
+static ssize_t pglite_arena_write(const void *buffer, size_t length) {
+    const uint8_t *src = (const uint8_t *)buffer;
+    size_t left = length;
+
+    while (left > 0) {
+        size_t space = pglite_output_arena_capacity - pglite_output_arena_used;
+        if (space == 0) {
+            // Arena full: spill it through the write callback and reuse it
+            if (pglite_host_write(pglite_output_arena,
+                                  pglite_output_arena_used) < 0) {
+                return -1;
+            }
+            pglite_output_arena_used = 0;
+            continue;
+        }
+
+        size_t n = left < space ? left : space;
+        memcpy(pglite_output_arena + pglite_output_arena_used, src, n);
+        pglite_output_arena_used += n;
+        src += n;
+        left -= n;
+    }
+    return (ssize_t)length;
+}
+
+#ifdef PGLITE_COMM_BATCHED
+/*
+ * ============================================================================
+ * BATCHED OUTPUT - One trampoline call per flush, whole messages only
+ * ============================================================================
+ *
+ * pqcomm flushes its send buffer with one send() per chunk, and small-row
+ * queries usually produce a handful of them per response. Instead of a JS
+ * call for each, send() copies them into a staging buffer in WASM memory.
+ * Only complete protocol messages are ever handed over, together with a
+ * frame table locating each one, so the JS parser indexes messages directly
+ * instead of stitching fragments back together. The completed messages go
+ * to the writeBatch callback when:
+ *
+ *   - a ReadyForQuery message completes (the response is done),
+ *   - the staging buffer is full,
+ *   - recv() is about to ask JS for input (COPY FROM needs the host to
+ *     see CopyInResponse first), or
+ *   - JS calls pglite_flush_output().
+ *
+ * A fragment over half the staging buffer is not copied when nothing is
+ * half-staged: the whole messages in it go to JS in place, framed where they
+ * lie. An unfinished message stays staged for the next batch. One larger
+ * than the staging buffer grows it to fit; the buffer drops back to
+ * PGLITE_STAGING_SIZE once that message has been handed over.
+ *
+ * With PGLITE_COMM_COLUMN_INDEX every DataRow framed is also indexed: one
+ * (offset, length) pair per field, in row order, offsets relative to the
+ * batch like the frames and length 0xFFFFFFFF for NULL. JS reads it as an
+ * Int32Array, so NULL shows up as -1 exactly as on the wire.
+ */
+
+#ifndef PGLITE_STAGING_SIZE
+#define PGLITE_STAGING_SIZE (64 * 1024)
+#endif
+
+/**
+ * One frame table entry: the message type, where the message starts in the
+ * batch and its full size including the type byte.
+ */
+typedef struct {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t length;
+} pglite_frame_t;
+
+static uint8_t *pglite_staging_buf = NULL;
+static size_t pglite_staging_capacity = 0;
+static size_t pglite_staging_used = 0;
+static size_t pglite_staging_complete = 0;   // end of the last whole message
+
+static pglite_frame_t *pglite_frames = NULL;
+static uint32_t pglite_frames_capacity = 0;
+static uint32_t pglite_frames_count = 0;
+
+static int pglite_staging_reserve(size_t capacity) {
+    if (capacity <= pglite_staging_capacity) {
+        return 0;
+    }
+    uint8_t *buf = realloc(pglite_staging_buf, capacity);
+    if (!buf) {
+        return -1;
+    }
+    pglite_staging_buf = buf;
+    pglite_staging_capacity = capacity;
+    return 0;
+}
+
+#ifdef PGLITE_COMM_COLUMN_INDEX
+static uint32_t *pglite_columns = NULL;
+static uint32_t pglite_columns_capacity = 0;   // in pairs
+static uint32_t pglite_columns_count = 0;      // in pairs
+#define PGLITE_COLUMNS pglite_columns
+#define PGLITE_COLUMNS_COUNT pglite_columns_count
+#else
+#define PGLITE_COLUMNS NULL
+#define PGLITE_COLUMNS_COUNT 0
+#endif
+
+static int pglite_frames_push(uint8_t type, size_t offset, size_t length) {
+    if (pglite_frames_count == pglite_frames_capacity) {
+        uint32_t capacity =
+            pglite_frames_capacity ? pglite_frames_capacity * 2 : 1024;
+        pglite_frame_t *frames =
+            realloc(pglite_frames, capacity * sizeof(pglite_frame_t));
+        if (!frames) {
+            return -1;
+        }
+        pglite_frames = frames;
+        pglite_frames_capacity = capacity;
+    }
+    pglite_frame_t *frame = &pglite_frames[pglite_frames_count++];
+    frame->type = type;
+    frame->offset = (uint32_t)offset;
+    frame->length = (uint32_t)length;
+    return 0;
+}
+
+#ifdef PGLITE_COMM_COLUMN_INDEX
+static inline uint32_t pglite_read_u32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/**
+ * Index the fields of the whole DataRow at bytes[at, at + size).
+ * Adds one pair per declared field, so JS steps through the index by field
+ * count, except for a row too short to hold that many length words, which
+ * gets none; JS makes the same check. A field whose length runs past the
+ * row reads as NULL. Returns -1 if the index could not grow.
+ */
+static int pglite_columns_index(const uint8_t *bytes, size_t at, size_t size) {
+    if (size < 7) {
+        return 0;
+    }
+    const uint8_t *m = bytes + at;
+    uint32_t fields = ((uint32_t)m[5] << 8) | (uint32_t)m[6];
+    if (fields > (size - 7) / 4) {
+        return 0;
+    }
+
+    if (pglite_columns_capacity - pglite_columns_count < fields) {
+        uint32_t capacity = pglite_columns_capacity ? pglite_columns_capacity : 4096;
+        while (capacity - pglite_columns_count < fields) {
+            capacity *= 2;
+        }
+        uint32_t *columns =
+            realloc(pglite_columns, (size_t)capacity * 2 * sizeof(uint32_t));
+        if (!columns) {
+            return -1;
+        }
+        pglite_columns = columns;
+        pglite_columns_capacity = capacity;
+    }
+
+    uint32_t *pair = pglite_columns + (size_t)pglite_columns_count * 2;
+    size_t p = 7;
+    for (uint32_t i = 0; i < fields; i++, pair += 2) {
+        uint32_t len = size - p >= 4 ? pglite_read_u32(m + p) : UINT32_MAX;
+        p = size - p >= 4 ? p + 4 : size;
+        if (len != UINT32_MAX && len > size - p) {
+            len = UINT32_MAX;
+            p = size;
+        }
+        pair[0] = (uint32_t)(at + p);
+        pair[1] = len;
+        if (len != UINT32_MAX) {
+            p += len;
+        }
+    }
+    pglite_columns_count += fields;
+    return 0;
+}
+#endif // PGLITE_COMM_COLUMN_INDEX
+
+/* Full size of the message starting at bytes[at], 0 if its header is not
+ * all before end */
+static size_t pglite_message_size(const uint8_t *bytes, size_t at,
+                                  size_t end) {
+    if (end - at < 5) {
+        return 0;
+    }
+    const uint8_t *m = bytes + at;
+    // The length counts itself but not the type byte
+    uint32_t len = ((uint32_t)m[1] << 24) | ((uint32_t)m[2] << 16) |
+                   ((uint32_t)m[3] << 8) | (uint32_t)m[4];
+    return 1 + (len > 4 ? len : 4);
+}
+
+/**
+ * Add every whole message in bytes[at, end) to the frame table, setting
+ * *ready if one of them was ReadyForQuery.
+ * Returns where the first unfinished message starts, or (size_t)-1 if the
+ * table could not grow.
+ */
+static size_t pglite_frame_scan(const uint8_t *bytes, size_t at, size_t end,
+                                int *ready) {
+    for (;;) {
+        size_t size = pglite_message_size(bytes, at, end);
+        if (size == 0 || end - at < size) {
+            return at;
+        }
+        if (pglite_frames_push(bytes[at], at, size) < 0) {
+            return (size_t)-1;
+        }
+#ifdef PGLITE_COMM_COLUMN_INDEX
+        if (bytes[at] == 'D' && pglite_columns_index(bytes, at, size) < 0) {
+            return (size_t)-1;
+        }
+#endif
+        *ready |= bytes[at] == 'Z';
+        at += size;
+    }
+}
+
+/**
+ * Hand every complete staged message to JavaScript, with its frame table.
+ * Returns the byte count reported by the writeBatch callback, 0 if nothing
+ * was pending.
+ */
+PGLITE_EXPORT(pglite_flush_output)
+ssize_t pglite_flush_output(void) {
+    size_t length = pglite_staging_complete;
+    if (length == 0) {
+        return 0;
+    }
+
+    ssize_t wrote = pglite_host_write_batch(pglite_staging_buf, length,
+                                            pglite_frames_count,
+                                            pglite_frames, PGLITE_COLUMNS,
+                                            PGLITE_COLUMNS_COUNT);
+
+    // Keep the unfinished message, if any, for the next batch
+    size_t tail = pglite_staging_used - length;
+    memmove(pglite_staging_buf, pglite_staging_buf + length, tail);
+    pglite_staging_used = tail;
+    pglite_staging_complete = 0;
+    pglite_frames_count = 0;
+#ifdef PGLITE_COMM_COLUMN_INDEX
+    pglite_columns_count = 0;
+#endif
+
+    if (tail == 0 && pglite_staging_capacity > PGLITE_STAGING_SIZE) {
+        uint8_t *buf = realloc(pglite_staging_buf, PGLITE_STAGING_SIZE);
+        if (buf) {
+            pglite_staging_buf = buf;
+            pglite_staging_capacity = PGLITE_STAGING_SIZE;
+        }
+    }
+    return wrote;
+}
+
+static ssize_t pglite_staging_write(const void *buffer, size_t length) {
+    const uint8_t *src = (const uint8_t *)buffer;
+    size_t left = length;
+    int ready = 0;
+
+    if (pglite_staging_reserve(PGLITE_STAGING_SIZE) < 0) {
+        return -1;
+    }
+
+    while (left > 0) {
+        if (left > PGLITE_STAGING_SIZE / 2 &&
+            pglite_staging_complete == pglite_staging_used) {
+            // Large fragment starting on a message boundary: what is staged
+            // goes first, then the whole messages in it without a copy
+            if (pglite_flush_output() < 0) {
+                return -1;
+            }
+            size_t whole = pglite_frame_scan(src, 0, left, &ready);
+            if (whole == (size_t)-1) {
+                return -1;
+            }
+            if (whole > 0) {
+                uint32_t messages = pglite_frames_count;
+                uint32_t columns = PGLITE_COLUMNS_COUNT;
+                pglite_frames_count = 0;
+#ifdef PGLITE_COMM_COLUMN_INDEX
+                pglite_columns_count = 0;
+#endif
+                if (pglite_host_write_batch(src, whole, messages,
+                                            pglite_frames, PGLITE_COLUMNS,
+                                            columns) < 0) {
+                    return -1;
+                }
+                src += whole;
+                left -= whole;
+                if (left == 0) {
+                    break;
+                }
+            }
+            if (left > pglite_staging_capacity) {
+                // Stage the unfinished tail; its header may not be here yet
+                size_t size = pglite_message_size(src, 0, left);
+                if (pglite_staging_reserve(size > left ? size : left) < 0) {
+                    return -1;
+                }
+            }
+        }
+
+        size_t space = pglite_staging_capacity - pglite_staging_used;
+        if (space == 0) {
+            if (pglite_staging_complete > 0) {
+                if (pglite_flush_output() < 0) {
+                    return -1;
+                }
+                continue;
+            }
+            // A single message bigger than the buffer: grow to fit it
+            size_t size = pglite_message_size(pglite_staging_buf, 0,
+                                              pglite_staging_used);
+            size_t capacity = pglite_staging_capacity * 2;
+            if (pglite_staging_reserve(size > capacity ? size : capacity) < 0) {
+                return -1;
+            }
+            continue;
+        }
+
+        size_t n = left < space ? left : space;
+        memcpy(pglite_staging_buf + pglite_staging_used, src, n);
+        pglite_staging_used += n;
+        src += n;
+        left -= n;
+
+        size_t complete = pglite_frame_scan(pglite_staging_buf,
+                                            pglite_staging_complete,
+                                            pglite_staging_used, &ready);
+        if (complete == (size_t)-1) {
+            return -1;
+        }
+        pglite_staging_complete = complete;
+    }
+
+    if (ready && pglite_flush_output() < 0) {
+        return -1;
+    }
+    return (ssize_t)length;
+}
+#endif // PGLITE_COMM_BATCHED
+
+/*
+ * Transport entry points: what recv()/send() do, callable on their own
+ */
+
+static inline ssize_t pglite_trampoline_recv(void *buf, size_t n) {
+#ifdef PGLITE_COMM_BATCHED
+    // The host may be waiting on output we are still holding
+    pglite_flush_output();
+#endif
+
+    // Use trampoline instead of function pointer
+    ssize_t got = pglite_host_read(buf, n);
+    PGLITE_STATS_RECV(n, got);
+    return got;
+}
+
+static inline ssize_t pglite_trampoline_send(const void *buf, size_t n) {
+    PGLITE_STATS_SEND(n);
+
+    if (pglite_output_arena) {
+        return pglite_arena_write(buf, n);
+    }
+
+#ifdef PGLITE_COMM_BATCHED
+    return pglite_staging_write(buf, n);
+#else
+    // Use trampoline instead of function pointer
+    return pglite_host_write(buf, n);
+#endif
+}
+
+#ifndef PGLITE_COMM_TRANSPORT_ONLY
+
 /*
  * Dummy socket functions (unchanged from original)
  */
@@ -147,16 +843,12 @@ int EMSCRIPTEN_KEEPALIVE getsockname(int __fd, struct sockaddr * __addr,
 
 ssize_t EMSCRIPTEN_KEEPALIVE
 recv(int __fd, void *__buf, size_t __n, int __flags) {
-    // Use trampoline instead of function pointer
-    ssize_t got = pglite_read_trampoline(__buf, __n);
-    return got;
+    return pglite_trampoline_recv(__buf, __n);
 }
 
 ssize_t EMSCRIPTEN_KEEPALIVE
 send(int __fd, const void *__buf, size_t __n, int __flags) {
-    // Use trampoline instead of function pointer
-    ssize_t wrote = pglite_write_trampoline(__buf, __n);
-    return wrote;
+    return pglite_trampoline_send(__buf, __n);
 }
 
 int EMSCRIPTEN_KEEPALIVE
@@ -175,6 +867,8 @@ poll(struct pollfd fds[], ssize_t nfds, int timeout) {
     return nfds;
 }
 
+#endif // PGLITE_COMM_TRANSPORT_ONLY
+
 /*
  * ============================================================================
  * BACKWARD COMPATIBILITY LAYER
@@ -198,7 +892,7 @@ typedef ssize_t (*pglite_write_t)(void *buffer, size_t length);
  * This function is still exported so existing JS code doesn't break,
  * but it does nothing. The JS code should instead set Module._pgliteCallbacks.
  */
-__attribute__((export_name("set_read_write_cbs")))
+PGLITE_EXPORT(set_read_write_cbs)
 void set_read_write_cbs(pglite_read_t read_cb, pglite_write_t write_cb) {
     // No-op in trampoline mode
     // Callbacks are set via Module._pgliteCallbacks in JavaScript
@@ -206,6 +900,6 @@ void set_read_write_cbs(pglite_read_t read_cb, pglite_write_t write_cb) {
     (void)write_cb;
 }
 
-#endif // PGLITE_COMM_H
+#endif // PGLITE_COMM_TRAMPOLINE_H
 
-#endif // __EMSCRIPTEN__
+#endif // __EMSCRIPTEN__ || PGLITE_COMM_NATIVE
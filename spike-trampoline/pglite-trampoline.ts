@@ -21,6 +21,19 @@ export interface PostgresModTrampoline extends Omit<PostgresMod, 'addFunction' |
   _pgliteCallbacks?: {
     read: ((ptr: number, maxLength: number) => number) | null;
     write: ((ptr: number, length: number) => number) | null;
+    // Used instead of write by -DPGLITE_COMM_BATCHED builds
+    // Whole messages, located by `messages` (type, offset, length) u32
+    // triples at `frames`
+    writeBatch?:
+      | ((
+          ptr: number,
+          length: number,
+          messages: number,
+          frames: number,
+          columns: number,
+          columnCount: number,
+        ) => number)
+      | null;
   };
 
   // wasmTable for v1 approach
@@ -29,8 +42,58 @@ export interface PostgresModTrampoline extends Omit<PostgresMod, 'addFunction' |
   // Trampoline init function (from EM_JS)
   _pglite_trampoline_init?: () => void;
 
+  // Caches the callbacks for pglite-comm-trampoline.h; returns 1 if all
+  // the callbacks that build uses are registered
+  _pglite_init_callbacks?: () => number;
+
+  // Only in builds with -DPGLITE_COMM_BATCHED
+  _pglite_flush_output?: () => number;
+
   // Optional: for v1 approach with explicit slot assignment
   _set_trampoline_callbacks?: (readFptr: number, writeFptr: number) => void;
+
+  // Only in builds with -DPGLITE_COMM_STATS
+  _pglite_get_comm_stats?: () => number;
+  _pglite_reset_comm_stats?: () => void;
+}
+
+/**
+ * Decoded pglite_comm_stats_t (see COMM STATS in pglite-comm-trampoline.h).
+ * Histogram bucket i counts transfers of [2^i, 2^(i+1)) bytes.
+ */
+export interface CommStats {
+  recvCalls: number;
+  sendCalls: number;
+  shortReads: number;
+  hostCalls: number;
+  recvBytes: number;
+  sendBytes: number;
+  hostTimeMs: number;
+  recvSizeLog2: number[];
+  sendSizeLog2: number[];
+}
+
+const STATS_BUCKETS = 32;
+
+/**
+ * Read the comm stats block at `ptr` (from _pglite_get_comm_stats).
+ */
+export function readCommStats(heap: Uint8Array, ptr: number): CommStats {
+  const view = new DataView(heap.buffer, heap.byteOffset + ptr, 296);
+  const histogram = (offset: number) =>
+    Array.from({ length: STATS_BUCKETS }, (_, i) => view.getUint32(offset + i * 4, true));
+
+  return {
+    recvCalls: view.getUint32(0, true),
+    sendCalls: view.getUint32(4, true),
+    shortReads: view.getUint32(8, true),
+    hostCalls: view.getUint32(12, true),
+    recvBytes: view.getFloat64(16, true),
+    sendBytes: view.getFloat64(24, true),
+    hostTimeMs: view.getFloat64(32, true),
+    recvSizeLog2: histogram(40),
+    sendSizeLog2: histogram(40 + STATS_BUCKETS * 4),
+  };
 }
 
 /**
@@ -76,6 +139,14 @@ export class PGliteTrampolineWrapper {
       return this.handleWrite(ptr, length);
     };
 
+    // Batched builds hand over whole staged batches instead
+    this.mod._pgliteCallbacks.writeBatch = (ptr: number, length: number): number => {
+      return this.handleWrite(ptr, length);
+    };
+
+    // The C side looks the callbacks up once, so this has to come last
+    this.mod._pglite_init_callbacks?.();
+
     console.log('PGlite trampoline callbacks initialized (no addFunction used)');
   }
 
@@ -131,10 +202,14 @@ export class PGliteTrampolineWrapper {
     this.readOffset = 0;
     this.outputData = message;
     this.writeChunks = [];
+    this.mod._pglite_reset_comm_stats?.();
 
     // Execute the message
     (this.mod as any)._interactive_one(message.length, message[0]);
 
+    // Batched builds may still hold output that didn't end in ReadyForQuery
+    this.mod._pglite_flush_output?.();
+
     // Combine all write chunks
     const totalLength = this.writeChunks.reduce((sum, chunk) => sum + chunk.length, 0);
     const result = new Uint8Array(totalLength);
@@ -148,6 +223,17 @@ export class PGliteTrampolineWrapper {
     return result;
   }
 
+  /**
+   * Stats for the last execProtocolRawSync, or null if the module was built
+   * without -DPGLITE_COMM_STATS.
+   */
+  getCommStats(): CommStats | null {
+    if (!this.mod._pglite_get_comm_stats) {
+      return null;
+    }
+    return readCommStats(this.mod.HEAPU8, this.mod._pglite_get_comm_stats());
+  }
+
   /**
    * Cleanup - no removeFunction calls needed!
    */
@@ -155,6 +241,8 @@ export class PGliteTrampolineWrapper {
     if (this.mod._pgliteCallbacks) {
       this.mod._pgliteCallbacks.read = null;
       this.mod._pgliteCallbacks.write = null;
+      this.mod._pgliteCallbacks.writeBatch = null;
+      this.mod._pglite_init_callbacks?.();
     }
     console.log('PGlite trampoline callbacks cleaned up');
   }
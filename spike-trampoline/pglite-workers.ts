@@ -38,11 +38,24 @@ export interface PostgresModWorkers {
   HEAPU8: Uint8Array;
   HEAP8: Int8Array;
   HEAPU32: Uint32Array;
+  HEAP32: Int32Array;
 
-  // The EM_JS callbacks are stored here (set by pglite_init_callbacks)
+  // The EM_JS callbacks are stored here (cached by pglite_init_callbacks)
   _pgliteCallbacks?: {
     read: ((ptr: number, maxLength: number) => number) | null;
     write: ((ptr: number, length: number) => number) | null;
+    // Used instead of write by -DPGLITE_COMM_BATCHED builds; columns and
+    // columnCount are 0 unless built with -DPGLITE_COMM_COLUMN_INDEX
+    writeBatch?:
+      | ((
+          ptr: number,
+          length: number,
+          messages: number,
+          frames: number,
+          columns: number,
+          columnCount: number,
+        ) => number)
+      | null;
   };
 
   // Core exported functions
@@ -51,8 +64,12 @@ export interface PostgresModWorkers {
   _pgl_shutdown: () => void;
   _interactive_one: (length: number, peek: number) => void;
 
-  // Trampoline init (from EM_JS in pglite-comm-trampoline.h)
-  _pglite_init_callbacks?: () => void;
+  // Caches the callbacks (pglite-comm-trampoline.h); returns 1 if all the
+  // callbacks that build uses are registered
+  _pglite_init_callbacks?: () => number;
+
+  // Only in builds with -DPGLITE_COMM_BATCHED
+  _pglite_flush_output?: () => number;
 
   // Legacy function (no-op in trampoline mode)
   _set_read_write_cbs?: (read_cb: number, write_cb: number) => void;
@@ -103,11 +120,6 @@ export class PGliteWorkers {
    * This replaces the addFunction-based initialization.
    */
   async init(): Promise<void> {
-    // Initialize the callback storage (EM_JS function from C)
-    if (this.mod._pglite_init_callbacks) {
-      this.mod._pglite_init_callbacks();
-    }
-
     // Ensure callback storage exists
     if (!this.mod._pgliteCallbacks) {
       this.mod._pgliteCallbacks = { read: null, write: null };
@@ -125,8 +137,23 @@ export class PGliteWorkers {
       return this.handleRead(ptr, maxLength);
     };
 
+    // Batched builds hand over one staged batch of whole messages per
+    // flush instead of calling write for every send()
+    this.mod._pgliteCallbacks.writeBatch = (
+      ptr: number,
+      length: number,
+      messages: number,
+      frames: number,
+      columns: number,
+      columnCount: number,
+    ): number => {
+      return this.handleWriteBatch(ptr, length, messages, frames, columns, columnCount);
+    };
+
     // NOTE: We don't call _set_read_write_cbs because the trampoline version
-    // of pglite-comm.h directly uses Module._pgliteCallbacks
+    // of pglite-comm.h directly uses Module._pgliteCallbacks. It looks them
+    // up once, here, so this has to come after they are all set.
+    this.mod._pglite_init_callbacks?.();
 
     console.log('[PGliteWorkers] Trampoline callbacks initialized (no addFunction used)');
 
@@ -160,7 +187,49 @@ export class PGliteWorkers {
       this.parseMessage(msg);
     });
 
-    // Store raw response
+    return this.storeOutput(bytes);
+  }
+
+  /**
+   * Handle a batch from a -DPGLITE_COMM_BATCHED build: whole messages, with
+   * a frame table of (type, offset, length) triples at `frames`, so they are
+   * parsed where they lie instead of being reassembled. Arena spills come
+   * without a table and take the regular path. With a column index the rows
+   * are decoded lazily, a field at a time.
+   */
+  private handleWriteBatch(
+    ptr: number,
+    length: number,
+    messages: number,
+    frames: number,
+    columns: number,
+    columnCount: number,
+  ): number {
+    if (!frames) {
+      return this.handleWrite(ptr, length);
+    }
+
+    const bytes = this.mod.HEAPU8.subarray(ptr, ptr + length);
+    const table = this.mod.HEAPU32.subarray(frames >> 2, (frames >> 2) + messages * 3);
+    const index = columns
+      ? this.mod.HEAP32.subarray(columns >> 2, (columns >> 2) + columnCount * 2)
+      : undefined;
+    this.protocolParser.parseFrames(
+      bytes,
+      table,
+      (msg) => {
+        this.parseMessage(msg);
+      },
+      index,
+    );
+
+    return this.storeOutput(bytes);
+  }
+
+  /**
+   * Append raw output to the response buffer
+   */
+  private storeOutput(bytes: Uint8Array): number {
     const copied = bytes.slice();
     let requiredSize = this.writeOffset + copied.length;
 
@@ -235,6 +304,9 @@ export class PGliteWorkers {
     // Execute the message
     this.mod._interactive_one(message.length, message[0]);
 
+    // Batched builds may still hold output that didn't end in ReadyForQuery
+    this.mod._pglite_flush_output?.();
+
     this.outputData = new Uint8Array(0);
 
     if (this.writeOffset) {
@@ -312,6 +384,8 @@ export class PGliteWorkers {
       if (this.mod._pgliteCallbacks) {
         this.mod._pgliteCallbacks.read = null;
         this.mod._pgliteCallbacks.write = null;
+        this.mod._pgliteCallbacks.writeBatch = null;
+        this.mod._pglite_init_callbacks?.();
       }
     } catch (e) {
       const err = e as { name: string; status: number };